@@ -15,7 +15,10 @@ public class Client : ModuleRules {
         PrivateDependencyModuleNames.AddRange(new string[] { });
 
         PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "ThirdParty", "spdlog", "include"));
-        PublicAdditionalLibraries.Add(Path.Combine(ModuleDirectory, "ThirdParty", "spdlog", "lib", "spdlog.lib"));
+        if (Target.Platform == UnrealTargetPlatform.Win64)
+        {
+            PublicAdditionalLibraries.Add(Path.Combine(ModuleDirectory, "ThirdParty", "spdlog", "lib", "spdlog.lib"));
+        }
         PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "ThirdParty", "gsl-lite", "include"));
 
         // Uncomment if you are using Slate UI
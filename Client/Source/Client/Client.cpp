@@ -1,6 +1,12 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Client.h"
-#include "Modules/ModuleManager.h"
+#include "Client/Server/SpaceLog.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Client, "Client" );
+void FClientModule::ShutdownModule()
+{
+    // the messages still queued are written and the thread is joined before the module gets unloaded
+    spacemma::SpaceLog::shutdown();
+}
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FClientModule, Client, "Client" );
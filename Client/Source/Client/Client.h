@@ -3,4 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+/**
+ * The game module. Stops the background logging thread once the module shuts down, which unlike the game instance
+ * happens only once per process, so that the log stays asynchronous across play sessions in the editor.
+ */
+class FClientModule final : public FDefaultGameModuleImpl
+{
+public:
+    virtual void ShutdownModule() override;
+};
 
@@ -1,7 +1,10 @@
 #include "GameClient.h"
-#include "Client/Server/WinThread.h"
+#include "Client/Server/PlatformThread.h"
+#include "Client/Server/StreamReassembler.h"
 #include "Client/Shared/Packets.h"
+#if PLATFORM_WINDOWS
 #include "Client/Server/WinTCPClient.h"
+#endif
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Client/SpaceMMAInstance.h"
@@ -37,12 +40,19 @@ bool AGameClient::startConnecting()
     std::lock_guard lock(connectionMutex);
     if (connectThread || tcpClient)
     {
-        SPACEMMA_WARN("Attempted to start connecting while connecting or when client was already created!");
+        SPACEMMA_CATEGORY_WARN(Client, "Attempted to start connecting while connecting or when client was already created!");
         return false;
     }
+#if PLATFORM_WINDOWS
     bufferPool = std::make_unique<BufferPool>(1024 * 1024 * 1024);
     tcpClient = std::make_unique<WinTCPClient>(*bufferPool);
-    connectThread = new WinThread();
+    playoutClock = std::make_unique<PlayoutClock>(MinPlayoutDelay, MaxPlayoutDelay);
+#else
+    SPACEMMA_CATEGORY_ERROR(Client, "The game client is not supported on this platform!");
+    return false;
+#endif
+    connectThread = new PlatformThread();
+    connectThread->setName("cl-connect");
     connectThread->run(threadConnect, this);
     return true;
 }
@@ -71,10 +81,10 @@ bool AGameClient::isConnectedAndIdentified()
 bool AGameClient::closeConnection()
 {
     std::lock_guard lock(connectionMutex);
-    SPACEMMA_DEBUG("Closing connection...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Closing connection...");
     if (connectThread)
     {
-        SPACEMMA_DEBUG("Joining connectThread...");
+        SPACEMMA_CATEGORY_DEBUG(Client, "Joining connectThread...");
         connectThread->interrupt();
         connectThread->join();
         delete connectThread;
@@ -84,17 +94,18 @@ bool AGameClient::closeConnection()
     {
         if (sendThread)
         {
-            SPACEMMA_DEBUG("Interrupting sendThread...");
+            SPACEMMA_CATEGORY_DEBUG(Client, "Interrupting sendThread...");
             sendThread->interrupt();
+            sendSignal.notify();
         }
         if (receiveThread)
         {
-            SPACEMMA_DEBUG("Interrupting receiveThread...");
+            SPACEMMA_CATEGORY_DEBUG(Client, "Interrupting receiveThread...");
             receiveThread->interrupt();
         }
-        SPACEMMA_DEBUG("Closing tcpClient...");
+        SPACEMMA_CATEGORY_DEBUG(Client, "Closing tcpClient...");
         tcpClient->close();
-        SPACEMMA_DEBUG("Joining threads...");
+        SPACEMMA_CATEGORY_DEBUG(Client, "Joining threads...");
         if (sendThread)
         {
             sendThread->join();
@@ -105,11 +116,30 @@ bool AGameClient::closeConnection()
             receiveThread->join();
             delete receiveThread;
         }
-        SPACEMMA_DEBUG("Resetting tcpClient...");
+        SPACEMMA_CATEGORY_DEBUG(Client, "Removing queued packets...");
+        ByteBuffer* packet;
+        while (receivedPackets.pop(packet))
+        {
+            bufferPool->freeBuffer(packet);
+        }
+        while (toSendPackets.pop(packet))
+        {
+            bufferPool->freeBuffer(packet);
+        }
+        SPACEMMA_CATEGORY_DEBUG(Client, "Resetting tcpClient...");
         tcpClient.reset();
-        SPACEMMA_DEBUG("Resetting bufferPool...");
+        SPACEMMA_CATEGORY_DEBUG(Client, "Resetting bufferPool...");
         bufferPool.reset();
         otherPlayers.clear();
+        interpolationBuffers.clear();
+        playoutClock.reset();
+        movementPredictor.reset();
+        movementPredicted = false;
+        packetBacklog = 0;
+        movementBaselines.clear();
+        movementSequence = 0;
+        ackedMovementSequence = 0;
+        movementResync = false;
         playerId = 0;
         return true;
     }
@@ -120,7 +150,11 @@ void AGameClient::shoot(FVector shootingPosition)
 {
     if (isConnectedAndIdentified())
     {
-        sendPacket(C2S_Shoot{ C2S_HShoot, {}, playerId, shootingPosition, ClientPawn->GetActorRotation() });
+        // the other players are rendered in the past, the server rewinds them to judge the shot
+        const uint32_t renderTime = playoutClock->isSynchronized()
+            ? static_cast<uint32_t>(static_cast<uint64_t>(std::max(playoutClock->getRenderTime(FPlatformTime::Seconds()), 0.0) * 1000.0))
+            : 0U;
+        sendPacket(C2S_Shoot{ C2S_HShoot, {}, playerId, shootingPosition, ClientPawn->GetActorRotation(), renderTime });
     }
 }
 
@@ -144,7 +178,7 @@ void AGameClient::updateVelocity(FVector velocity)
 {
     if (isConnectedAndIdentified())
     {
-        sendPacket(B2B_UpdateVelocity{ B2B_HUpdateVelocity, {}, playerId, velocity });
+        sendMovementInput(MI_Velocity, velocity, ClientPawn->GetActorRotation());
     }
 }
 
@@ -152,7 +186,7 @@ void AGameClient::updateRotation()
 {
     if (isConnectedAndIdentified())
     {
-        sendPacket(B2B_Rotate{ B2B_HRotate, {}, playerId, ClientPawn->GetActorRotation() });
+        sendMovementInput(MI_Rotation, ClientPawn->GetCharacterMovement()->Velocity, ClientPawn->GetActorRotation());
     }
 }
 
@@ -169,6 +203,9 @@ void AGameClient::respawn(FVector position, FRotator rotator)
     if (isConnectedAndIdentified())
     {
         sendPacket(B2B_RespawnPlayer{ B2B_HRespawnPlayer, {}, playerId, position, rotator });
+        // the predicted locations before the teleport are no longer comparable, reconcile from a new input
+        movementPredictor.reset();
+        sendMovementInput(MI_Rotation, ClientPawn->GetCharacterMovement()->Velocity, rotator);
     }
 }
 
@@ -176,7 +213,7 @@ void AGameClient::respawn(FVector position, FRotator rotator)
 void AGameClient::threadConnect(gsl::not_null<Thread*> thread, void* client)
 {
     AGameClient* clt = reinterpret_cast<AGameClient*>(client);
-    SPACEMMA_DEBUG("Starting threadConnect...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Starting threadConnect...");
     do
     {
         if (clt->tcpClient->connect(StringCast<ANSICHAR>(*clt->ServerIpAddress).Get(), clt->ServerPort))
@@ -191,81 +228,90 @@ void AGameClient::threadConnect(gsl::not_null<Thread*> thread, void* client)
                        StringCast<ANSICHAR>(*clt->Nickname).Get()
             };
             ByteBuffer* initPacketBuff = createPacketBuffer(clt->bufferPool.get(), initPacket);
-            clt->receiveThread = new WinThread();
-            clt->sendThread = new WinThread();
+            clt->receiveThread = new PlatformThread();
+            clt->sendThread = new PlatformThread();
+            clt->receiveThread->setName("cl-recv");
+            clt->sendThread->setName("cl-send");
             clt->receiveThread->run(threadReceive, clt);
             clt->sendThread->run(threadSend, clt);
-            SPACEMMA_DEBUG("Sending C2S_InitConnection ('{}', '{}')...", initPacket.mapName, initPacket.nickname);
+            SPACEMMA_CATEGORY_DEBUG(Client, "Sending C2S_InitConnection ('{}', '{}')...", initPacket.mapName, initPacket.nickname);
             clt->tcpClient->send(initPacketBuff);
             clt->bufferPool->freeBuffer(initPacketBuff);
         } else
         {
-            SPACEMMA_ERROR("Failed to connect to server");
+            SPACEMMA_CATEGORY_ERROR(Client, "Failed to connect to server");
+            thread->sleep(CLIENT_CONNECT_RETRY_DELAY);
         }
     } while (!thread->isInterrupted() && !clt->tcpClient->isConnected());
-    SPACEMMA_DEBUG("Stopping threadConnect...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Stopping threadConnect...");
 }
 
 void AGameClient::threadReceive(gsl::not_null<Thread*> thread, void* client)
 {
     AGameClient* clt = reinterpret_cast<AGameClient*>(client);
-    SPACEMMA_DEBUG("Starting threadReceive...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Starting threadReceive...");
     do
     {
         ByteBuffer* buffer = clt->tcpClient->receive();
         if (buffer)
         {
-            std::lock_guard lock(clt->receiveMutex);
-            clt->receivedPackets.push_back(buffer);
+            if (!clt->receivedPackets.push(buffer))
+            {
+                SPACEMMA_CATEGORY_ERROR(Client, "The received packet queue is full! Dropping {} data.", buffer->getUsedSize());
+                clt->bufferPool->freeBuffer(buffer);
+            }
         } else if (!clt->tcpClient->isConnected())
         {
-            SPACEMMA_ERROR("Connection lost.");
+            SPACEMMA_CATEGORY_ERROR(Client, "Connection lost.");
             break;
         }
     } while (!thread->isInterrupted());
-    SPACEMMA_DEBUG("Stopping threadReceive...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Stopping threadReceive...");
 }
 
 void AGameClient::threadSend(gsl::not_null<Thread*> thread, void* client)
 {
     AGameClient* clt = reinterpret_cast<AGameClient*>(client);
-    ByteBuffer* toSend{ nullptr };
-    SPACEMMA_DEBUG("Starting threadSend...");
+    ByteBuffer* toSend[CLIENT_SEND_BATCH_SIZE];
+    SPACEMMA_CATEGORY_DEBUG(Client, "Starting threadSend...");
     do
     {
+        clt->sendSignal.wait([clt, thread] { return !clt->toSendPackets.isEmpty() || thread->isInterrupted(); });
+        bool connectionLost = false;
+        while (size_t count = clt->toSendPackets.popBulk(toSend))
         {
-            std::lock_guard lock(clt->sendMutex);
-            if (!clt->toSendPackets.empty())
+            for (size_t i = 0; i < count; ++i)
             {
-                toSend = clt->toSendPackets[0];
-                clt->toSendPackets.erase(clt->toSendPackets.begin());
+                if (!connectionLost && !clt->tcpClient->send(toSend[i]) && !clt->tcpClient->isConnected())
+                {
+                    connectionLost = true;
+                }
+                //SPACEMMA_CATEGORY_DEBUG(Client, "Sent packet {}!", *reinterpret_cast<uint8_t*>(toSend[i]->getPointer()));
+                clt->bufferPool->freeBuffer(toSend[i]);
             }
         }
-        if (toSend)
+        if (connectionLost)
         {
-            bool sent = clt->tcpClient->send(toSend);
-            //SPACEMMA_DEBUG("Sent packet {}!", *reinterpret_cast<uint8_t*>(toSend->getPointer()));
-            clt->bufferPool->freeBuffer(toSend);
-            if (!sent && !clt->tcpClient->isConnected())
-            {
-                SPACEMMA_ERROR("Connection lost.");
-                break;
-            }
-            toSend = nullptr;
+            SPACEMMA_CATEGORY_ERROR(Client, "Connection lost.");
+            break;
         }
     } while (!thread->isInterrupted());
-    SPACEMMA_DEBUG("Stopping threadSend...");
+    SPACEMMA_CATEGORY_DEBUG(Client, "Stopping threadSend...");
 }
 
 void AGameClient::send(gsl::not_null<ByteBuffer*> packet)
 {
-    std::lock_guard lock(sendMutex);
-    toSendPackets.push_back(packet);
+    if (!toSendPackets.push(packet))
+    {
+        SPACEMMA_CATEGORY_ERROR(Client, "The send queue is full! Dropping {} data.", packet->getUsedSize());
+        bufferPool->freeBuffer(packet);
+        return;
+    }
+    sendSignal.notify();
 }
 
-void AGameClient::processPacket(ByteBuffer* buffer)
+void AGameClient::processPacket(gsl::span<uint8_t> span)
 {
-    gsl::span<uint8_t> span = buffer->getSpan();
     size_t buffPos = 0;
     bool dataValid = true;
     do
@@ -278,7 +324,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_ProvidePlayerId* packet = reinterpretPacket<S2C_ProvidePlayerId>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_ProvidePlayerId: {}", packet->playerId);
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_ProvidePlayerId: {}", packet->playerId);
                     this->playerId = packet->playerId;
                 } else
                 {
@@ -291,7 +337,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_CreatePlayer packet;
                 if (reinterpretPacket(span, buffPos, packet))
                 {
-                    SPACEMMA_DEBUG("S2C_CreatePlayer: {}, [{},{},{}], [{},{},{}], '{}', {}, {}", packet.playerId,
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_CreatePlayer: {}, [{},{},{}], [{},{},{}], '{}', {}, {}", packet.playerId,
                                    packet.location.x, packet.location.y, packet.location.z,
                                    packet.rotator.pitch, packet.rotator.yaw, packet.rotator.roll,
                                    packet.nickname, packet.kills, packet.deaths);
@@ -299,17 +345,18 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                     FVector locVec{ packet.location.asFVector() };
                     if (packet.playerId == playerId)
                     {
-                        SPACEMMA_DEBUG("Adjusting self-position of {} (S2C_CreatePlayer)...", playerId);
+                        SPACEMMA_CATEGORY_DEBUG(Client, "Adjusting self-position of {} (S2C_CreatePlayer)...", playerId);
                         ClientPawn->SetActorLocation(locVec);
                         ClientPawn->SetActorRotation(packet.rotator.asFRotator());
                         ClientPawn->StartRound(packet.roundTime);
+                        movementPredictor.reset();
                     } else if (otherPlayers.find(packet.playerId) != otherPlayers.end())
                     {
                         valid = false;
-                        SPACEMMA_ERROR("Attempted to spawn player {} which is already up!", packet.playerId);
+                        SPACEMMA_CATEGORY_ERROR(Client, "Attempted to spawn player {} which is already up!", packet.playerId);
                     } else
                     {
-                        SPACEMMA_DEBUG("Spawning player {} ({})...", packet.playerId, playerId);
+                        SPACEMMA_CATEGORY_DEBUG(Client, "Spawning player {} ({})...", packet.playerId, playerId);
                         FActorSpawnParameters params{};
                         params.Name = FName(FString::Printf(TEXT("Player #%d"), static_cast<int32>(packet.playerId)));
                         params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
@@ -318,7 +365,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                         if (actor == nullptr)
                         {
                             valid = false;
-                            SPACEMMA_ERROR("Failed to create player {}!", packet.playerId);
+                            SPACEMMA_CATEGORY_ERROR(Client, "Failed to create player {}!", packet.playerId);
                         } else
                         {
                             actor->InitiateClientPlayer();
@@ -326,9 +373,9 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             otherPlayers.insert({ packet.playerId, {actor, packet.nickname, packet.kills, packet.deaths } });
                         }
                     }
-                    if (valid)
+                    if (valid && packet.playerId != playerId)
                     {
-                        recentPosData.emplace(packet.playerId, RecentPosData{ locVec, locVec, FVector::ZeroVector, FVector::ZeroVector, 0.0f });
+                        interpolationBuffers.try_emplace(packet.playerId);
                     }
                 } else
                 {
@@ -341,17 +388,13 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_DestroyPlayer* packet = reinterpretPacket<S2C_DestroyPlayer>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_DestroyPlayer: {}", packet->playerId);
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_DestroyPlayer: {}", packet->playerId);
                     const std::map<unsigned short, OtherPlayerData>::iterator pair = otherPlayers.find(packet->playerId);
-                    const std::map<unsigned short, RecentPosData>::iterator pair1 = recentPosData.
-                        find(packet->playerId);
-                    if (pair1 != recentPosData.end())
-                    {
-                        recentPosData.erase(pair1);
-                    }
+                    interpolationBuffers.erase(packet->playerId);
+                    movementBaselines.erase(packet->playerId);
                     if (pair != otherPlayers.end())
                     {
-                        SPACEMMA_DEBUG("Destroying player {} '{}' ({})...", packet->playerId, pair->second.nickname, playerId);
+                        SPACEMMA_CATEGORY_DEBUG(Client, "Destroying player {} '{}' ({})...", packet->playerId, pair->second.nickname, playerId);
                         pair->second.player->Destroy();
                         ClientPawn->RemovePlayerFromScoreboard(FString(pair->second.nickname.c_str()));
                         otherPlayers.erase(pair);
@@ -367,7 +410,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_Damage* packet = reinterpretPacket<S2C_Damage>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_Damage: {}, {}",
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_Damage: {}, {}",
                                    packet->playerId, packet->damage);
                     if (packet->playerId == playerId)
                     {
@@ -385,7 +428,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_EnemyReceivedDamage* packet = reinterpretPacket<S2C_EnemyReceivedDamage>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_EnemyReceivedDamage");
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_EnemyReceivedDamage");
                     ClientPawn->ShowEnemyReceivedDamage();
                     break;
                 }
@@ -400,7 +443,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_Shoot* packet = reinterpretPacket<S2C_Shoot>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_Shoot: {}, {}, [{},{},{}], [{},{},{}]",
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_Shoot: {}, {}, [{},{},{}], [{},{},{}]",
                                    packet->playerId, packet->distance, packet->location.x, packet->location.y, packet->location.z,
                                    packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
                     if (packet->playerId == playerId)
@@ -414,7 +457,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                         pair->second.player->SetActorRotation(packet->rotator.asFRotator());
                     } else
                     {
-                        SPACEMMA_WARN("Unable to create shoot effect for {} ({}). Player not found!", packet->playerId, playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to create shoot effect for {} ({}). Player not found!", packet->playerId, playerId);
                     }
                 } else
                 {
@@ -427,7 +470,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_StartRound* packet = reinterpretPacket<S2C_StartRound>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("S2C_StartRound: {}",
+                    SPACEMMA_CATEGORY_DEBUG(Client, "S2C_StartRound: {}",
                                    packet->roundTime);
                     kills = 0;
                     deaths = 0;
@@ -448,7 +491,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_UpdateVelocity* packet = reinterpretPacket<B2B_UpdateVelocity>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_UpdateVelocity: {}, [{},{},{}]",
+                    SPACEMMA_CATEGORY_TRACE(Client, "B2B_UpdateVelocity: {}, [{},{},{}]",
                                    packet->playerId, packet->velocity.x, packet->velocity.y, packet->velocity.z);
                     if (packet->playerId == playerId)
                     {
@@ -461,7 +504,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             pair->second.player->GetCharacterMovement()->Velocity = packet->velocity.asFVector();
                         } else
                         {
-                            SPACEMMA_WARN("Unable to adjust velocity of {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to adjust velocity of {} ({}). Player not found!", packet->playerId, playerId);
                         }
                     }
                 } else
@@ -475,7 +518,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_Rotate* packet = reinterpretPacket<B2B_Rotate>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_Rotate: {}, [{},{},{}]", packet->playerId,
+                    SPACEMMA_CATEGORY_TRACE(Client, "B2B_Rotate: {}, [{},{},{}]", packet->playerId,
                                    packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
                     if (packet->playerId == playerId)
                     {
@@ -488,7 +531,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             pair->second.player->SetActorRotation(packet->rotator.asFRotator());
                         } else
                         {
-                            SPACEMMA_WARN("Unable to adjust rotation vector of {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to adjust rotation vector of {} ({}). Player not found!", packet->playerId, playerId);
                         }
                     }
                 } else
@@ -502,39 +545,102 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_PlayerMovement* packet = reinterpretPacket<S2C_PlayerMovement>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("S2C_PlayerMovement: {}, [{},{},{}], [{},{},{}], [{},{},{}]", packet->playerId,
+                    SPACEMMA_CATEGORY_TRACE(Client, "S2C_PlayerMovement: {}, [{},{},{}], [{},{},{}], [{},{},{}]", packet->playerId,
                                    packet->location.x, packet->location.y, packet->location.z,
                                    packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll,
                                    packet->velocity.x, packet->velocity.y, packet->velocity.z);
-                    if (packet->playerId == playerId)
+                    applyPlayerMovement(packet->playerId, packet->location.asFVector(), packet->rotator.asFRotator(),
+                                        packet->velocity.asFVector(), playoutClock->getServerTime(FPlatformTime::Seconds()));
+                } else
+                {
+                    dataValid = false;
+                }
+                break;
+            }
+            case S2C_HQuantizedPlayerMovement:
+            {
+                S2C_QuantizedPlayerMovement* packet = reinterpretPacket<S2C_QuantizedPlayerMovement>(span, buffPos);
+                if (packet)
+                {
+                    const FVector location = packet->location.asFVector(), velocity = packet->velocity.asFVector();
+                    const FRotator rotation = packet->rotator.asFRotator();
+                    SPACEMMA_CATEGORY_TRACE(Client, "S2C_QuantizedPlayerMovement: {}, [{},{},{}], [{},{},{}], [{},{},{}]", packet->playerId,
+                                   location.X, location.Y, location.Z, rotation.Pitch, rotation.Yaw, rotation.Roll,
+                                   velocity.X, velocity.Y, velocity.Z);
+                    applyPlayerMovement(packet->playerId, location, rotation, velocity,
+                                        playoutClock->getServerTime(FPlatformTime::Seconds()));
+                } else
+                {
+                    dataValid = false;
+                }
+                break;
+            }
+            case S2C_HWorldSnapshot:
+            {
+                S2C_WorldSnapshot* packet = reinterpretPacket<S2C_WorldSnapshot>(span, buffPos);
+                if (packet)
+                {
+                    SPACEMMA_CATEGORY_TRACE(Client, "S2C_WorldSnapshot: {}, {}, {}", packet->sequence, packet->serverTime, packet->playerCount);
+                    const double snapshotTime = playoutClock->onSnapshot(packet->serverTime, FPlatformTime::Seconds());
+                    if (packet->sequence)
                     {
-                        //ClientPawn->SetActorRotation(packet->rotator.asFRotator());
-                        ClientPawn->SetActorLocation(packet->location.asFVector());
-                        ClientPawn->GetCharacterMovement()->Velocity = packet->velocity.asFVector();
-                        //auto& posDelta = recentPosData[playerId];
-                        //posDelta.prevPos = ClientPawn->GetActorLocation();
-                        //posDelta.nextPos = packet->location.asFVector();
-                        //posDelta.prevVelocity = ClientPawn->GetCharacterMovement()->Velocity;
-                        //posDelta.nextVelocity = packet->velocity.asFVector();
-                        //posDelta.timePassed = 0.0f;
-                    } else
+                        // zero is skipped when the sequence wraps around
+                        const uint16_t expectedSequence = static_cast<uint16_t>(movementSequence + 1U);
+                        if (packet->sequence != (expectedSequence ? expectedSequence : 1U))
+                        {
+                            SPACEMMA_CATEGORY_WARN(Client, "Missed world snapshots between {} and {}! Requesting resync.",
+                                          movementSequence, packet->sequence);
+                            movementResync = true;
+                        }
+                        movementSequence = packet->sequence;
+                    }
+                    for (uint16_t i = 0; dataValid && i < packet->playerCount; ++i)
                     {
-                        const std::map<unsigned short, OtherPlayerData>::iterator pair = otherPlayers.find(packet->playerId);
-                        if (pair != otherPlayers.end())
+                        WorldSnapshotEntry* entry = reinterpretPacket<WorldSnapshotEntry>(span, buffPos);
+                        if (!entry)
                         {
-                            pair->second.player->SetActorRotation(packet->rotator.asFRotator());
-                            pair->second.player->SetActorLocation(packet->location.asFVector());
-                            pair->second.player->GetCharacterMovement()->Velocity = packet->velocity.asFVector();
-                            //auto& posDelta = recentPosData[packet->playerId];
-                            //posDelta.prevPos = pair->second->GetActorLocation();
-                            //posDelta.nextPos = packet->location.asFVector();
-                            //posDelta.prevVelocity = pair->second->GetCharacterMovement()->Velocity;
-                            //posDelta.nextVelocity = packet->velocity.asFVector();
-                            //posDelta.timePassed = 0.0f;
-                        } else
+                            dataValid = false;
+                            break;
+                        }
+                        if (!entry->fields)
                         {
-                            SPACEMMA_WARN("Unable to update movement of {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_TRACE(Client, "WorldSnapshotEntry: {} left the area of interest", entry->playerId);
+                            leaveInterest(entry->playerId);
+                            continue;
                         }
+                        NetQuantizedMovement& movement = movementBaselines[entry->playerId];
+                        if (!readMovementFields(span, buffPos, entry->fields, movement))
+                        {
+                            dataValid = false;
+                            break;
+                        }
+                        const FVector location = movement.location.asFVector(), velocity = movement.velocity.asFVector();
+                        const FRotator rotation = movement.rotator.asFRotator();
+                        SPACEMMA_CATEGORY_TRACE(Client, "WorldSnapshotEntry: {}, {:x}, [{},{},{}], [{},{},{}], [{},{},{}]",
+                                       entry->playerId, entry->fields, location.X, location.Y, location.Z,
+                                       rotation.Pitch, rotation.Yaw, rotation.Roll, velocity.X, velocity.Y, velocity.Z);
+                        applyPlayerMovement(entry->playerId, location, rotation, velocity, snapshotTime);
+                    }
+                } else
+                {
+                    dataValid = false;
+                }
+                break;
+            }
+            case S2C_HOwnMovement:
+            {
+                S2C_OwnMovement* packet = reinterpretPacket<S2C_OwnMovement>(span, buffPos);
+                if (packet)
+                {
+                    SPACEMMA_CATEGORY_TRACE(Client, "S2C_OwnMovement: {}, {}, [{},{},{}], [{},{},{}]", packet->inputSequence, packet->clientTime,
+                                   packet->location.x, packet->location.y, packet->location.z,
+                                   packet->velocity.x, packet->velocity.y, packet->velocity.z);
+                    const double now = FPlatformTime::Seconds();
+                    const uint32_t nowMs = static_cast<uint32_t>(static_cast<uint64_t>(now * 1000.0));
+                    const double stateTime = now - static_cast<int32_t>(nowMs - packet->clientTime) / 1000.0;
+                    if (movementPredictor.reconcile(packet->inputSequence, stateTime, packet->location.asFVector()))
+                    {
+                        movementPredicted = true;
                     }
                 } else
                 {
@@ -547,7 +653,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_RopeAttach* packet = reinterpretPacket<B2B_RopeAttach>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_RopeAttach: {}, [{},{},{}]", packet->playerId,
+                    SPACEMMA_CATEGORY_TRACE(Client, "B2B_RopeAttach: {}, [{},{},{}]", packet->playerId,
                                    packet->attachPosition.x, packet->attachPosition.y, packet->attachPosition.z);
                     if (packet->playerId == playerId)
                     {
@@ -560,7 +666,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             pair->second.player->AttachRope(packet->attachPosition.asFVector(), false);
                         } else
                         {
-                            SPACEMMA_WARN("Unable to attach rope for player {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to attach rope for player {} ({}). Player not found!", packet->playerId, playerId);
                         }
                     }
                 } else
@@ -574,7 +680,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_RopeFailed* packet = reinterpretPacket<S2C_RopeFailed>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("S2C_RopeFailed: {}, {}", packet->playerId, packet->ropeCooldown);
+                    SPACEMMA_CATEGORY_TRACE(Client, "S2C_RopeFailed: {}, {}", packet->playerId, packet->ropeCooldown);
                     if (packet->playerId == playerId)
                     {
                         ClientPawn->SetRopeCooldown(packet->ropeCooldown, false);
@@ -586,7 +692,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             pair->second.player->SetRopeCooldown(packet->ropeCooldown, false);
                         } else
                         {
-                            SPACEMMA_WARN("Unable to update rope cooldown for player {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to update rope cooldown for player {} ({}). Player not found!", packet->playerId, playerId);
                         }
                     }
                 } else
@@ -600,7 +706,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_RopeDetach* packet = reinterpretPacket<B2B_RopeDetach>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_RopeDetach: {}", packet->playerId);
+                    SPACEMMA_CATEGORY_TRACE(Client, "B2B_RopeDetach: {}", packet->playerId);
                     if (packet->playerId == playerId)
                     {
                         ClientPawn->DetachRope(false);
@@ -612,7 +718,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                             pair->second.player->DetachRope(false);
                         } else
                         {
-                            SPACEMMA_WARN("Unable to detach rope for player {} ({}). Player not found!", packet->playerId, playerId);
+                            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to detach rope for player {} ({}). Player not found!", packet->playerId, playerId);
                         }
                     }
                 } else
@@ -626,7 +732,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_DeadPlayer* packet = reinterpretPacket<B2B_DeadPlayer>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("B2B_DeadPlayer: {}",
+                    SPACEMMA_CATEGORY_DEBUG(Client, "B2B_DeadPlayer: {}",
                                    packet->playerId);
                     if (packet->playerId == playerId)
                     {
@@ -638,7 +744,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                         pair->second.player->DeadPlayer();
                     } else
                     {
-                        SPACEMMA_WARN("Unable to dead {} ({}). Player not found!", packet->playerId, playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to dead {} ({}). Player not found!", packet->playerId, playerId);
                     }
                 } else
                 {
@@ -651,7 +757,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 B2B_RespawnPlayer* packet = reinterpretPacket<B2B_RespawnPlayer>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("B2B_RespawnPlayer: {}", packet->playerId);
+                    SPACEMMA_CATEGORY_DEBUG(Client, "B2B_RespawnPlayer: {}", packet->playerId);
                     if (packet->playerId == playerId)
                     {
                         break;
@@ -659,11 +765,12 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                     const std::map<unsigned short, OtherPlayerData>::iterator pair = otherPlayers.find(packet->playerId);
                     if (pair != otherPlayers.end())
                     {
-                        recentPosData[packet->playerId] = RecentPosData{ packet->location.asFVector(), packet->location.asFVector(), FVector::ZeroVector, FVector::ZeroVector, 0.0f };
+                        // the respawned player is not interpolated from where it died
+                        interpolationBuffers[packet->playerId].clear();
                         pair->second.player->RespawnPlayer(packet->location.asFVector(), packet->rotator.asFRotator());
                     } else
                     {
-                        SPACEMMA_WARN("Unable to respawn {} ({}). Player not found!", packet->playerId, playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to respawn {} ({}). Player not found!", packet->playerId, playerId);
                     }
                 } else
                 {
@@ -676,7 +783,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_UpdateScoreboard* packet = reinterpretPacket<S2C_UpdateScoreboard>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("Game Client received: S2C_UpdateScoreboard: {}, {}", packet->killerPlayerId, packet->killedPlayerId);
+                    SPACEMMA_CATEGORY_DEBUG(Client, "Game Client received: S2C_UpdateScoreboard: {}, {}", packet->killerPlayerId, packet->killedPlayerId);
                     FString killerNickname, victimNickname;
                     if (packet->killerPlayerId == playerId)
                     {
@@ -730,7 +837,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
             }
             case S2C_HInvalidNickname:
             {
-                SPACEMMA_ERROR("S2C_InvalidNickname");
+                SPACEMMA_CATEGORY_ERROR(Client, "S2C_InvalidNickname");
                 break;
             }
             case S2C_HInvalidMap:
@@ -738,7 +845,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                 S2C_InvalidMap packet;
                 if (reinterpretPacket(span, buffPos, packet))
                 {
-                    SPACEMMA_ERROR("S2C_InvalidMap: {}, '{}'", packet.mapNameLength, packet.mapName);
+                    SPACEMMA_CATEGORY_ERROR(Client, "S2C_InvalidMap: {}, '{}'", packet.mapNameLength, packet.mapName);
                     USpaceMMAInstance* gameInstance = GetGameInstance<USpaceMMAInstance>();
                     gameInstance->ForceStartFromMenu = true;
                     gameInstance->ForceStartMapName = packet.mapName.c_str();
@@ -746,7 +853,7 @@ void AGameClient::processPacket(ByteBuffer* buffer)
                     gameInstance->ServerIpAddress = ServerIpAddress;
                     gameInstance->ServerPort = ServerPort;
                     gameInstance->Initialization = USpaceMMAInstance::LevelInitialization::None;
-                    SPACEMMA_WARN("Initialized map switching.");
+                    SPACEMMA_CATEGORY_WARN(Client, "Initialized map switching.");
                     tcpClient->close();
                 } else
                 {
@@ -756,12 +863,12 @@ void AGameClient::processPacket(ByteBuffer* buffer)
             }
             case S2C_HInvalidData:
             {
-                SPACEMMA_ERROR("S2C_InvalidData");
+                SPACEMMA_CATEGORY_ERROR(Client, "S2C_InvalidData");
                 break;
             }
             default:
             {
-                SPACEMMA_ERROR("Received invalid packet header of {}! Discarding packet.", header);
+                SPACEMMA_CATEGORY_ERROR(Client, "Received invalid packet header of {}! Discarding packet.", header);
                 dataValid = false;
                 break;
             }
@@ -769,47 +876,135 @@ void AGameClient::processPacket(ByteBuffer* buffer)
     } while (dataValid && buffPos < span.size());
 }
 
-void AGameClient::processPendingPacket()
+void AGameClient::processPendingPackets()
 {
-    ByteBuffer* packet = nullptr;
+    const double deadline = FPlatformTime::Seconds() + PacketProcessingBudget / 1000.0;
+    ByteBuffer* packets[CLIENT_RECEIVE_BATCH_SIZE];
+    do
     {
-        std::lock_guard lock(receiveMutex);
-        if (!receivedPackets.empty())
+        const size_t count = receivedPackets.popBulk(packets);
+        if (!count)
         {
-            packet = receivedPackets[0];
-            receivedPackets.erase(receivedPackets.begin());
+            break;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            gsl::span<uint8_t> frames = packets[i]->getSpan(), frame{};
+            size_t framePos = 0;
+            while (readFrame(frames, framePos, frame))
+            {
+                processPacket(frame);
+            }
+            bufferPool->freeBuffer(packets[i]);
         }
+    } while (PacketProcessingBudget <= 0.0f || FPlatformTime::Seconds() < deadline);
+    packetBacklog = receivedPackets.getSize();
+    if (packetBacklog)
+    {
+        SPACEMMA_CATEGORY_TRACE(Client, "{} received buffers left for the next tick.", packetBacklog);
     }
-    if (packet)
+}
+
+int32 AGameClient::getPacketBacklog() const
+{
+    return static_cast<int32>(packetBacklog);
+}
+
+void AGameClient::applyPlayerMovement(unsigned short movingPlayerId, const FVector& location, const FRotator& rotation,
+                                      const FVector& velocity, double serverTime)
+{
+    if (movingPlayerId == playerId)
     {
-        processPacket(packet);
-        bufferPool->freeBuffer(packet);
+        if (!movementPredicted)
+        {
+            //ClientPawn->SetActorRotation(rotation);
+            ClientPawn->SetActorLocation(location);
+            ClientPawn->GetCharacterMovement()->Velocity = velocity;
+        }
+    } else
+    {
+        const std::map<unsigned short, InterpolationBuffer>::iterator pair = interpolationBuffers.find(movingPlayerId);
+        if (pair != interpolationBuffers.end())
+        {
+            pair->second.push(serverTime, location, rotation, velocity);
+        } else
+        {
+            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to update movement of {} ({}). Player not found!", movingPlayerId, playerId);
+        }
+        const std::map<unsigned short, OtherPlayerData>::iterator player = otherPlayers.find(movingPlayerId);
+        if (player != otherPlayers.end() && player->second.outOfInterest)
+        {
+            player->second.outOfInterest = false;
+            player->second.player->SetActorHiddenInGame(false);
+        }
+    }
+}
+
+void AGameClient::leaveInterest(unsigned short otherPlayerId)
+{
+    const std::map<unsigned short, OtherPlayerData>::iterator player = otherPlayers.find(otherPlayerId);
+    if (player == otherPlayers.end())
+    {
+        SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Unable to hide player {} ({}). Player not found!", otherPlayerId, playerId);
+        return;
+    }
+    player->second.outOfInterest = true;
+    player->second.player->SetActorHiddenInGame(true);
+    // the player comes back with a full state, from which it is not interpolated to where it left
+    const std::map<unsigned short, InterpolationBuffer>::iterator pair = interpolationBuffers.find(otherPlayerId);
+    if (pair != interpolationBuffers.end())
+    {
+        pair->second.clear();
     }
 }
 
-void AGameClient::interpolateMovement(float deltaTime)
+void AGameClient::acknowledgeMovement()
 {
-    for (std::map<unsigned short, RecentPosData>::value_type& pair : recentPosData)
+    if (movementSequence != ackedMovementSequence || movementResync)
     {
-        AShooterPlayer* player = pair.first == playerId ? ClientPawn : nullptr;
-        if (!player)
+        sendPacket(C2S_AckMovement{ C2S_HAckMovement, movementResync, movementSequence });
+        ackedMovementSequence = movementSequence;
+        movementResync = false;
+    }
+}
+
+void AGameClient::sendMovementInput(uint8_t fields, const FVector& velocity, const FRotator& rotation)
+{
+    const uint32_t clientTime = static_cast<uint32_t>(static_cast<uint64_t>(FPlatformTime::Seconds() * 1000.0));
+    sendPacket(C2S_MovementInput{ C2S_HMovementInput, fields, movementPredictor.nextInputSequence(), clientTime,
+                                  velocity, rotation });
+}
+
+void AGameClient::predictMovement(float deltaTime)
+{
+    const FVector correction = movementPredictor.takeCorrection(deltaTime, CorrectionSmoothingTime, CorrectionSnapDistance);
+    if (!correction.IsZero())
+    {
+        ClientPawn->SetActorLocation(ClientPawn->GetActorLocation() + correction);
+    }
+    movementPredictor.record(FPlatformTime::Seconds(), ClientPawn->GetActorLocation());
+}
+
+void AGameClient::interpolateMovement()
+{
+    const double renderTime = playoutClock->getRenderTime(FPlatformTime::Seconds());
+    for (const std::map<unsigned short, InterpolationBuffer>::value_type& pair : interpolationBuffers)
+    {
+        FVector location, velocity;
+        FRotator rotation;
+        if (!pair.second.sample(renderTime, MaxExtrapolation, location, rotation, velocity))
         {
-            const std::map<unsigned short, OtherPlayerData>::iterator pair1 = otherPlayers.find(pair.first);
-            if (pair1 != otherPlayers.end())
-            {
-                player = pair1->second.player;
-            }
+            continue;
         }
-        if (player)
+        const std::map<unsigned short, OtherPlayerData>::iterator player = otherPlayers.find(pair.first);
+        if (player != otherPlayers.end())
         {
-            pair.second.timePassed += deltaTime;
-            FVector targetPosition = (pair.second.nextPos - pair.second.prevPos) * pair.second.timePassed * InterpolationStrength + pair.second.prevPos;
-            FVector targetVelocity = (pair.second.nextVelocity - pair.second.prevVelocity) * pair.second.timePassed * InterpolationStrength + pair.second.prevVelocity;
-            player->SetActorLocation(targetPosition * InterpolationSharpness + player->GetActorLocation() * (1.0f - InterpolationSharpness));
-            player->GetCharacterMovement()->Velocity = targetVelocity * InterpolationSharpness + player->GetCharacterMovement()->Velocity * (1.0f - InterpolationSharpness);
+            player->second.player->SetActorRotation(rotation);
+            player->second.player->SetActorLocation(location);
+            player->second.player->GetCharacterMovement()->Velocity = velocity;
         } else
         {
-            SPACEMMA_WARN("Player {} not found for movement interpolation!", pair.first);
+            SPACEMMA_CATEGORY_WARN_LIMITED(Client, "Player {} not found for movement interpolation!", pair.first);
         }
     }
 }
@@ -819,8 +1014,13 @@ void AGameClient::Tick(float DeltaTime)
     Super::Tick(DeltaTime);
     if (isConnected())
     {
-        processPendingPacket();
-        //interpolateMovement(DeltaTime);
+        processPendingPackets();
+        acknowledgeMovement();
+        if (isIdentified())
+        {
+            predictMovement(DeltaTime);
+        }
+        interpolateMovement();
     }
 }
 
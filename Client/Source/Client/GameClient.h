@@ -5,24 +5,24 @@
 #include "Client/Server/Thread.h"
 #include "Client/Server/TCPClient.h"
 #include "Client/ShooterPlayer.h"
+#include "Client/Server/InterpolationBuffer.h"
+#include "Client/Server/MovementPredictor.h"
+#include "Client/Server/PlayoutClock.h"
+#include "Client/Server/RingQueue.h"
+#include "Client/Server/WakeSignal.h"
+#include "Client/Shared/Packets.h"
 #include <map>
 #include "GameClient.generated.h"
 
+#define CLIENT_PACKET_QUEUE_CAPACITY 4096
+#define CLIENT_SEND_BATCH_SIZE 64
+#define CLIENT_RECEIVE_BATCH_SIZE 16
+/** Milliseconds between the attempts to connect to the server. */
+#define CLIENT_CONNECT_RETRY_DELAY 1000
+
 UCLASS()
 class CLIENT_API AGameClient : public AActor
 {
-    /**
-     * Contains information about current and previous location and velocity.
-     * Used for movement interpolation.
-     */
-    struct RecentPosData
-    {
-        FVector prevPos{};
-        FVector nextPos{};
-        FVector prevVelocity{};
-        FVector nextVelocity{};
-        float timePassed{};
-    };
     /**
      * Contains all importaant information about a remote player.
      */
@@ -32,6 +32,8 @@ class CLIENT_API AGameClient : public AActor
         std::string nickname{};
         unsigned int kills{ 0 };
         unsigned int deaths{ 0 };
+        // set while the player is hidden, because it left the own player's area of interest
+        bool outOfInterest{ false };
     };
 
     GENERATED_BODY()
@@ -59,6 +61,11 @@ public:
     */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Connection_Parameters)
         int32 ServerPort = 4444;
+    /**
+    * The time in milliseconds which can be spent processing received packets in a single tick. Zero means no limit.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Connection_Parameters)
+        float PacketProcessingBudget = 4.0f;
     UFUNCTION(BlueprintCallable, Category = Connection_Management)
         bool startConnecting();
     /**
@@ -87,6 +94,11 @@ public:
     UFUNCTION(BlueprintCallable, Category = Connection_Management)
         bool closeConnection();
     /**
+    * Returns the amount of received buffers left unprocessed at the end of the last tick.
+    */
+    UFUNCTION(BlueprintCallable, Category = Connection_Management)
+        int32 getPacketBacklog() const;
+    /**
     * If client is connected and identified sends packet to the server.
     * Information about shoot.
     */
@@ -139,10 +151,31 @@ protected:
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     UPROPERTY(EditDefaultsOnly, Category = Spawn_Parameters)
         TSubclassOf<AActor> PlayerBP;
+    /**
+    * Lower bound of the delay in seconds at which remote players are rendered behind the server.
+    */
+    UPROPERTY(EditDefaultsOnly, Category = Movement_Parameters)
+        float MinPlayoutDelay = 0.05f;
+    /**
+    * Upper bound of the delay in seconds at which remote players are rendered behind the server.
+    */
+    UPROPERTY(EditDefaultsOnly, Category = Movement_Parameters)
+        float MaxPlayoutDelay = 0.5f;
+    /**
+    * Maximum time in seconds for which remote players are extrapolated when no newer movement arrived.
+    */
     UPROPERTY(EditDefaultsOnly, Category = Movement_Parameters)
-        float InterpolationStrength = 1.0f;
+        float MaxExtrapolation = 0.25f;
+    /**
+    * Corrections of the own player's predicted location longer than this distance are applied at once instead of smoothed.
+    */
+    UPROPERTY(EditDefaultsOnly, Category = Movement_Parameters)
+        float CorrectionSnapDistance = 200.0f;
+    /**
+    * Time constant in seconds at which corrections of the own player's predicted location are smoothed.
+    */
     UPROPERTY(EditDefaultsOnly, Category = Movement_Parameters)
-        float InterpolationSharpness = 0.1f;
+        float CorrectionSmoothingTime = 0.1f;
 private:
     static void threadConnect(gsl::not_null<spacemma::Thread*> thread, void* client);
     static void threadReceive(gsl::not_null<spacemma::Thread*> thread, void* client);
@@ -150,17 +183,56 @@ private:
     template<typename T>
     void sendPacket(T packet);
     void send(gsl::not_null<spacemma::ByteBuffer*> packet);
-    void processPacket(spacemma::ByteBuffer* buffer);
-    void processPendingPacket();
-    void interpolateMovement(float deltaTime);
+    void processPacket(gsl::span<uint8_t> span);
+    /**
+    * Processes received buffers in batches until none are left or the processing budget of the tick is exhausted.
+    */
+    void processPendingPackets();
+    /**
+    * Sends a movement input with the given fields and records it for reconciliation.
+    */
+    void sendMovementInput(uint8_t fields, const FVector& velocity, const FRotator& rotation);
+    /**
+    * Applies the smoothed part of the pending correction to the own player and records its predicted location.
+    */
+    void predictMovement(float deltaTime);
+    /**
+    * Moves the remote players to their interpolated movement at the current render time.
+    */
+    void interpolateMovement();
+    /**
+    * Applies the movement of the player at the given server time in seconds. The own player is moved at once,
+    * remote players' movement is buffered for interpolation.
+    */
+    void applyPlayerMovement(unsigned short movingPlayerId, const FVector& location, const FRotator& rotation,
+                             const FVector& velocity, double serverTime);
+    /**
+    * Hides the remote player which left the own player's area of interest, until its movement arrives again.
+    */
+    void leaveInterest(unsigned short otherPlayerId);
+    /**
+    * Acknowledges the world snapshots applied since the last acknowledgement, requests a resync if any were missed.
+    */
+    void acknowledgeMovement();
     spacemma::Thread* sendThread{}, * receiveThread{}, * connectThread{};
-    std::mutex connectionMutex{}, receiveMutex{}, sendMutex{};
-    std::vector<spacemma::ByteBuffer*> receivedPackets{}, toSendPackets{};
+    std::mutex connectionMutex{};
+    spacemma::WakeSignal sendSignal{};
+    spacemma::SPSCRingQueue<spacemma::ByteBuffer*> receivedPackets{ CLIENT_PACKET_QUEUE_CAPACITY },
+                                                   toSendPackets{ CLIENT_PACKET_QUEUE_CAPACITY };
     std::unique_ptr<spacemma::BufferPool> bufferPool{};
     std::unique_ptr<spacemma::TCPClient> tcpClient{};
     std::map<unsigned short, OtherPlayerData> otherPlayers{};
-    std::map<unsigned short, RecentPosData> recentPosData{};
+    std::map<unsigned short, spacemma::InterpolationBuffer> interpolationBuffers{};
+    std::unique_ptr<spacemma::PlayoutClock> playoutClock{};
+    spacemma::MovementPredictor movementPredictor{};
+    // set once the server reconciles the own movement, which is then no longer taken from the other players' updates
+    bool movementPredicted{ false };
+    // the last movement of every player, to which the world snapshot entries are applied
+    std::map<unsigned short, spacemma::NetQuantizedMovement> movementBaselines{};
+    uint16_t movementSequence{ 0 }, ackedMovementSequence{ 0 };
+    bool movementResync{ false };
     unsigned short playerId{ 0 };
+    size_t packetBacklog{ 0 };
     unsigned int kills{0};
     unsigned int deaths{0};
 };
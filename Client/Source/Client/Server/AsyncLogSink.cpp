@@ -0,0 +1,198 @@
+#include "AsyncLogSink.h"
+
+#include <algorithm>
+#include <cstring>
+
+spacemma::AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity,
+                                     LogOverflowPolicy overflowPolicy)
+    : sinks(std::move(sinks)), records(capacity), overflowPolicy(overflowPolicy)
+{
+    running = true;
+    // not a PlatformThread, which logs through this very sink
+    drainThread = std::thread(&AsyncLogSink::threadDrain, this);
+}
+
+spacemma::AsyncLogSink::~AsyncLogSink()
+{
+    stop();
+}
+
+void spacemma::AsyncLogSink::log(const spdlog::details::log_msg& msg)
+{
+    if (!running.load(std::memory_order_acquire))
+    {
+        write(msg);
+        return;
+    }
+    AsyncLogRecord record;
+    record.time = msg.time;
+    record.source = msg.source;
+    record.loggerName = msg.logger_name;
+    record.threadId = msg.thread_id;
+    record.level = msg.level;
+    record.size = static_cast<uint16_t>(std::min<size_t>(msg.payload.size(), ASYNC_LOG_PAYLOAD_SIZE));
+    memcpy(record.payload, msg.payload.data(), record.size);
+    if (!records.push(record))
+    {
+        switch (overflowPolicy.load(std::memory_order_relaxed))
+        {
+            case LogOverflowPolicy::Block:
+                do
+                {
+                    recordSignal.notify();
+                    std::this_thread::yield();
+                } while (!records.push(record));
+                break;
+            case LogOverflowPolicy::DropAndCount:
+                unreportedCount.fetch_add(1, std::memory_order_relaxed);
+                [[fallthrough]];
+            case LogOverflowPolicy::Drop:
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+        }
+    }
+    recordSignal.notify();
+    if (!running.load(std::memory_order_acquire))
+    {
+        // the sink was stopped meanwhile, stop may have written the queued records before this one was pushed
+        drainStopped();
+    }
+}
+
+void spacemma::AsyncLogSink::flush()
+{
+    if (!running.load(std::memory_order_acquire))
+    {
+        flushSinks();
+        return;
+    }
+    flushRequested = true;
+    recordSignal.notify();
+}
+
+void spacemma::AsyncLogSink::set_pattern(const std::string& pattern)
+{
+    for (const spdlog::sink_ptr& sink : sinks)
+    {
+        sink->set_pattern(pattern);
+    }
+}
+
+void spacemma::AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter)
+{
+    for (const spdlog::sink_ptr& sink : sinks)
+    {
+        sink->set_formatter(sinkFormatter->clone());
+    }
+}
+
+void spacemma::AsyncLogSink::setOverflowPolicy(LogOverflowPolicy policy)
+{
+    overflowPolicy = policy;
+}
+
+spacemma::LogOverflowPolicy spacemma::AsyncLogSink::getOverflowPolicy() const
+{
+    return overflowPolicy;
+}
+
+uint64_t spacemma::AsyncLogSink::getDroppedCount() const
+{
+    return droppedCount;
+}
+
+void spacemma::AsyncLogSink::stop()
+{
+    if (!running.exchange(false))
+    {
+        return;
+    }
+    stopping = true;
+    recordSignal.notify();
+    drainThread.join();
+    std::lock_guard lock(stopMutex);
+    // the records pushed while the background thread was stopping
+    AsyncLogRecord record;
+    while (records.pop(record))
+    {
+        writeRecord(record);
+    }
+    reportDropped();
+    flushSinks();
+    drained = true;
+}
+
+void spacemma::AsyncLogSink::drainStopped()
+{
+    std::lock_guard lock(stopMutex);
+    // otherwise stop is still to write the queued records, this one included
+    if (!drained)
+    {
+        return;
+    }
+    AsyncLogRecord record;
+    while (records.pop(record))
+    {
+        writeRecord(record);
+    }
+    flushSinks();
+}
+
+void spacemma::AsyncLogSink::threadDrain()
+{
+    AsyncLogRecord record;
+    while (true)
+    {
+        recordSignal.wait([this] { return !records.isEmpty() || flushRequested || stopping; });
+        while (records.pop(record))
+        {
+            writeRecord(record);
+        }
+        reportDropped();
+        if (flushRequested.exchange(false))
+        {
+            flushSinks();
+        }
+        if (stopping)
+        {
+            break;
+        }
+    }
+}
+
+void spacemma::AsyncLogSink::writeRecord(const AsyncLogRecord& record)
+{
+    spdlog::details::log_msg msg{ record.time, record.source, record.loggerName, record.level,
+                                  spdlog::string_view_t{ record.payload, record.size } };
+    msg.thread_id = record.threadId;
+    lastLoggerName = record.loggerName;
+    write(msg);
+}
+
+void spacemma::AsyncLogSink::write(const spdlog::details::log_msg& msg)
+{
+    for (const spdlog::sink_ptr& sink : sinks)
+    {
+        if (sink->should_log(msg.level))
+        {
+            sink->log(msg);
+        }
+    }
+}
+
+void spacemma::AsyncLogSink::reportDropped()
+{
+    if (const uint64_t dropped = unreportedCount.exchange(0))
+    {
+        const std::string text = fmt::format("Dropped {} log messages, the log queue was full!", dropped);
+        write(spdlog::details::log_msg{ lastLoggerName, spdlog::level::warn, text });
+    }
+}
+
+void spacemma::AsyncLogSink::flushSinks()
+{
+    for (const spdlog::sink_ptr& sink : sinks)
+    {
+        sink->flush();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RingQueue.h"
+#include "SpaceLog.h"
+#include "WakeSignal.h"
+
+#include <spdlog/sinks/sink.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Messages longer than this amount of characters are truncated in asynchronous log records. */
+#define ASYNC_LOG_PAYLOAD_SIZE 480
+
+namespace spacemma
+{
+    /**
+     * A log message copied out of the logging thread, so that it can be written by the background thread.
+     */
+    struct AsyncLogRecord
+    {
+        spdlog::log_clock::time_point time{};
+        spdlog::source_loc source{};
+        spdlog::string_view_t loggerName{};
+        size_t threadId{ 0 };
+        spdlog::level::level_enum level{ spdlog::level::off };
+        uint16_t size{ 0 };
+        char payload[ASYNC_LOG_PAYLOAD_SIZE];
+    };
+
+    /**
+     * A sink handing the log messages over to a background thread, which writes them to the wrapped sinks.
+     * The records are passed through a lock-free ring allocated once with the given capacity, so that logging
+     * costs the calling thread the formatting of the message and a copy, but never a write to a file or the console.
+     * Once the ring is full, the overflow policy decides whether the calling thread waits or the message is dropped.
+     * After stop the messages are written by the calling thread again.
+     */
+    class AsyncLogSink final : public spdlog::sinks::sink
+    {
+    public:
+        AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity, LogOverflowPolicy overflowPolicy);
+        ~AsyncLogSink();
+        AsyncLogSink(AsyncLogSink&) = delete;
+        AsyncLogSink(AsyncLogSink&&) = delete;
+        AsyncLogSink& operator=(AsyncLogSink&) = delete;
+        AsyncLogSink& operator=(AsyncLogSink&&) = delete;
+        void log(const spdlog::details::log_msg& msg) override;
+        /**
+         * Requests the background thread to flush the wrapped sinks once it wrote the queued records. Does not wait for it.
+         */
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+        void setOverflowPolicy(LogOverflowPolicy policy);
+        LogOverflowPolicy getOverflowPolicy() const;
+        /**
+         * Returns the amount of messages dropped since the sink was created.
+         */
+        uint64_t getDroppedCount() const;
+        /**
+         * Writes all queued records, flushes the wrapped sinks and stops the background thread.
+         */
+        void stop();
+    private:
+        void threadDrain();
+        /**
+         * Writes the records pushed after stop wrote the queued ones, if it did already.
+         */
+        void drainStopped();
+        void writeRecord(const AsyncLogRecord& record);
+        void write(const spdlog::details::log_msg& msg);
+        /**
+         * Logs the amount of messages dropped by DropAndCount since the last report, if there are any.
+         */
+        void reportDropped();
+        void flushSinks();
+        std::vector<spdlog::sink_ptr> sinks;
+        MPSCRingQueue<AsyncLogRecord> records;
+        WakeSignal recordSignal{};
+        std::atomic<LogOverflowPolicy> overflowPolicy;
+        std::atomic<uint64_t> droppedCount{ 0 }, unreportedCount{ 0 };
+        std::atomic_bool running{ false }, stopping{ false }, flushRequested{ false };
+        // the name of the logger of the last written record, used by the drop reports
+        spdlog::string_view_t lastLoggerName{};
+        std::thread drainThread{};
+        // serializes the writes of the queued records once the background thread is joined
+        std::mutex stopMutex{};
+        // set under stopMutex once stop wrote the records queued by then
+        bool drained{ false };
+    };
+}
@@ -0,0 +1,75 @@
+#include "BandwidthScheduler.h"
+#include "ClientSlotAllocator.h"
+
+#include <algorithm>
+#include <limits>
+
+spacemma::BandwidthScheduler::BandwidthScheduler(unsigned char slotCount, float bytesPerSecond, size_t minBurst)
+    : slotCount(slotCount), bytesPerSecond(bytesPerSecond),
+      burstBytes(std::max(bytesPerSecond * BANDWIDTH_BURST_SECONDS, static_cast<float>(minBurst)))
+{
+    tokens.resize(slotCount, burstBytes);
+    priorities.resize(static_cast<size_t>(slotCount) * slotCount, 0.0f);
+}
+
+void spacemma::BandwidthScheduler::resetReceiver(unsigned char receiverSlot)
+{
+    tokens[receiverSlot] = burstBytes;
+    std::fill_n(priorities.begin() + receiverSlot * slotCount, slotCount, 0.0f);
+}
+
+void spacemma::BandwidthScheduler::resetSubject(unsigned char subjectSlot)
+{
+    for (size_t receiverSlot = 0; receiverSlot < slotCount; ++receiverSlot)
+    {
+        priorities[receiverSlot * slotCount + subjectSlot] = 0.0f;
+    }
+}
+
+void spacemma::BandwidthScheduler::refill(float deltaTime)
+{
+    const float amount = bytesPerSecond * deltaTime;
+    for (float& bucket : tokens)
+    {
+        bucket = std::min(bucket + amount, burstBytes);
+    }
+}
+
+size_t spacemma::BandwidthScheduler::getAvailableBytes(unsigned char receiverSlot, size_t queuedBytes) const
+{
+    if (bytesPerSecond <= 0.0f)
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+    const size_t available = static_cast<size_t>(tokens[receiverSlot]);
+    return available > queuedBytes ? available - queuedBytes : 0U;
+}
+
+void spacemma::BandwidthScheduler::consume(unsigned char receiverSlot, size_t bytes)
+{
+    tokens[receiverSlot] = std::max(tokens[receiverSlot] - static_cast<float>(bytes), 0.0f);
+}
+
+void spacemma::BandwidthScheduler::accumulate(unsigned char receiverSlot, unsigned char subjectSlot, float weight)
+{
+    priorities[receiverSlot * slotCount + subjectSlot] += weight;
+}
+
+bool spacemma::BandwidthScheduler::isPending(unsigned char receiverSlot, unsigned char subjectSlot) const
+{
+    return priorities[receiverSlot * slotCount + subjectSlot] > 0.0f;
+}
+
+void spacemma::BandwidthScheduler::prioritize(unsigned char receiverSlot, std::vector<unsigned short>& subjects) const
+{
+    const float* receiverPriorities = &priorities[receiverSlot * slotCount];
+    std::sort(subjects.begin(), subjects.end(), [receiverPriorities](unsigned short a, unsigned short b)
+    {
+        return receiverPriorities[getClientSlot(a)] > receiverPriorities[getClientSlot(b)];
+    });
+}
+
+void spacemma::BandwidthScheduler::markSent(unsigned char receiverSlot, unsigned char subjectSlot)
+{
+    priorities[receiverSlot * slotCount + subjectSlot] = 0.0f;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The budget of a client may accumulate for at most this amount of seconds while nothing is sent.
+ */
+#define BANDWIDTH_BURST_SECONDS 0.5f
+
+namespace spacemma
+{
+    /**
+     * Schedules the movement updates sent to every client within its bandwidth budget.
+     * Every receiving client has a token bucket refilled at the configured amount of bytes per second, from which
+     * the data still waiting in its send queue is subtracted, so that a slow client gets less instead of its queue growing.
+     * Every pair of receiver and subject slot has a priority accumulator, which grows by a weight every tick
+     * the subject waits to be sent and is cleared once it is sent, so that the most stale and relevant updates
+     * are sent first and none is starved. Used only by the game thread.
+     */
+    class BandwidthScheduler final
+    {
+    public:
+        /**
+         * Creates the scheduler with the budget in bytes per second, zero disables the budget.
+         * The bucket of a client holds at least minBurst bytes, so that the largest single update always fits eventually.
+         */
+        BandwidthScheduler(unsigned char slotCount, float bytesPerSecond, size_t minBurst);
+        ~BandwidthScheduler() = default;
+        BandwidthScheduler(BandwidthScheduler&) = delete;
+        BandwidthScheduler(BandwidthScheduler&&) = delete;
+        BandwidthScheduler& operator=(BandwidthScheduler&) = delete;
+        BandwidthScheduler& operator=(BandwidthScheduler&&) = delete;
+        /**
+         * Fills the bucket of the receiver and clears all of its priorities.
+         */
+        void resetReceiver(unsigned char receiverSlot);
+        /**
+         * Clears the priorities of the subject for all receivers.
+         */
+        void resetSubject(unsigned char subjectSlot);
+        /**
+         * Refills the buckets of all receivers for the elapsed time in seconds.
+         */
+        void refill(float deltaTime);
+        /**
+         * Returns the amount of bytes which can be sent to the receiver, given the amount of bytes still waiting in its queue.
+         */
+        size_t getAvailableBytes(unsigned char receiverSlot, size_t queuedBytes) const;
+        /**
+         * Takes the sent bytes from the bucket of the receiver.
+         */
+        void consume(unsigned char receiverSlot, size_t bytes);
+        /**
+         * Raises the priority of the subject for the receiver by the weight.
+         */
+        void accumulate(unsigned char receiverSlot, unsigned char subjectSlot, float weight);
+        /**
+         * Returns true if the subject is waiting to be sent to the receiver, false otherwise.
+         */
+        bool isPending(unsigned char receiverSlot, unsigned char subjectSlot) const;
+        /**
+         * Sorts the subjects (client IDs) by their priority for the receiver, the highest first.
+         */
+        void prioritize(unsigned char receiverSlot, std::vector<unsigned short>& subjects) const;
+        /**
+         * Clears the priority of the subject for the receiver.
+         */
+        void markSent(unsigned char receiverSlot, unsigned char subjectSlot);
+    private:
+        size_t slotCount;
+        float bytesPerSecond;
+        float burstBytes;
+        std::vector<float> tokens{};
+        // indexed by receiverSlot * slotCount + subjectSlot
+        std::vector<float> priorities{};
+    };
+}
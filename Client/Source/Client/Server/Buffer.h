@@ -2,10 +2,14 @@
 
 #include <gsl/gsl-lite.hpp>
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 
 namespace spacemma
 {
+    class BufferPool;
+
     /**
      * A template class representing a data buffer.
      */
@@ -56,9 +60,33 @@ namespace spacemma
          */
         template <typename U>
         gsl::span<U> getSpan() const;
+        /**
+         * Sets the amount of references held to this buffer.
+         */
+        void setReferenceCount(uint32_t count);
+        /**
+         * Adds the given amount of references to this buffer.
+         */
+        void addReferences(uint32_t count);
+        /**
+         * Removes a single reference to this buffer and stores the amount of remaining references in remaining.
+         * Returns false without changing the references if the buffer holds none, true otherwise.
+         */
+        bool releaseReference(uint32_t& remaining);
+        /**
+         * Returns the pool owning this buffer or null pointer if the buffer is not pooled.
+         */
+        BufferPool* getPool() const;
     private:
+        friend class BufferPool;
         T* data;
         size_t size, byteSize, usedSize;
+        std::atomic<uint32_t> references{ 0U };
+        // intrusive bookkeeping of the owning pool
+        BufferPool* pool{ nullptr };
+        size_t poolIndex{ 0ULL };
+        uint8_t sizeClass{ 0U };
+        bool pooledAndUsed{ false };
     };
 
     template <typename T>
@@ -131,5 +159,39 @@ namespace spacemma
         return gsl::make_span<U>(reinterpret_cast<U*>(data), usedSize * sizeof(T) / sizeof(U));
     }
 
+    template <typename T>
+    void Buffer<T>::setReferenceCount(uint32_t count)
+    {
+        references.store(count, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    void Buffer<T>::addReferences(uint32_t count)
+    {
+        references.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    bool Buffer<T>::releaseReference(uint32_t& remaining)
+    {
+        uint32_t previous = references.load(std::memory_order_relaxed);
+        do
+        {
+            if (!previous)
+            {
+                return false;
+            }
+        } while (!references.compare_exchange_weak(previous, previous - 1U, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed));
+        remaining = previous - 1U;
+        return true;
+    }
+
+    template <typename T>
+    BufferPool* Buffer<T>::getPool() const
+    {
+        return pool;
+    }
+
     using ByteBuffer = Buffer<uint8_t>;
 }
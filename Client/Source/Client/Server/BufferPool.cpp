@@ -1,73 +1,145 @@
 #include "BufferPool.h"
 #include "SpaceLog.h"
 
+#include <algorithm>
 #include <mutex>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+std::mutex spacemma::BufferPool::threadCacheMutex{};
 
 spacemma::BufferPool::BufferPool(size_t maxSize) : maxSize(maxSize)
 {
-    SPACEMMA_DEBUG("Initialized BufferPool of size {}!", maxSize);
+    SPACEMMA_CATEGORY_DEBUG(Pool, "Initialized BufferPool of size {}!", maxSize);
 }
 
 spacemma::BufferPool::~BufferPool()
 {
+    {
+        std::lock_guard cacheLock(threadCacheMutex);
+        for (ThreadCache* cache : threadCaches)
+        {
+            // cached buffers are deleted below together with all other buffers
+            cache->pool = nullptr;
+            for (std::vector<ByteBuffer*>& buffers : cache->buffers)
+            {
+                buffers.clear();
+            }
+        }
+        threadCaches.clear();
+    }
     std::lock_guard lock(mutex);
-    SPACEMMA_DEBUG("Clearing buffer pool. {} UB,{} FB,{} US,{} FS,{} TS", usedBuffers.size(), freeBuffers.size(),
-                   usedSize, getFreeSize(), byteSize);
-    if (usedBuffers.size())
+    SPACEMMA_CATEGORY_DEBUG(Pool, "Clearing buffer pool. {} UB,{} FB,{} US,{} FS,{} TS", usedCount.load(), allBuffers.size() - usedCount,
+                   usedSize.load(), byteSize - usedSize, byteSize);
+    if (usedCount)
+    {
+        SPACEMMA_CATEGORY_WARN(Pool, "The buffer pool contains buffers that are currently in use!");
+    }
+    while (!allBuffers.empty())
     {
-        SPACEMMA_WARN("The buffer pool contains buffers that are currently in use!");
+        deleteBuffer(allBuffers.back());
     }
-    for (ByteBuffer* buff : usedBuffers)
+    for (std::vector<ByteBuffer*>& buffers : freeBuffers)
     {
-        freeBuffer(buff);
+        buffers.clear();
     }
-    flushUnused();
 }
 
 spacemma::ByteBuffer* spacemma::BufferPool::getBuffer(size_t size)
 {
-    std::lock_guard lock(mutex);
-    for (std::vector<ByteBuffer*>::iterator it = freeBuffers.begin(); it != freeBuffers.end(); ++it)
+    const uint8_t sizeClass = getSizeClass(size);
+    if (sizeClass >= BUFFER_POOL_SIZE_CLASSES)
     {
-        if ((*it)->getTotalSize() < size)
-        {
-            continue;
-        }
-        ByteBuffer* buff = *it;
-        buff->setUsedSize(size);
-        freeBuffers.erase(it);
-        addUsed(buff);
-        SPACEMMA_TRACE("Reusing buffer {:x} of size {} for desired size {}.", reinterpret_cast<uintptr_t>(buff),
-                       buff->getTotalByteSize(), size);
-        return buff;
+        SPACEMMA_CATEGORY_ERROR(Pool, "Unable to provide a buffer of size {} (the largest size class is {})!", size,
+                       getClassSize(BUFFER_POOL_SIZE_CLASSES - 1));
+        return nullptr;
     }
-    ByteBuffer* buff = addBuffer(size, false);
-    if (!buff)
+    ThreadCache& cache = getThreadCache();
+    std::vector<ByteBuffer*>& cachedBuffers = cache.buffers[sizeClass];
+    ByteBuffer* buff;
+    if (!cachedBuffers.empty() || refillCache(cache, sizeClass))
     {
-        return nullptr;
+        buff = cachedBuffers.back();
+        cachedBuffers.pop_back();
+        SPACEMMA_CATEGORY_TRACE(Pool, "Reusing buffer {:x} of size {} for desired size {}.", reinterpret_cast<uintptr_t>(buff),
+                       buff->getTotalByteSize(), size);
+    } else
+    {
+        std::lock_guard lock(mutex);
+        buff = acquireBuffer(sizeClass);
+        if (!buff)
+        {
+            return nullptr;
+        }
     }
-    addUsed(buff);
+    buff->setUsedSize(size);
+    buff->setReferenceCount(1U);
+    buff->pooledAndUsed = true;
+    usedSize += buff->getTotalSize();
+    ++usedCount;
     return buff;
 }
 
+void spacemma::BufferPool::retainBuffer(gsl::not_null<ByteBuffer*> buffer, uint32_t count)
+{
+    buffer->addReferences(count);
+}
+
 bool spacemma::BufferPool::freeBuffer(gsl::not_null<ByteBuffer*> buffer)
 {
-    return freeBuffer(buffer, false);
+    uint32_t remaining;
+    if (!releaseReference(buffer, remaining))
+    {
+        return false;
+    }
+    if (remaining)
+    {
+        return true;
+    }
+    if (!releaseBuffer(buffer))
+    {
+        return false;
+    }
+    ThreadCache& cache = getThreadCache();
+    std::vector<ByteBuffer*>& cachedBuffers = cache.buffers[buffer->sizeClass];
+    cachedBuffers.push_back(buffer);
+    if (cachedBuffers.size() > 2 * BUFFER_POOL_MAGAZINE_SIZE)
+    {
+        flushCache(cache, buffer->sizeClass, BUFFER_POOL_MAGAZINE_SIZE);
+    }
+    return true;
 }
 
 bool spacemma::BufferPool::freeAndRemoveBuffer(gsl::not_null<ByteBuffer*> buffer)
 {
-    return freeBuffer(buffer, true);
+    uint32_t remaining;
+    if (!releaseReference(buffer, remaining))
+    {
+        return false;
+    }
+    if (remaining)
+    {
+        return true;
+    }
+    if (!releaseBuffer(buffer))
+    {
+        return false;
+    }
+    std::lock_guard lock(mutex);
+    deleteBuffer(buffer);
+    return true;
 }
 
 void spacemma::BufferPool::flushUnused()
 {
-    std::lock_guard lock(mutex);
-    for (std::vector<ByteBuffer*>::iterator it = freeBuffers.begin(); it != freeBuffers.end(); ++it)
+    ThreadCache& cache = getThreadCache();
+    for (uint8_t sizeClass = 0; sizeClass < BUFFER_POOL_SIZE_CLASSES; ++sizeClass)
     {
-        deleteBuffer(*it, false);
+        flushCache(cache, sizeClass, cache.buffers[sizeClass].size());
     }
-    freeBuffers.clear();
+    std::lock_guard lock(mutex);
+    flushUnusedBuffers();
 }
 
 size_t spacemma::BufferPool::getTotalSize() const
@@ -78,7 +150,6 @@ size_t spacemma::BufferPool::getTotalSize() const
 
 size_t spacemma::BufferPool::getUsedSize() const
 {
-    std::lock_guard lock(mutex);
     return usedSize;
 }
 
@@ -99,89 +170,208 @@ size_t spacemma::BufferPool::getMaxSize() const
     return maxSize;
 }
 
-bool spacemma::BufferPool::freeBuffer(gsl::not_null<ByteBuffer*> buffer, bool remove)
+uint8_t spacemma::BufferPool::getSizeClass(size_t size)
 {
-    std::lock_guard lock(mutex);
-    SPACEMMA_TRACE("Freeing buffer {:x} of size {} ({}).", reinterpret_cast<uintptr_t>(buffer),
-                   buffer->getTotalByteSize(), remove);
-    std::vector<ByteBuffer*>::iterator it = std::find(usedBuffers.begin(), usedBuffers.end(), buffer);
-    if (it == usedBuffers.end())
+    if (size <= getClassSize(0U))
     {
-        return false;
+        return 0U;
     }
-    usedBuffers.erase(it);
-    usedSize -= buffer->getTotalSize();
-    if (remove)
+    // the class size is the smallest power of two not less than size
+#if defined(_MSC_VER)
+    unsigned long highestBit;
+    _BitScanReverse64(&highestBit, size - 1ULL);
+    const unsigned bits = highestBit + 1U;
+#else
+    const unsigned bits = 64U - static_cast<unsigned>(__builtin_clzll(size - 1ULL));
+#endif
+    return static_cast<uint8_t>(bits - BUFFER_POOL_MIN_CLASS_SHIFT);
+}
+
+size_t spacemma::BufferPool::getClassSize(uint8_t sizeClass)
+{
+    return 1ULL << (sizeClass + BUFFER_POOL_MIN_CLASS_SHIFT);
+}
+
+spacemma::BufferPool::ThreadCacheList::~ThreadCacheList()
+{
+    std::lock_guard cacheLock(threadCacheMutex);
+    for (ThreadCache* cache : caches)
     {
-        deleteBuffer(buffer, false);
-    } else
+        if (BufferPool* pool = cache->pool.load())
+        {
+            std::lock_guard lock(pool->mutex);
+            for (uint8_t sizeClass = 0; sizeClass < BUFFER_POOL_SIZE_CLASSES; ++sizeClass)
+            {
+                std::vector<ByteBuffer*>& freeBuffers = pool->freeBuffers[sizeClass];
+                freeBuffers.insert(freeBuffers.end(), cache->buffers[sizeClass].begin(), cache->buffers[sizeClass].end());
+            }
+            pool->threadCaches.erase(std::find(pool->threadCaches.begin(), pool->threadCaches.end(), cache));
+        }
+        delete cache;
+    }
+}
+
+spacemma::BufferPool::ThreadCache& spacemma::BufferPool::getThreadCache()
+{
+    thread_local ThreadCacheList cacheList{};
+    if (cacheList.lastUsed && cacheList.lastUsed->pool.load(std::memory_order_relaxed) == this)
     {
-        addToFreeBuffers(buffer);
+        return *cacheList.lastUsed;
     }
-    return true;
+    for (ThreadCache* cache : cacheList.caches)
+    {
+        if (cache->pool.load(std::memory_order_relaxed) == this)
+        {
+            cacheList.lastUsed = cache;
+            return *cache;
+        }
+    }
+    std::lock_guard cacheLock(threadCacheMutex);
+    ThreadCache* result = nullptr;
+    // caches left behind by destroyed pools are reused
+    for (ThreadCache* cache : cacheList.caches)
+    {
+        if (!cache->pool.load())
+        {
+            result = cache;
+            break;
+        }
+    }
+    if (!result)
+    {
+        result = new ThreadCache{};
+        cacheList.caches.push_back(result);
+    }
+    result->pool = this;
+    threadCaches.push_back(result);
+    cacheList.lastUsed = result;
+    return *result;
 }
 
-void spacemma::BufferPool::addUsed(gsl::not_null<ByteBuffer*> buffer)
+bool spacemma::BufferPool::refillCache(ThreadCache& cache, uint8_t sizeClass)
 {
     std::lock_guard lock(mutex);
-    usedBuffers.push_back(buffer);
-    usedSize += buffer->getTotalSize();
+    std::vector<ByteBuffer*>& buffers = freeBuffers[sizeClass];
+    const size_t count = std::min<size_t>(buffers.size(), BUFFER_POOL_MAGAZINE_SIZE);
+    cache.buffers[sizeClass].insert(cache.buffers[sizeClass].end(), buffers.end() - count, buffers.end());
+    buffers.resize(buffers.size() - count);
+    return count > 0;
 }
 
-spacemma::ByteBuffer* spacemma::BufferPool::addBuffer(size_t size, bool setFree)
+void spacemma::BufferPool::flushCache(ThreadCache& cache, uint8_t sizeClass, size_t count)
 {
+    if (!count)
+    {
+        return;
+    }
+    // the least recently freed buffers are returned to the pool
+    std::vector<ByteBuffer*>& cachedBuffers = cache.buffers[sizeClass];
     std::lock_guard lock(mutex);
+    freeBuffers[sizeClass].insert(freeBuffers[sizeClass].end(), cachedBuffers.begin(), cachedBuffers.begin() + count);
+    cachedBuffers.erase(cachedBuffers.begin(), cachedBuffers.begin() + count);
+}
+
+spacemma::ByteBuffer* spacemma::BufferPool::acquireBuffer(uint8_t sizeClass)
+{
+    ByteBuffer* buff = takeFreeBuffer(sizeClass);
+    if (buff)
+    {
+        return buff;
+    }
+    if (byteSize + getClassSize(sizeClass) > maxSize)
+    {
+        // rather use a larger unused buffer than overflow the pool
+        for (uint8_t largerClass = sizeClass + 1; largerClass < BUFFER_POOL_SIZE_CLASSES && !buff; ++largerClass)
+        {
+            buff = takeFreeBuffer(largerClass);
+        }
+        if (buff)
+        {
+            return buff;
+        }
+        flushUnusedBuffers();
+    }
+    return addBuffer(sizeClass);
+}
+
+bool spacemma::BufferPool::releaseReference(gsl::not_null<ByteBuffer*> buffer, uint32_t& remaining) const
+{
+    // the checks come first, so that a foreign or already freed buffer keeps its references
+    if (buffer->pool != this || !buffer->pooledAndUsed || !buffer->releaseReference(remaining))
+    {
+        SPACEMMA_CATEGORY_ERROR(Pool, "Attempted to free buffer {:x} which is not in use in this pool!",
+                       reinterpret_cast<uintptr_t>(buffer.get()));
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::BufferPool::releaseBuffer(gsl::not_null<ByteBuffer*> buffer)
+{
+    SPACEMMA_CATEGORY_TRACE(Pool, "Freeing buffer {:x} of size {}.", reinterpret_cast<uintptr_t>(buffer.get()),
+                   buffer->getTotalByteSize());
+    if (buffer->pool != this || !buffer->pooledAndUsed)
+    {
+        return false;
+    }
+    buffer->pooledAndUsed = false;
+    usedSize -= buffer->getTotalSize();
+    --usedCount;
+    return true;
+}
+
+spacemma::ByteBuffer* spacemma::BufferPool::takeFreeBuffer(uint8_t sizeClass)
+{
+    std::vector<ByteBuffer*>& buffers = freeBuffers[sizeClass];
+    if (buffers.empty())
+    {
+        return nullptr;
+    }
+    ByteBuffer* buff = buffers.back();
+    buffers.pop_back();
+    return buff;
+}
+
+spacemma::ByteBuffer* spacemma::BufferPool::addBuffer(uint8_t sizeClass)
+{
+    const size_t size = getClassSize(sizeClass);
     if (byteSize + size <= maxSize)
     {
         ByteBuffer* buff = new ByteBuffer(size);
-        SPACEMMA_TRACE("Adding new buffer {:x} of size {} ({})", reinterpret_cast<uintptr_t>(buff), size, setFree);
+        SPACEMMA_CATEGORY_TRACE(Pool, "Adding new buffer {:x} of size {}", reinterpret_cast<uintptr_t>(buff), size);
+        buff->pool = this;
+        buff->sizeClass = sizeClass;
+        buff->poolIndex = allBuffers.size();
+        allBuffers.push_back(buff);
         byteSize += size;
-        if (setFree)
-        {
-            addToFreeBuffers(buff);
-        }
         return buff;
     }
-    SPACEMMA_ERROR("Attempting to overflow the buffer pool by adding {} bytes (the total size is {}, max size is {})",
+    SPACEMMA_CATEGORY_ERROR_LIMITED(Pool, "Attempting to overflow the buffer pool by adding {} bytes (the total size is {}, max size is {})",
                    size, byteSize, maxSize);
     return nullptr;
 }
 
-void spacemma::BufferPool::addToFreeBuffers(gsl::not_null<ByteBuffer*> buffer)
+void spacemma::BufferPool::flushUnusedBuffers()
 {
-    std::lock_guard lock(mutex);
-    if (freeBuffers.empty() || freeBuffers[0]->getTotalSize() >= buffer->getTotalSize())
-    {
-        freeBuffers.push_back(buffer);
-    } else
+    for (std::vector<ByteBuffer*>& buffers : freeBuffers)
     {
-        for (std::vector<ByteBuffer*>::iterator it = freeBuffers.begin(); it != freeBuffers.end(); ++it)
+        for (ByteBuffer* buff : buffers)
         {
-            if ((*it)->getTotalSize() <= buffer->getTotalSize())
-            {
-                freeBuffers.insert(it + 1, buffer);
-                break;
-            }
+            deleteBuffer(buff);
         }
+        buffers.clear();
     }
 }
 
-bool spacemma::BufferPool::deleteBuffer(gsl::not_null<ByteBuffer*> buffer, bool checkIfFree)
+void spacemma::BufferPool::deleteBuffer(gsl::not_null<ByteBuffer*> buffer)
 {
-    std::lock_guard lock(mutex);
-    SPACEMMA_TRACE("Deleting buffer {:x} of size {} ({})", reinterpret_cast<uintptr_t>(buffer),
-                   buffer->getTotalByteSize(), checkIfFree);
-    if (checkIfFree)
-    {
-        std::vector<ByteBuffer*>::iterator it = std::find(freeBuffers.begin(), freeBuffers.end(), buffer);
-        if (it == freeBuffers.end())
-        {
-            SPACEMMA_WARN("Failed to remove buffer {:x} as it's being used!", reinterpret_cast<uintptr_t>(buffer.get()));
-            return false;
-        }
-        freeBuffers.erase(it);
-    }
+    SPACEMMA_CATEGORY_TRACE(Pool, "Deleting buffer {:x} of size {}", reinterpret_cast<uintptr_t>(buffer.get()),
+                   buffer->getTotalByteSize());
+    // swap with the last registered buffer to keep the removal constant
+    ByteBuffer* last = allBuffers.back();
+    last->poolIndex = buffer->poolIndex;
+    allBuffers[buffer->poolIndex] = last;
+    allBuffers.pop_back();
     byteSize -= buffer->getTotalSize();
     delete buffer.get();
-    return true;
 }
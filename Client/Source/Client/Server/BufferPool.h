@@ -1,13 +1,23 @@
 #pragma once
 #include "Buffer.h"
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
+#define BUFFER_POOL_MIN_CLASS_SHIFT 4
+#define BUFFER_POOL_SIZE_CLASSES 28
+#define BUFFER_POOL_MAGAZINE_SIZE 32
+
 namespace spacemma
 {
     /**
      * A buffer pool used for efficient buffer recycling.
+     * Buffers are allocated in power-of-two size classes, each with its own free list, so that both
+     * getting and freeing a buffer take constant time.
+     * Every thread keeps a small cache of free buffers per size class, which is refilled from and flushed to the
+     * shared free lists BUFFER_POOL_MAGAZINE_SIZE buffers at a time, so most calls do not lock the pool.
+     * The pool must not be destroyed while other threads still use it.
      */
     class BufferPool final
     {
@@ -21,19 +31,27 @@ namespace spacemma
         /**
          * Returns a buffer for which the total size is greater or equal to size provided with an argument.
          * If the buffer pool does not contain an appropriate buffer, the buffer is created, added to the pool and returned.
+         * The total size of created buffers is rounded up to the size class.
          */
         ByteBuffer* getBuffer(size_t size);
         /**
-         * Marks the given buffer as free so that it can be used later.
+         * Adds references to the given buffer, so that it has to be freed count more times before it can be reused.
+         * Returned buffers hold a single reference. The provided buffer must be owned by this pool.
+         */
+        void retainBuffer(gsl::not_null<ByteBuffer*> buffer, uint32_t count = 1U);
+        /**
+         * Releases a reference to the given buffer. Once the last reference is released,
+         * the buffer is marked as free so that it can be used later.
          * The provided buffer must be owned by this pool.
          */
         bool freeBuffer(gsl::not_null<ByteBuffer*> buffer);
         /**
-         * Marks the given buffer as free, deallocates it and removes it from the pool.
+         * Releases a reference to the given buffer. Once the last reference is released,
+         * the buffer is marked as free, deallocated and removed from the pool.
          */
         bool freeAndRemoveBuffer(gsl::not_null<ByteBuffer*> buffer);
         /**
-         * Removes and deallocates all unused buffers in the pool.
+         * Removes and deallocates all unused buffers in the pool, except for those cached by other threads.
          */
         void flushUnused();
         /**
@@ -57,15 +75,47 @@ namespace spacemma
          */
         size_t getMaxSize() const;
     private:
-        bool freeBuffer(gsl::not_null<ByteBuffer*> buffer, bool remove);
-        void addUsed(gsl::not_null<ByteBuffer*> buffer);
-        ByteBuffer* addBuffer(size_t size, bool setFree);
-        void addToFreeBuffers(gsl::not_null<ByteBuffer*> buffer);
-        bool deleteBuffer(gsl::not_null<ByteBuffer*> buffer, bool checkIfFree);
-        mutable std::recursive_mutex mutex{};
-        std::vector<ByteBuffer*> usedBuffers{}, freeBuffers{};
+        /**
+         * Free buffers cached by a single thread.
+         */
+        struct ThreadCache
+        {
+            std::atomic<BufferPool*> pool{ nullptr };
+            std::vector<ByteBuffer*> buffers[BUFFER_POOL_SIZE_CLASSES]{};
+        };
+        /**
+         * All caches of a single thread, returned to their pools when the thread exits.
+         */
+        struct ThreadCacheList
+        {
+            ~ThreadCacheList();
+            std::vector<ThreadCache*> caches{};
+            ThreadCache* lastUsed{ nullptr };
+        };
+        static uint8_t getSizeClass(size_t size);
+        static size_t getClassSize(uint8_t sizeClass);
+        ThreadCache& getThreadCache();
+        bool refillCache(ThreadCache& cache, uint8_t sizeClass);
+        void flushCache(ThreadCache& cache, uint8_t sizeClass, size_t count);
+        ByteBuffer* acquireBuffer(uint8_t sizeClass);
+        /**
+         * Releases a reference to the given buffer if it is owned by this pool and in use.
+         * Returns false if it is not, true otherwise.
+         */
+        bool releaseReference(gsl::not_null<ByteBuffer*> buffer, uint32_t& remaining) const;
+        bool releaseBuffer(gsl::not_null<ByteBuffer*> buffer);
+        ByteBuffer* takeFreeBuffer(uint8_t sizeClass);
+        ByteBuffer* addBuffer(uint8_t sizeClass);
+        void flushUnusedBuffers();
+        void deleteBuffer(gsl::not_null<ByteBuffer*> buffer);
+        static std::mutex threadCacheMutex;
+        mutable std::mutex mutex{};
+        std::vector<ByteBuffer*> freeBuffers[BUFFER_POOL_SIZE_CLASSES]{};
+        std::vector<ByteBuffer*> allBuffers{};
+        std::vector<ThreadCache*> threadCaches{};
         size_t maxSize{};
         size_t byteSize{ 0UL };
-        size_t usedSize{ 0UL };
+        std::atomic<size_t> usedSize{ 0UL };
+        std::atomic<size_t> usedCount{ 0UL };
     };
 }
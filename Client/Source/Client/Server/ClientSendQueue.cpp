@@ -0,0 +1,117 @@
+#include "ClientSendQueue.h"
+
+#include <algorithm>
+
+spacemma::ClientSendQueue::ClientSendQueue(size_t capacity, size_t subjectCount, size_t kindCount)
+    : entries(capacity), slots(std::make_unique<ConflationSlot[]>(subjectCount * kindCount)),
+      subjectPushCounts(std::make_unique<std::atomic<uint64_t>[]>(subjectCount)), subjectCount(subjectCount),
+      kindCount(kindCount)
+{
+    for (size_t i = 0; i < subjectCount; ++i)
+    {
+        subjectPushCounts[i] = 0ULL;
+    }
+}
+
+bool spacemma::ClientSendQueue::push(gsl::not_null<ByteBuffer*> buffer)
+{
+    // raised before the buffer can be popped, so that the amount never underflows
+    queuedBytes += buffer->getUsedSize();
+    if (!entries.push(Entry{ buffer, 0U }))
+    {
+        queuedBytes -= buffer->getUsedSize();
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::ClientSendQueue::push(gsl::not_null<ByteBuffer*> buffer, size_t subject)
+{
+    if (!push(buffer))
+    {
+        return false;
+    }
+    // counted after the buffer is queued, so that a conflation slot which saw the count is queued after the buffer
+    ++subjectPushCounts[subject];
+    return true;
+}
+
+bool spacemma::ClientSendQueue::pushLatest(gsl::not_null<ByteBuffer*> buffer, size_t subject, size_t kind,
+                                           ByteBuffer*& replaced)
+{
+    const size_t slot = subject * kindCount + kind;
+    ConflationSlot& conflationSlot = slots[slot];
+    const uint64_t currentPushCount = subjectPushCounts[subject].load();
+    queuedBytes += buffer->getUsedSize();
+    replaced = nullptr;
+    ByteBuffer* previous = conflationSlot.buffer.load();
+    if (previous)
+    {
+        // fails if the consumer has just taken the previous buffer
+        if (conflationSlot.pushCount == currentPushCount && conflationSlot.buffer.compare_exchange_strong(previous, buffer))
+        {
+            queuedBytes -= previous->getUsedSize();
+            replaced = previous;
+            return true;
+        }
+        if (previous)
+        {
+            // the previous buffer must not overtake the events about the subject pushed after it, so this one is queued behind them
+            if (!entries.push(Entry{ buffer, 0U }))
+            {
+                queuedBytes -= buffer->getUsedSize();
+                return false;
+            }
+            return true;
+        }
+    }
+    conflationSlot.buffer.store(buffer);
+    if (!entries.push(Entry{ nullptr, slot }))
+    {
+        conflationSlot.buffer.store(nullptr);
+        queuedBytes -= buffer->getUsedSize();
+        return false;
+    }
+    conflationSlot.pushCount = currentPushCount;
+    return true;
+}
+
+size_t spacemma::ClientSendQueue::popBulk(gsl::span<ByteBuffer*> buffers)
+{
+    Entry popped[CLIENT_SEND_QUEUE_POP_BATCH];
+    const size_t maxCount = std::min<size_t>(buffers.size(), CLIENT_SEND_QUEUE_POP_BATCH);
+    size_t count = 0;
+    while (!count)
+    {
+        const size_t poppedCount = entries.popBulk(gsl::span<Entry>(popped, maxCount));
+        if (!poppedCount)
+        {
+            break;
+        }
+        for (size_t i = 0; i < poppedCount; ++i)
+        {
+            ByteBuffer* buffer = popped[i].buffer ? popped[i].buffer : slots[popped[i].slot].buffer.exchange(nullptr);
+            if (buffer)
+            {
+                queuedBytes -= buffer->getUsedSize();
+                buffers[count++] = buffer;
+            }
+        }
+    }
+    return count;
+}
+
+bool spacemma::ClientSendQueue::isEmpty() const
+{
+    return entries.isEmpty();
+}
+
+size_t spacemma::ClientSendQueue::getQueuedBytes() const
+{
+    return queuedBytes;
+}
+
+size_t spacemma::ClientSendQueue::getConflationSlotCount() const
+{
+    return subjectCount * kindCount;
+}
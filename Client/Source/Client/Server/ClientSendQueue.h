@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Buffer.h"
+#include "RingQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#define CLIENT_SEND_QUEUE_POP_BATCH 64
+
+namespace spacemma
+{
+    /**
+     * A queue of buffers waiting to be sent to a single client, for any amount of producers and a single consumer.
+     * Besides ordinary buffers, which are always sent in order, the queue has conflation slots for state updates
+     * of which only the latest one matters, one per kind of state of every subject. A buffer pushed to a conflation slot
+     * replaces the older buffer of the slot in place while it is still queued, as long as no event about the same subject
+     * was pushed after it, so the state never overtakes such an event. Otherwise the buffer is queued behind the others.
+     */
+    class ClientSendQueue final
+    {
+    public:
+        ClientSendQueue(size_t capacity, size_t subjectCount, size_t kindCount);
+        ~ClientSendQueue() = default;
+        ClientSendQueue(ClientSendQueue&) = delete;
+        ClientSendQueue(ClientSendQueue&&) = delete;
+        ClientSendQueue& operator=(ClientSendQueue&) = delete;
+        ClientSendQueue& operator=(ClientSendQueue&&) = delete;
+        /**
+         * Queues the buffer behind all queued buffers.
+         * Returns false if the queue is full, true otherwise.
+         */
+        bool push(gsl::not_null<ByteBuffer*> buffer);
+        /**
+         * Queues the buffer behind all queued buffers as an event about the subject,
+         * so that the states of the subject queued before it are no longer replaced.
+         * Returns false if the queue is full, true otherwise.
+         */
+        bool push(gsl::not_null<ByteBuffer*> buffer, size_t subject);
+        /**
+         * Queues the buffer as the latest state of the given kind of the subject. If it replaces an older buffer of
+         * the conflation slot, the older buffer is returned through replaced, so that the caller can free it,
+         * otherwise replaced is set to null pointer. May only be called from a single producer thread.
+         * Returns false if the queue is full, true otherwise.
+         */
+        bool pushLatest(gsl::not_null<ByteBuffer*> buffer, size_t subject, size_t kind, ByteBuffer*& replaced);
+        /**
+         * Pops up to buffers.size() oldest buffers. May only be called from the consumer thread.
+         * Returns the amount of buffers popped.
+         */
+        size_t popBulk(gsl::span<ByteBuffer*> buffers);
+        /**
+         * Returns true if the queue contained no buffers at the moment of the call, false otherwise.
+         */
+        bool isEmpty() const;
+        /**
+         * Returns the total size of the queued buffers.
+         */
+        size_t getQueuedBytes() const;
+        /**
+         * Returns the amount of conflation slots.
+         */
+        size_t getConflationSlotCount() const;
+    private:
+        /**
+         * A queued buffer, or a reference to a conflation slot if the buffer is null pointer.
+         */
+        struct Entry final
+        {
+            ByteBuffer* buffer;
+            size_t slot;
+        };
+        struct ConflationSlot final
+        {
+            std::atomic<ByteBuffer*> buffer{ nullptr };
+            // the amount of events about the subject pushed before the slot's entry was queued
+            uint64_t pushCount{ 0ULL };
+        };
+        MPSCRingQueue<Entry> entries;
+        std::unique_ptr<ConflationSlot[]> slots;
+        // the amount of events pushed about each subject
+        std::unique_ptr<std::atomic<uint64_t>[]> subjectPushCounts;
+        size_t subjectCount, kindCount;
+        std::atomic<size_t> queuedBytes{ 0ULL };
+    };
+}
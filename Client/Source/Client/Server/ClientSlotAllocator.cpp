@@ -0,0 +1,74 @@
+#include "ClientSlotAllocator.h"
+#include "SpaceLog.h"
+
+spacemma::ClientSlotAllocator::ClientSlotAllocator(unsigned char slotCount)
+{
+    if (slotCount > CLIENT_MAX_SLOTS)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Slot amount {} exceeds the limit of {}!", slotCount, CLIENT_MAX_SLOTS);
+        slotCount = CLIENT_MAX_SLOTS;
+    }
+    ids.resize(slotCount, 0U);
+    generations.resize(slotCount, 0U);
+    freeSlots.reserve(slotCount);
+    // the free slots are used as a stack, so the lowest slot is on top
+    for (unsigned char slot = slotCount; slot > 0; --slot)
+    {
+        freeSlots.push_back(slot - 1U);
+    }
+}
+
+unsigned short spacemma::ClientSlotAllocator::acquire()
+{
+    std::lock_guard lock(mutex);
+    if (freeSlots.empty())
+    {
+        return 0U;
+    }
+    const unsigned char slot = freeSlots.back();
+    freeSlots.pop_back();
+    // the generation skips zero, so that no ID is ever zero
+    if (++generations[slot] == 0U)
+    {
+        generations[slot] = 1U;
+    }
+    ids[slot] = static_cast<unsigned short>((generations[slot] << CLIENT_SLOT_BITS) | slot);
+    return ids[slot];
+}
+
+bool spacemma::ClientSlotAllocator::release(unsigned short clientId)
+{
+    std::lock_guard lock(mutex);
+    const unsigned char slot = getClientSlot(clientId);
+    if (!clientId || slot >= ids.size() || ids[slot] != clientId)
+    {
+        return false;
+    }
+    ids[slot] = 0U;
+    freeSlots.push_back(slot);
+    return true;
+}
+
+bool spacemma::ClientSlotAllocator::isValid(unsigned short clientId) const
+{
+    std::lock_guard lock(mutex);
+    const unsigned char slot = getClientSlot(clientId);
+    return clientId && slot < ids.size() && ids[slot] == clientId;
+}
+
+bool spacemma::ClientSlotAllocator::hasFreeSlot() const
+{
+    std::lock_guard lock(mutex);
+    return !freeSlots.empty();
+}
+
+unsigned char spacemma::ClientSlotAllocator::getUsedCount() const
+{
+    std::lock_guard lock(mutex);
+    return static_cast<unsigned char>(ids.size() - freeSlots.size());
+}
+
+unsigned char spacemma::ClientSlotAllocator::getSlotCount() const
+{
+    return static_cast<unsigned char>(ids.size());
+}
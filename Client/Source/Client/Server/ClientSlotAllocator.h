@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#define CLIENT_SLOT_BITS 8
+#define CLIENT_SLOT_MASK ((1U << CLIENT_SLOT_BITS) - 1U)
+#define CLIENT_MAX_SLOTS CLIENT_SLOT_MASK
+
+namespace spacemma
+{
+    /**
+     * Returns the slot of the given client ID. The slot is a dense index which can be used to address flat per-client arrays.
+     */
+    inline unsigned char getClientSlot(unsigned short clientId)
+    {
+        return static_cast<unsigned char>(clientId & CLIENT_SLOT_MASK);
+    }
+
+    /**
+     * Hands out client IDs consisting of a dense slot index in the low CLIENT_SLOT_BITS bits and
+     * the slot's generation in the high bits. The generation changes every time a slot is reused,
+     * so an ID of a disconnected client never matches the client which took over its slot.
+     * Zero is never a valid client ID.
+     */
+    class ClientSlotAllocator final
+    {
+    public:
+        ClientSlotAllocator(unsigned char slotCount);
+        ~ClientSlotAllocator() = default;
+        ClientSlotAllocator(ClientSlotAllocator&) = delete;
+        ClientSlotAllocator(ClientSlotAllocator&&) = delete;
+        ClientSlotAllocator& operator=(ClientSlotAllocator&) = delete;
+        ClientSlotAllocator& operator=(ClientSlotAllocator&&) = delete;
+        /**
+         * Returns the ID of a newly occupied slot or zero if all slots are in use.
+         * Slots are handed out starting from the lowest one and recently freed slots are reused first.
+         */
+        unsigned short acquire();
+        /**
+         * Frees the slot of the given client ID.
+         * Returns false if the ID does not belong to an occupied slot, true otherwise.
+         */
+        bool release(unsigned short clientId);
+        /**
+         * Returns true if the given ID belongs to an occupied slot, false otherwise.
+         */
+        bool isValid(unsigned short clientId) const;
+        /**
+         * Returns true if there is at least one free slot, false otherwise.
+         */
+        bool hasFreeSlot() const;
+        /**
+         * Returns the amount of occupied slots.
+         */
+        unsigned char getUsedCount() const;
+        /**
+         * Returns the total amount of slots.
+         */
+        unsigned char getSlotCount() const;
+    private:
+        mutable std::mutex mutex{};
+        std::vector<unsigned short> ids{};
+        std::vector<unsigned char> generations{};
+        std::vector<unsigned char> freeSlots{};
+    };
+}
@@ -0,0 +1,847 @@
+#if PLATFORM_LINUX
+#include "EpollTCPMultiClientServer.h"
+#include "PosixThread.h"
+#include "SpaceLog.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+#define EPOLL_WAKE_EVENT_ID UINT32_MAX
+#define EPOLL_CLIENT_EVENTS (EPOLLIN | EPOLLRDHUP | EPOLLONESHOT)
+
+spacemma::EpollTCPMultiClientServer::EpollTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients,
+                                                               unsigned char reactorThreadCount)
+    : TCPMultiClientServer(bufferPool), maxClients(maxClients), reactorThreadCount(reactorThreadCount),
+      clientSlots(maxClients)
+{
+    if (!maxClients)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Max client amount must be greater than zero!");
+    }
+    if (!reactorThreadCount)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Reactor thread amount must be greater than zero!");
+    }
+    clientData = gsl::make_span<EpollClientData>(new EpollClientData[maxClients]{}, maxClients);
+}
+
+spacemma::EpollTCPMultiClientServer::~EpollTCPMultiClientServer()
+{
+    if (isListening() || isConnected())
+    {
+        shutdown();
+        close();
+    }
+    delete[] clientData.begin();
+}
+
+bool spacemma::EpollTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddress, unsigned short port)
+{
+    if (ipAddress.empty())
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Provided IP address is empty!");
+        return false;
+    }
+    SPACEMMA_CATEGORY_DEBUG(Net, "Attempting to bind a socket to {}:{}...", ipAddress.cbegin(), port);
+    shutdown();
+    close();
+    serverSocket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (serverSocket == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create socket ({})!", errno);
+        return false;
+    }
+    const int REUSE_ADDRESS = 1;
+    if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &REUSE_ADDRESS, sizeof(REUSE_ADDRESS)) == -1)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to enable address reuse ({})!", errno);
+    }
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (int ret = inet_pton(address.sin_family, ipAddress.cbegin(), &address.sin_addr); ret != 1)
+    {
+        if (ret == 0)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "An invalid IP address was provided!");
+        } else
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to convert the IP address ({})!", errno);
+        }
+        closeServer();
+        return false;
+    }
+    if (bind(serverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to bind socket ({})!", errno);
+        closeServer();
+        return false;
+    }
+    if (listen(serverSocket, SOMAXCONN) == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to start listening ({})!", errno);
+        closeServer();
+        return false;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create epoll instance ({})!", errno);
+        closeServer();
+        return false;
+    }
+    wakeFd = eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create reactor wake descriptor ({})!", errno);
+        closeServer();
+        return false;
+    }
+    epoll_event wakeEvent{};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.u32 = EPOLL_WAKE_EVENT_ID;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEvent) == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to register reactor wake descriptor ({})!", errno);
+        closeServer();
+        return false;
+    }
+    if (!startReactors())
+    {
+        stopReactors();
+        closeServer();
+        return false;
+    }
+    char buff[INET_ADDRSTRLEN]{ 0 };
+    const char* str = inet_ntop(AF_INET, &address.sin_addr, buff, INET_ADDRSTRLEN);
+    if (str == nullptr)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", errno);
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound and listening for {} clients with {} reactor threads!", maxClients,
+                       reactorThreadCount);
+    } else
+    {
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound to {}:{} and listening for {} clients with {} reactor threads!", str, port,
+                       maxClients, reactorThreadCount);
+    }
+    return true;
+}
+
+bool spacemma::EpollTCPMultiClientServer::isListening()
+{
+    return serverSocket != -1;
+}
+
+unsigned short spacemma::EpollTCPMultiClientServer::acceptClient()
+{
+    if (!clientSlots.hasFreeSlot())
+    {
+        return 0;
+    }
+    pollfd acceptFd{ serverSocket, POLLIN, 0 };
+    if (int ret = poll(&acceptFd, 1, EPOLL_ACCEPT_TIMEOUT); ret <= 0)
+    {
+        if (ret == -1 && errno != EINTR)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to wait for a client connection ({})!", errno);
+        }
+        return 0;
+    }
+    sockaddr_in addr{};
+    socklen_t addrSize{ sizeof(addr) };
+    int clientSocket = accept4(serverSocket, reinterpret_cast<sockaddr*>(&addr), &addrSize, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (clientSocket == -1)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to accept a client connection ({})!", errno);
+        }
+        return 0;
+    }
+    char buff[INET_ADDRSTRLEN]{ 0 };
+    const char* str = inet_ntop(AF_INET, &addr.sin_addr, buff, INET_ADDRSTRLEN);
+    if (str == nullptr)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", errno);
+        SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection!");
+    } else
+    {
+        SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection from {}:{}!", str, addr.sin_port);
+    }
+    const unsigned short client = clientSlots.acquire();
+    if (!client)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Unable to acquire a client slot. Closing connection!");
+        ::close(clientSocket);
+        return 0;
+    }
+    EpollClientData* data = &clientData[getClientSlot(client)];
+    {
+        std::lock_guard lock(data->socketMutex);
+        data->reassembler.reset();
+        data->outbound.clear();
+        data->handling = false;
+        data->deferredEvents = 0U;
+        data->disconnectReported = false;
+        data->closeRequested = false;
+        data->armed = false;
+        data->socket = clientSocket;
+        data->sendScheduled = false;
+        data->isConnected = true;
+        // published last, so that the reactor threads see the socket of the client along with its ID
+        data->id.store(client, std::memory_order_release);
+    }
+    return client;
+}
+
+unsigned char spacemma::EpollTCPMultiClientServer::getClientCount() const
+{
+    return clientSlots.getUsedCount();
+}
+
+std::vector<unsigned short> spacemma::EpollTCPMultiClientServer::getClientIds() const
+{
+    std::vector<unsigned short> result{};
+    for (unsigned char i = 0; i < maxClients; ++i)
+    {
+        if (const unsigned short client = clientData[i].id)
+        {
+            result.push_back(client);
+        }
+    }
+    return result;
+}
+
+bool spacemma::EpollTCPMultiClientServer::isClientAlive(unsigned short client) const
+{
+    return getClientData(client) != nullptr;
+}
+
+bool spacemma::EpollTCPMultiClientServer::startClient(unsigned short client)
+{
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    std::lock_guard lock(data->socketMutex);
+    if (data->id != client || data->armed)
+    {
+        return false;
+    }
+    epoll_event clientEvent{};
+    clientEvent.events = data->outbound.empty() ? EPOLL_CLIENT_EVENTS : EPOLL_CLIENT_EVENTS | EPOLLOUT;
+    clientEvent.data.u32 = client;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, data->socket, &clientEvent) == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to register client socket in the reactor ({})!", errno);
+        return false;
+    }
+    data->armed = true;
+    return true;
+}
+
+bool spacemma::EpollTCPMultiClientServer::send(gsl::not_null<ByteBuffer*> buff)
+{
+    bool sent = false;
+    for (unsigned char i = 0; i < maxClients; ++i)
+    {
+        const unsigned short client = clientData[i].id;
+        if (client && sendTo(buff, client))
+        {
+            sent = true;
+        }
+    }
+    return sent;
+}
+
+bool spacemma::EpollTCPMultiClientServer::sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short client)
+{
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    if (buff->getUsedSize() > TCP_MAX_FRAME_SIZE)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Unable to send {} data to client {}! The frame size limit is {}.", buff->getUsedSize(),
+                       client, TCP_MAX_FRAME_SIZE);
+        return false;
+    }
+    std::lock_guard lock(data->socketMutex);
+    if (data->id != client || !data->isConnected)
+    {
+        return false;
+    }
+    FrameLength frameLength = static_cast<FrameLength>(buff->getUsedSize());
+    const size_t frameSize = TCP_FRAME_HEADER_SIZE + buff->getUsedSize();
+    size_t remaining = frameSize;
+    // the frame may only go straight to the socket once the data of the previous ones is gone
+    if (data->outbound.empty())
+    {
+        iovec frameParts[2]{ { &frameLength, TCP_FRAME_HEADER_SIZE }, { buff->getPointer(), buff->getUsedSize() } };
+        msghdr message{};
+        message.msg_iov = frameParts;
+        message.msg_iovlen = 2;
+        while (remaining > 0)
+        {
+            ssize_t sent = sendmsg(data->socket, &message, MSG_NOSIGNAL);
+            if (sent >= 0)
+            {
+                remaining -= static_cast<size_t>(sent);
+                // skip the part of the frame that was already sent
+                while (sent > 0 && message.msg_iovlen > 0)
+                {
+                    if (static_cast<size_t>(sent) >= message.msg_iov->iov_len)
+                    {
+                        sent -= static_cast<ssize_t>(message.msg_iov->iov_len);
+                        ++message.msg_iov;
+                        --message.msg_iovlen;
+                    } else
+                    {
+                        message.msg_iov->iov_base = static_cast<uint8_t*>(message.msg_iov->iov_base) + sent;
+                        message.msg_iov->iov_len -= static_cast<size_t>(sent);
+                        sent = 0;
+                    }
+                }
+                continue;
+            }
+            const int error = errno;
+            if (error == EINTR)
+            {
+                continue;
+            }
+            if (error == EAGAIN || error == EWOULDBLOCK)
+            {
+                break;
+            }
+            switch (error)
+            {
+                case ECONNRESET:
+                case EPIPE:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! Connection reset by peer.", buff->getUsedSize(), client);
+                    data->isConnected = false;
+                    break;
+                case ETIMEDOUT:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! Connection timed out.", buff->getUsedSize(), client);
+                    data->isConnected = false;
+                    break;
+                default:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data ({}) to client {}!", buff->getUsedSize(), error, client);
+                    break;
+            }
+            return false;
+        }
+        if (!remaining)
+        {
+            return true;
+        }
+    }
+    if (data->outbound.size() + remaining > TCP_MAX_OUTBOUND_SIZE)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! The client does not take its data.", buff->getUsedSize(), client);
+        data->isConnected = false;
+        return false;
+    }
+    // the socket buffer is full, the reactor sends the rest of the frame once the socket becomes writable
+    appendFrame(data->outbound, *buff, frameSize - remaining);
+    // a client which is not started yet waits for writability once startClient registers it
+    if (!data->handling && data->armed)
+    {
+        rearmClient(*data);
+    }
+    return true;
+}
+
+spacemma::ByteBuffer* spacemma::EpollTCPMultiClientServer::receive()
+{
+    return nullptr; // unspecified client to receive from, just return nullptr
+}
+
+spacemma::ByteBuffer* spacemma::EpollTCPMultiClientServer::receiveFrom(unsigned short client)
+{
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return nullptr;
+    }
+    while (true)
+    {
+        gsl::span<uint8_t> freeSpace = data->reassembler.getFreeSpace(*bufferPool);
+        if (freeSpace.empty())
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to acquire a receive buffer for client {}!", client);
+            return nullptr;
+        }
+        ssize_t received = recv(data->socket, freeSpace.data(), freeSpace.size(), 0);
+        if (received == 0)
+        {
+            data->isConnected = false;
+            return nullptr;
+        }
+        if (received == -1)
+        {
+            const int error = errno;
+            if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+            {
+                return nullptr;
+            }
+            switch (error)
+            {
+                case ECONNRESET:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data from client {}! Connection reset by peer.", client);
+                    data->isConnected = false;
+                    break;
+                case ETIMEDOUT:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data from client {}! Connection timed out.", client);
+                    data->isConnected = false;
+                    break;
+                default:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data ({}) from client {}!", error, client);
+                    break;
+            }
+            return nullptr;
+        }
+        if (!data->reassembler.commit(received))
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Received malformed data stream from client {}!", client);
+            data->isConnected = false;
+            return nullptr;
+        }
+        if (ByteBuffer* buff = data->reassembler.takeFrames())
+        {
+            return buff;
+        }
+    }
+}
+
+bool spacemma::EpollTCPMultiClientServer::shutdown()
+{
+    for (unsigned char i = 0; i < maxClients; ++i)
+    {
+        if (clientData[i].id)
+        {
+            shutdownClient(clientData[i].id);
+        }
+    }
+    return shutdownServer();
+}
+
+bool spacemma::EpollTCPMultiClientServer::close()
+{
+    stopReactors();
+    for (unsigned char i = 0; i < maxClients; ++i)
+    {
+        if (clientData[i].id)
+        {
+            closeClient(clientData[i].id);
+        }
+    }
+    return closeServer();
+}
+
+bool spacemma::EpollTCPMultiClientServer::isConnected()
+{
+    return getClientCount() != 0;
+}
+
+bool spacemma::EpollTCPMultiClientServer::shutdownClient(unsigned short client) const
+{
+    if (!client)
+    {
+        return false;
+    }
+    EpollClientData* data = getClientData(client);
+    if (data)
+    {
+        std::lock_guard lock(data->socketMutex);
+        if (data->id != client)
+        {
+            return false;
+        }
+        if (::shutdown(data->socket, SHUT_RDWR) == -1 && errno != ENOTCONN)
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down client socket ({})!", errno);
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool spacemma::EpollTCPMultiClientServer::closeClient(unsigned short client) const
+{
+    if (!client)
+    {
+        return false;
+    }
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    std::lock_guard lock(data->socketMutex);
+    if (data->id != client)
+    {
+        return false;
+    }
+    if (data->handling)
+    {
+        // the socket must not be closed under the reactor thread handling it, which closes it once it is done
+        data->closeRequested = true;
+        return true;
+    }
+    return closeSocket(*data);
+}
+
+bool spacemma::EpollTCPMultiClientServer::isConnected(unsigned short client) const
+{
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    return data->isConnected;
+}
+
+bool spacemma::EpollTCPMultiClientServer::hasPendingOutput(unsigned short client) const
+{
+    EpollClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    std::lock_guard lock(data->socketMutex);
+    return data->id == client && !data->outbound.empty();
+}
+
+void spacemma::EpollTCPMultiClientServer::setEventHandler(ClientEventHandler handler, void* ptr)
+{
+    if (!reactorThreads.empty())
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Changing the event handler while the reactor threads are running!");
+    }
+    eventHandler = handler;
+    eventHandlerPtr = ptr;
+}
+
+bool spacemma::EpollTCPMultiClientServer::scheduleSend(unsigned short client)
+{
+    EpollClientData* data = getClientData(client);
+    if (!data || !data->isConnected)
+    {
+        return false;
+    }
+    if (!data->sendScheduled.exchange(true))
+    {
+        return wakeReactors();
+    }
+    return true;
+}
+
+void spacemma::EpollTCPMultiClientServer::setThreadSettings(uint64_t cpuMask, ThreadPriority priority)
+{
+    reactorCpuMask = cpuMask;
+    reactorPriority = priority;
+}
+
+void spacemma::EpollTCPMultiClientServer::threadReactor(gsl::not_null<Thread*> thread, void* server)
+{
+    EpollTCPMultiClientServer* srv = reinterpret_cast<EpollTCPMultiClientServer*>(server);
+    epoll_event events[EPOLL_MAX_EVENTS];
+    SPACEMMA_CATEGORY_DEBUG(Net, "Starting threadReactor...");
+    do
+    {
+        int count = epoll_wait(srv->epollFd, events, EPOLL_MAX_EVENTS, EPOLL_WAIT_TIMEOUT);
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to wait for reactor events ({})!", errno);
+            break;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.u32 == EPOLL_WAKE_EVENT_ID)
+            {
+                srv->handleScheduledSends();
+            } else
+            {
+                srv->handleSocketEvent(static_cast<unsigned short>(events[i].data.u32), events[i].events);
+            }
+        }
+    } while (!thread->isInterrupted());
+    SPACEMMA_CATEGORY_DEBUG(Net, "Stopping threadReactor...");
+}
+
+void spacemma::EpollTCPMultiClientServer::handleSocketEvent(unsigned short client, uint32_t events)
+{
+    const unsigned char slot = getClientSlot(client);
+    if (slot >= maxClients)
+    {
+        return;
+    }
+    EpollClientData& data = clientData[slot];
+    {
+        std::lock_guard lock(data.socketMutex);
+        if (data.id != client)
+        {
+            return;
+        }
+        if (data.handling)
+        {
+            // sendTo rearmed the socket while another reactor thread was handling it, that thread takes over the events
+            data.deferredEvents |= events;
+            return;
+        }
+        data.handling = true;
+    }
+    bool reportDisconnect;
+    while (true)
+    {
+        if ((events & EPOLLIN) && eventHandler)
+        {
+            eventHandler(ClientEvent::Received, client, eventHandlerPtr);
+        }
+        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        {
+            data.isConnected = false;
+        }
+        if ((events & EPOLLOUT) && data.isConnected && sendOutbound(data) && eventHandler)
+        {
+            // the buffers left queued while the socket was full
+            std::lock_guard lock(data.sendMutex);
+            eventHandler(ClientEvent::SendReady, client, eventHandlerPtr);
+        }
+        std::lock_guard lock(data.socketMutex);
+        if (data.deferredEvents && !data.closeRequested)
+        {
+            events = std::exchange(data.deferredEvents, 0U);
+            continue;
+        }
+        data.handling = false;
+        if (data.closeRequested)
+        {
+            closeSocket(data);
+            return;
+        }
+        if (data.isConnected)
+        {
+            rearmClient(data);
+            return;
+        }
+        // the socket is not rearmed, so the disconnection is reported exactly once
+        reportDisconnect = !std::exchange(data.disconnectReported, true);
+        break;
+    }
+    if (reportDisconnect)
+    {
+        SPACEMMA_CATEGORY_DEBUG(Net, "Client {} disconnected.", client);
+        if (eventHandler)
+        {
+            eventHandler(ClientEvent::Disconnected, client, eventHandlerPtr);
+        }
+    }
+}
+
+void spacemma::EpollTCPMultiClientServer::handleScheduledSends()
+{
+    uint64_t wakeCount;
+    if (read(wakeFd, &wakeCount, sizeof(wakeCount)) == -1 && errno != EAGAIN)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to read reactor wake descriptor ({})!", errno);
+    }
+    for (unsigned char i = 0; i < maxClients; ++i)
+    {
+        EpollClientData& data = clientData[i];
+        if (data.sendScheduled.exchange(false))
+        {
+            // serializes senders, so a client's buffers are never sent by two reactor threads at once
+            std::lock_guard lock(data.sendMutex);
+            const unsigned short client = data.id;
+            // clients with outbound data get their SendReady once the socket takes it
+            if (client && data.isConnected && !hasPendingOutput(client) && eventHandler)
+            {
+                eventHandler(ClientEvent::SendReady, client, eventHandlerPtr);
+            }
+        }
+    }
+}
+
+bool spacemma::EpollTCPMultiClientServer::sendOutbound(EpollClientData& data) const
+{
+    std::lock_guard lock(data.socketMutex);
+    size_t sent = 0;
+    while (sent < data.outbound.size())
+    {
+        const ssize_t ret = ::send(data.socket, data.outbound.data() + sent, data.outbound.size() - sent, MSG_NOSIGNAL);
+        if (ret >= 0)
+        {
+            sent += static_cast<size_t>(ret);
+            continue;
+        }
+        const int error = errno;
+        if (error == EINTR)
+        {
+            continue;
+        }
+        if (error != EAGAIN && error != EWOULDBLOCK)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} pending data ({}) to client {}!", data.outbound.size() - sent,
+                           error, data.id);
+            data.isConnected = false;
+        }
+        break;
+    }
+    data.outbound.erase(data.outbound.begin(), data.outbound.begin() + sent);
+    return data.outbound.empty();
+}
+
+bool spacemma::EpollTCPMultiClientServer::rearmClient(const EpollClientData& data) const
+{
+    epoll_event clientEvent{};
+    clientEvent.events = data.outbound.empty() ? EPOLL_CLIENT_EVENTS : EPOLL_CLIENT_EVENTS | EPOLLOUT;
+    clientEvent.data.u32 = data.id;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, data.socket, &clientEvent) == -1)
+    {
+        // the client might have been closed while its event was being handled
+        if (errno != ENOENT && errno != EBADF)
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to rearm client socket ({})!", errno);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::EpollTCPMultiClientServer::closeSocket(EpollClientData& data) const
+{
+    const unsigned short client = data.id;
+    // events of the closed connection still on their way to a reactor thread find no client
+    data.id = 0;
+    data.isConnected = false;
+    data.sendScheduled = false;
+    data.closeRequested = false;
+    data.armed = false;
+    data.outbound.clear();
+    if (data.armed && epollFd != -1 && epoll_ctl(epollFd, EPOLL_CTL_DEL, data.socket, nullptr) == -1)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to unregister client socket from the reactor ({})!", errno);
+    }
+    bool closed = true;
+    if (::close(data.socket) == -1)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to close client socket ({})!", errno);
+        closed = false;
+    }
+    data.socket = -1;
+    clientSlots.release(client);
+    return closed;
+}
+
+bool spacemma::EpollTCPMultiClientServer::wakeReactors() const
+{
+    const uint64_t wakeCount = 1ULL;
+    if (write(wakeFd, &wakeCount, sizeof(wakeCount)) == -1 && errno != EAGAIN)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to wake the reactor threads ({})!", errno);
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::EpollTCPMultiClientServer::startReactors()
+{
+    for (unsigned char i = 0; i < reactorThreadCount; ++i)
+    {
+        Thread* thread = new PosixThread();
+        reactorThreads.push_back(thread);
+        thread->setName("srv-reactor-" + std::to_string(i));
+        thread->setAffinity(reactorCpuMask);
+        thread->setPriority(reactorPriority);
+        if (!thread->run(threadReactor, this))
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to start reactor thread #{}!", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void spacemma::EpollTCPMultiClientServer::stopReactors()
+{
+    if (reactorThreads.empty())
+    {
+        return;
+    }
+    for (Thread* thread : reactorThreads)
+    {
+        thread->interrupt();
+    }
+    wakeReactors();
+    for (Thread* thread : reactorThreads)
+    {
+        thread->join();
+        delete thread;
+    }
+    reactorThreads.clear();
+}
+
+bool spacemma::EpollTCPMultiClientServer::shutdownServer() const
+{
+    if (serverSocket != -1)
+    {
+        if (::shutdown(serverSocket, SHUT_RDWR) == -1 && errno != ENOTCONN)
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down server socket ({})!", errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool spacemma::EpollTCPMultiClientServer::closeServer()
+{
+    bool closed = true;
+    if (wakeFd != -1)
+    {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+    if (epollFd != -1)
+    {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+    if (serverSocket != -1)
+    {
+        if (::close(serverSocket) == -1)
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to close server socket ({})!", errno);
+            closed = false;
+        }
+        serverSocket = -1;
+    }
+    return closed;
+}
+
+spacemma::EpollClientData* spacemma::EpollTCPMultiClientServer::getClientData(unsigned short client) const
+{
+    const unsigned char slot = getClientSlot(client);
+    if (!client || slot >= maxClients || clientData[slot].id != client)
+    {
+        return nullptr;
+    }
+    return &clientData[slot];
+}
+
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#if PLATFORM_LINUX
+#include "ClientSlotAllocator.h"
+#include "StreamReassembler.h"
+#include "TCPMultiClientServer.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <mutex>
+#include <netinet/in.h>
+#include <vector>
+
+#define EPOLL_MAX_EVENTS 64
+#define EPOLL_WAIT_TIMEOUT 500
+#define EPOLL_ACCEPT_TIMEOUT 500
+
+namespace spacemma
+{
+    struct EpollClientData
+    {
+        int socket{ -1 };
+        // stored last when a client is accepted, so that a client ID is never paired with the previous socket
+        std::atomic<unsigned short> id{ 0U };
+        StreamReassembler reassembler{};
+        std::atomic_bool isConnected{};
+        std::atomic_bool sendScheduled{};
+        std::mutex sendMutex{};
+        // guards the socket writes and all of the fields below
+        std::mutex socketMutex{};
+        // frame data the socket did not take, sent by the reactor once the socket becomes writable
+        std::vector<uint8_t> outbound{};
+        // set while a reactor thread handles the events of the client
+        bool handling{ false };
+        // events delivered to another reactor thread while the client was being handled
+        uint32_t deferredEvents{ 0U };
+        bool disconnectReported{ false };
+        // set by closeClient while the client is being handled, the handling reactor thread closes the socket
+        bool closeRequested{ false };
+        // set once startClient registered the socket in the reactor
+        bool armed{ false };
+    };
+
+    /**
+     * An event-driven multi-client TCP server implementation based on epoll.
+     * All client sockets are non-blocking and are served by a fixed number of reactor threads which
+     * report client events through the handler set with setEventHandler. receiveFrom never blocks and
+     * returns a null pointer once there is no more data to be received. sendTo never blocks either,
+     * the data the socket does not take is kept per client and sent once the socket becomes writable.
+     */
+    class EpollTCPMultiClientServer final : public TCPMultiClientServer
+    {
+    public:
+        EpollTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients, unsigned char reactorThreadCount = 1);
+        ~EpollTCPMultiClientServer();
+        EpollTCPMultiClientServer(EpollTCPMultiClientServer&) = delete;
+        EpollTCPMultiClientServer(EpollTCPMultiClientServer&&) = delete;
+        EpollTCPMultiClientServer& operator=(EpollTCPMultiClientServer&) = delete;
+        EpollTCPMultiClientServer& operator=(EpollTCPMultiClientServer&&) = delete;
+        bool bindAndListen(gsl::cstring_span ipAddress, unsigned short port) override;
+        bool isListening() override;
+        unsigned short acceptClient() override;
+        unsigned char getClientCount() const override;
+        std::vector<unsigned short> getClientIds() const override;
+        bool isClientAlive(unsigned short client) const override;
+        bool startClient(unsigned short client) override;
+        bool send(gsl::not_null<ByteBuffer*> buff) override;
+        bool sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short client) override;
+        ByteBuffer* receive() override;
+        ByteBuffer* receiveFrom(unsigned short client) override;
+        bool shutdown() override;
+        bool close() override;
+        bool isConnected() override;
+        bool shutdownClient(unsigned short client) const override;
+        bool closeClient(unsigned short client) const override;
+        bool isConnected(unsigned short client) const override;
+        bool hasPendingOutput(unsigned short client) const override;
+        void setEventHandler(ClientEventHandler handler, void* ptr) override;
+        bool scheduleSend(unsigned short client) override;
+        void setThreadSettings(uint64_t cpuMask, ThreadPriority priority) override;
+    private:
+        static void threadReactor(gsl::not_null<Thread*> thread, void* server);
+        void handleSocketEvent(unsigned short client, uint32_t events);
+        void handleScheduledSends();
+        /**
+         * Sends as much of the outbound data of the client as the socket takes.
+         * Returns true if no outbound data is left, false otherwise.
+         */
+        bool sendOutbound(EpollClientData& data) const;
+        /**
+         * Rearms the socket of the client, waiting for writability too while there is outbound data.
+         * Has to be called with the socket mutex of the client locked.
+         */
+        bool rearmClient(const EpollClientData& data) const;
+        /**
+         * Closes the socket of the client and frees its slot.
+         * Has to be called with the socket mutex of the client locked while no reactor thread handles the client.
+         */
+        bool closeSocket(EpollClientData& data) const;
+        bool wakeReactors() const;
+        bool startReactors();
+        void stopReactors();
+        bool shutdownServer() const;
+        bool closeServer();
+        inline EpollClientData* getClientData(unsigned short client) const;
+        int serverSocket{ -1 };
+        int epollFd{ -1 };
+        int wakeFd{ -1 };
+        sockaddr_in address{};
+        unsigned char maxClients{ 0 };
+        unsigned char reactorThreadCount{ 0 };
+        gsl::span<EpollClientData> clientData{};
+        mutable ClientSlotAllocator clientSlots;
+        std::vector<Thread*> reactorThreads{};
+        uint64_t reactorCpuMask{ 0 };
+        ThreadPriority reactorPriority{ ThreadPriority::Normal };
+        ClientEventHandler eventHandler{ nullptr };
+        void* eventHandlerPtr{ nullptr };
+    };
+}
+
+#endif
@@ -1,21 +1,26 @@
 #include "GameServer.h"
 #include "Client/Server/SpaceLog.h"
-#include "Client/Server/WinThread.h"
+#include "Client/Server/ClientSlotAllocator.h"
+#include "Client/Server/PlatformThread.h"
+#include "Client/Server/StreamReassembler.h"
+#include "Client/Server/WorkerPool.h"
+#include "Components/CapsuleComponent.h"
+#if PLATFORM_WINDOWS
 #include "Client/Server/WinTCPMultiClientServer.h"
+#elif PLATFORM_LINUX
+#include "Client/Server/EpollTCPMultiClientServer.h"
+#endif
 #include "Client/Shared/Packets.h"
 #include "Engine/World.h"
+#include "HAL/PlatformAffinity.h"
+#include "HAL/PlatformProcess.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
+#include <algorithm>
+
 using namespace spacemma;
 using namespace spacemma::packets;
 
-struct ThreadArgs
-{
-    AGameServer* server{};
-    unsigned short port{};
-    std::atomic_bool received{ false };
-};
-
 AGameServer::AGameServer()
 {
     PrimaryActorTick.bCanEverTick = true;
@@ -28,27 +33,89 @@ bool AGameServer::startServer()
     movementUpdateDelta = 1.0f / static_cast<float>(MovementUpdateTickRate);
     if (tcpServer)
     {
-        SPACEMMA_WARN("Attempted to start server but it's already up!");
+        SPACEMMA_CATEGORY_WARN(Gameplay, "Attempted to start server but it's already up!");
         return false;
     }
     if (MaxClients <= 0 || MaxClients > 255)
     {
-        SPACEMMA_ERROR("Invalid MaxClients value ({})!", MaxClients);
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid MaxClients value ({})!", MaxClients);
+        return false;
+    }
+    if (ReactorThreads < 0 || ReactorThreads > 255)
+    {
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid ReactorThreads value ({})!", ReactorThreads);
+        return false;
+    }
+    if (InterestFullRateRadius <= 0.0f || InterestReducedRateRadius < InterestFullRateRadius || InterestReducedRateDivisor <= 0)
+    {
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid interest management parameters ({}, {}, {})!",
+                       InterestFullRateRadius, InterestReducedRateRadius, InterestReducedRateDivisor);
+        return false;
+    }
+    if (ClientBandwidthBudget < 0)
+    {
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid ClientBandwidthBudget value ({})!", ClientBandwidthBudget);
+        return false;
+    }
+    if (OwnMovementUpdateDivisor <= 0)
+    {
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid OwnMovementUpdateDivisor value ({})!", OwnMovementUpdateDivisor);
+        return false;
+    }
+    if (MaxLagCompensation < 0.0f)
+    {
+        SPACEMMA_CATEGORY_ERROR(Gameplay, "Invalid MaxLagCompensation value ({})!", MaxLagCompensation);
         return false;
     }
-    SPACEMMA_DEBUG("Starting server...");
+    SPACEMMA_CATEGORY_DEBUG(Gameplay, "Starting server...");
+    gameClientData = std::vector<GameClientData>(static_cast<size_t>(MaxClients));
+    expiredDisconnects.reserve(MaxClients);
+    playerStates = std::make_unique<PlayerStateStore>(static_cast<unsigned char>(MaxClients));
+    movementEncoder = std::make_unique<MovementDeltaEncoder>(static_cast<unsigned char>(MaxClients));
+    // the cell size matches the largest query radius, so that every query visits at most 27 cells
+    interestGrid = std::make_unique<InterestGrid>(InterestReducedRateRadius);
+    bandwidthScheduler = std::make_unique<BandwidthScheduler>(static_cast<unsigned char>(MaxClients),
+                                                              static_cast<float>(ClientBandwidthBudget), getMaxWorldSnapshotSize(1));
+    lagCompensation = std::make_unique<LagCompensationHistory>(static_cast<unsigned char>(MaxClients));
+    quantizedMovement.assign(MaxClients, NetQuantizedMovement{});
+    serverStartTime = FPlatformTime::Seconds();
     bufferPool = std::make_unique<BufferPool>(1024 * 1024 * 1024);
-    tcpServer = std::make_unique<WinTCPMultiClientServer>(*bufferPool, static_cast<unsigned char>(MaxClients));
+    const unsigned char networkThreads = ReactorThreads ? static_cast<unsigned char>(ReactorThreads)
+                                                        : WorkerPool::getDefaultThreadCount();
+#if PLATFORM_LINUX
+    tcpServer = std::make_unique<EpollTCPMultiClientServer>(*bufferPool, static_cast<unsigned char>(MaxClients),
+                                                            networkThreads);
+#else
+    tcpServer = std::make_unique<WinTCPMultiClientServer>(*bufferPool, static_cast<unsigned char>(MaxClients),
+                                                          networkThreads);
+#endif
+    tcpServer->setEventHandler(handleClientEvent, this);
+    tcpServer->setThreadSettings(static_cast<uint64_t>(NetworkThreadAffinity),
+                                 RaiseNetworkThreadPriority ? ThreadPriority::High : ThreadPriority::Normal);
     if (tcpServer->bindAndListen(StringCast<ANSICHAR>(*ServerIpAddress).Get(), ServerPort))
     {
-        acceptThread = new WinThread();
+        if (GameThreadAffinity)
+        {
+            FPlatformProcess::SetThreadAffinityMask(static_cast<uint64>(GameThreadAffinity));
+        }
+        acceptThread = new PlatformThread();
+        configureNetworkThread(acceptThread, "srv-accept");
         acceptThread->run(threadAcceptClients, this);
+        reaperThread = new PlatformThread();
+        reaperThread->setName("srv-reaper");
+        reaperThread->run(threadReapClients, this);
         SetActorTickEnabled(true);
         return true;
     }
-    SPACEMMA_ERROR("Game server initialization failed!");
+    SPACEMMA_CATEGORY_ERROR(Gameplay, "Game server initialization failed!");
     bufferPool.reset();
     tcpServer.reset();
+    gameClientData.clear();
+    playerStates.reset();
+    movementEncoder.reset();
+    interestGrid.reset();
+    bandwidthScheduler.reset();
+    lagCompensation.reset();
     return false;
 }
 
@@ -61,47 +128,56 @@ bool AGameServer::stopServer()
 {
     std::lock_guard lock(startStopMutex);
     SetActorTickEnabled(false);
-    SPACEMMA_DEBUG("Stopping server...");
+    SPACEMMA_CATEGORY_DEBUG(Gameplay, "Stopping server...");
     if (tcpServer)
     {
-        SPACEMMA_DEBUG("Interrupting threads...");
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Interrupting threads...");
         acceptThread->interrupt();
-        SPACEMMA_DEBUG("Closing tcpServer...");
+        // the reaper closes the connections still queued for it before it stops
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Stopping reaperThread...");
+        reaperThread->interrupt();
+        reapSignal.notify();
+        reaperThread->join();
+        delete reaperThread;
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Closing tcpServer...");
         tcpServer->close();
-        SPACEMMA_DEBUG("Joining threads...");
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Joining threads...");
         acceptThread->join();
         delete acceptThread;
-        for (const auto& pair : gameClientData)
-        {
-            SPACEMMA_DEBUG("Cleaning up player {}...");
-            SPACEMMA_DEBUG("Closing sendThread...");
-            pair.second.sendThread->interrupt();
-            pair.second.sendThread->join();
-            delete pair.second.sendThread;
-            SPACEMMA_DEBUG("Closing receiveThread...");
-            pair.second.receiveThread->interrupt();
-            pair.second.receiveThread->join();
-            delete pair.second.receiveThread;
-            SPACEMMA_DEBUG("Removing send buffers...");
-            for (ByteBuffer* buff : pair.second.sendBuffers->buffers)
+        for (const GameClientData& data : gameClientData)
+        {
+            if (!data.id)
             {
-                bufferPool->freeBuffer(buff);
+                continue;
             }
-            delete pair.second.sendBuffers;
+            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Cleaning up player {}...", data.id.load());
+            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Removing send buffers...");
+            clearSendBuffers(data.sendBuffers);
+            delete data.sendBuffers;
         }
-        SPACEMMA_DEBUG("Removing receivedPackets...");
-        for (const auto& pair : receivedPackets)
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Removing receivedPackets...");
+        std::pair<unsigned short, ByteBuffer*> received;
+        while (receivedPackets.pop(received))
         {
-            bufferPool->freeBuffer(pair.second);
+            bufferPool->freeBuffer(received.second);
         }
-        receivedPackets.clear();
         liveClients.clear();
         playersAwaitingSpawn.clear();
         disconnectingPlayersWithTimeouts.clear();
         gameClientData.clear();
-        SPACEMMA_DEBUG("Resetting tcpServer...");
+        playerStates.reset();
+        movementEncoder.reset();
+        interestGrid.reset();
+        bandwidthScheduler.reset();
+        lagCompensation.reset();
+        if (GameThreadAffinity)
+        {
+            // the engine pins the game thread to this mask at startup
+            FPlatformProcess::SetThreadAffinityMask(FPlatformAffinity::GetMainGameMask());
+        }
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Resetting tcpServer...");
         tcpServer.reset();
-        SPACEMMA_DEBUG("Resetting bufferPool...");
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Resetting bufferPool...");
         bufferPool.reset();
         return true;
     }
@@ -125,228 +201,389 @@ void AGameServer::EndPlay(const EEndPlayReason::Type EndPlayReason)
     Super::EndPlay(EndPlayReason);
 }
 
+void AGameServer::configureNetworkThread(Thread* thread, const std::string& name) const
+{
+    thread->setName(name);
+    thread->setAffinity(static_cast<uint64_t>(NetworkThreadAffinity));
+    thread->setPriority(RaiseNetworkThreadPriority ? ThreadPriority::High : ThreadPriority::Normal);
+}
+
 void AGameServer::threadAcceptClients(gsl::not_null<Thread*> thread, void* server)
 {
     AGameServer* srv = reinterpret_cast<AGameServer*>(server);
-    SPACEMMA_DEBUG("Starting threadAcceptClients...");
+    SPACEMMA_CATEGORY_DEBUG(Net, "Starting threadAcceptClients...");
     do
     {
-        if (srv->gameClientData.size() < srv->MaxClients)
+        if (srv->tcpServer->getClientCount() < srv->MaxClients)
         {
-            unsigned short port = srv->tcpServer->acceptClient();
-            if (port)
+            unsigned short client = srv->tcpServer->acceptClient();
+            if (client)
             {
-                SPACEMMA_INFO("Accepted client #{}!", port);
-                std::lock_guard lock(srv->connectionMutex);
-                GameClientData data{};
-                data.sendThread = new WinThread();
-                data.receiveThread = new WinThread();
-                data.sendBuffers = new ClientBuffers{};
-                srv->gameClientData.insert({ port, data });
-                ThreadArgs args{ srv, port, false };
-                data.sendThread->run(threadSend, &args);
-                while (!args.received);
-                args.received = false;
-                data.receiveThread->run(threadReceive, &args);
-                while (!args.received);
-                SPACEMMA_DEBUG("Providing player ID...");
-                srv->sendPacketTo(port, S2C_ProvidePlayerId{ S2C_HProvidePlayerId, {}, port });
-                std::lock_guard lock1(srv->unverifiedPlayersMutex);
-                srv->unverifiedPlayers.insert(port);
+                SPACEMMA_CATEGORY_INFO(Net, "Accepted client #{}!", client);
+                {
+                    // disconnectClient resets the slot's data under the same lock before the slot can be reused
+                    std::lock_guard lock(srv->connectionMutex);
+                    GameClientData& data = srv->gameClientData[getClientSlot(client)];
+                    data.sendBuffers = new ClientBuffers{ srv->gameClientData.size(), SEND_CONFLATION_KINDS };
+                    {
+                        std::lock_guard lock1(srv->unverifiedPlayersMutex);
+                        data.unverified = true;
+                    }
+                    data.id.store(client, std::memory_order_release);
+                }
+                // the client's events are reported only now, so that its first packets find its data
+                if (!srv->tcpServer->startClient(client))
+                {
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to start client #{}! Closing connection.", client);
+                    ClientBuffers* sendBuffers;
+                    {
+                        std::lock_guard lock(srv->connectionMutex);
+                        GameClientData& data = srv->gameClientData[getClientSlot(client)];
+                        sendBuffers = data.sendBuffers;
+                        data.reset();
+                    }
+                    srv->reapClient(client, sendBuffers);
+                    continue;
+                }
+                SPACEMMA_CATEGORY_DEBUG(Net, "Providing player ID...");
+                srv->sendPacketTo(client, S2C_ProvidePlayerId{ S2C_HProvidePlayerId, {}, client });
             }
+        } else
+        {
+            thread->sleep(ACCEPT_FULL_RETRY_DELAY);
         }
     } while (!thread->isInterrupted());
-    SPACEMMA_DEBUG("Stopping threadAcceptClients...");
+    SPACEMMA_CATEGORY_DEBUG(Net, "Stopping threadAcceptClients...");
 }
 
-void AGameServer::threadSend(gsl::not_null<Thread*> thread, void* args)
+void AGameServer::threadReapClients(gsl::not_null<Thread*> thread, void* server)
 {
-    ThreadArgs* arg = reinterpret_cast<ThreadArgs*>(args);
-    AGameServer* srv = reinterpret_cast<AGameServer*>(arg->server);
-    unsigned short port = arg->port;
-    arg->received = true;
-    ClientBuffers* cb = srv->gameClientData[port].sendBuffers;
-    ByteBuffer* currentBuff{ nullptr };
-    SPACEMMA_DEBUG("Starting threadSend({})...", port);
+    AGameServer* srv = reinterpret_cast<AGameServer*>(server);
+    SPACEMMA_CATEGORY_DEBUG(Net, "Starting threadReapClients...");
     do
     {
+        srv->reapSignal.wait([srv, thread] { return !srv->reapedClients.isEmpty() || thread->isInterrupted(); });
+        srv->reapClients();
+    } while (!thread->isInterrupted());
+    srv->reapClients();
+    SPACEMMA_CATEGORY_DEBUG(Net, "Stopping threadReapClients...");
+}
+
+void AGameServer::handleClientEvent(ClientEvent event, unsigned short client, void* server)
+{
+    AGameServer* srv = reinterpret_cast<AGameServer*>(server);
+    switch (event)
+    {
+        case ClientEvent::Received:
         {
-            std::lock_guard lock(cb->bufferMutex);
-            if (!cb->buffers.empty())
+            while (ByteBuffer* buffer = srv->tcpServer->receiveFrom(client))
             {
-                currentBuff = cb->buffers[0];
-                cb->buffers.erase(cb->buffers.begin());
+                srv->pushReceivedPacket(client, buffer);
             }
+            break;
+        }
+        case ClientEvent::SendReady:
+        {
+            srv->flushSendBuffers(client);
+            break;
         }
-        if (currentBuff)
+        case ClientEvent::Disconnected:
         {
-            // Sleep below simulates lag
-            //Sleep(100);
-            bool sent = srv->tcpServer->sendTo(currentBuff, port);
-            //SPACEMMA_DEBUG("Sent packet {} to {}!", *reinterpret_cast<uint8_t*>(currentBuff->getPointer()), port);
-            srv->bufferPool->freeBuffer(currentBuff);
-            currentBuff = nullptr;
-            if (!sent && !srv->tcpServer->isConnected(port))
+            SPACEMMA_CATEGORY_ERROR(Net, "Connection to {} lost.", client);
+            // unverified clients are torn down as well, so that their slots are not held forever
+            if (srv->getClientData(client))
             {
-                SPACEMMA_ERROR("Connection to {} lost.", port);
-                if (srv->isClientLive(port))
-                {
-                    std::lock_guard lock1(srv->disconnectMutex);
-                    srv->disconnectingPlayersWithTimeouts[port] = 0.0f;
-                }
-                break;
+                std::lock_guard lock(srv->disconnectMutex);
+                srv->disconnectingPlayersWithTimeouts[client] = 0.0f;
             }
+            break;
         }
-    } while (!thread->isInterrupted());
-    SPACEMMA_DEBUG("Stopping threadSend({})...", port);
+    }
 }
 
-void AGameServer::threadReceive(gsl::not_null<Thread*> thread, void* args)
+void AGameServer::flushSendBuffers(unsigned short client)
 {
-    ThreadArgs* arg = reinterpret_cast<ThreadArgs*>(args);
-    AGameServer* srv = reinterpret_cast<AGameServer*>(arg->server);
-    unsigned short port = arg->port;
-    arg->received = true;
-    SPACEMMA_DEBUG("Starting threadReceive({})...", port);
-    do
+    ByteBuffer* toSend[SEND_BATCH_SIZE];
+    bool connected = true;
+    while (true)
     {
-        ByteBuffer* buffer = srv->tcpServer->receiveFrom(port);
-        if (buffer)
+        size_t count;
         {
-            std::lock_guard lock(srv->receiveMutex);
-            srv->receivedPackets.push_back({ port, buffer });
-        } else if (!srv->tcpServer->isConnected(port))
+            // disconnectClient removes the send buffers under the same lock
+            std::lock_guard lock(connectionMutex);
+            const GameClientData* data = getClientData(client);
+            if (!data)
+            {
+                return;
+            }
+            count = data->sendBuffers->buffers.popBulk(toSend);
+        }
+        if (!count)
         {
-            SPACEMMA_ERROR("Connection to {} lost.", port);
-            if (srv->isClientLive(port))
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (connected && !tcpServer->sendTo(toSend[i], client) && !tcpServer->isConnected(client))
             {
-                std::lock_guard lock1(srv->disconnectMutex);
-                srv->disconnectingPlayersWithTimeouts[port] = 0.0f;
+                SPACEMMA_CATEGORY_ERROR(Net, "Connection to {} lost.", client);
+                connected = false;
+                if (getClientData(client))
+                {
+                    std::lock_guard lock(disconnectMutex);
+                    disconnectingPlayersWithTimeouts[client] = 0.0f;
+                }
             }
-            break;
+            bufferPool->freeBuffer(toSend[i]);
         }
-    } while (!thread->isInterrupted());
-    SPACEMMA_DEBUG("Stopping threadReceive({})...", port);
+        if (connected && tcpServer->hasPendingOutput(client))
+        {
+            // the rest stays queued, where it can still be conflated, until the server reports the socket writable again
+            return;
+        }
+    }
+}
+
+void AGameServer::clearSendBuffers(gsl::not_null<ClientBuffers*> buffers)
+{
+    ByteBuffer* toFree[SEND_BATCH_SIZE];
+    while (size_t count = buffers->buffers.popBulk(toFree))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            bufferPool->freeBuffer(toFree[i]);
+        }
+    }
 }
 
-void AGameServer::sendToAll(gsl::not_null<ByteBuffer*> buffer)
+void AGameServer::pushReceivedPacket(unsigned short client, gsl::not_null<ByteBuffer*> buffer)
 {
-    std::lock_guard lock(connectionMutex);
+    if (!receivedPackets.push({ client, buffer }))
+    {
+        SPACEMMA_CATEGORY_ERROR_LIMITED(Net, "The received packet queue is full! Dropping {} data from {}.", buffer->getUsedSize(), client);
+        bufferPool->freeBuffer(buffer);
+    }
+}
+
+void AGameServer::sendToAll(const SharedByteBuffer& buffer)
+{
+    if (!buffer)
+    {
+        return;
+    }
+    std::lock_guard lock(liveClientsMutex);
     for (unsigned short port : liveClients)
     {
-        //todo: implement refcounted buffers or something like that, right now the buffer is just copied for each client
-        ByteBuffer* buff = bufferPool->getBuffer(buffer->getUsedSize());
-        memcpy(buff->getPointer(), buffer->getPointer(), buffer->getUsedSize());
-        sendTo(port, buff);
+        sendTo(port, buffer.share());
     }
 }
 
-void AGameServer::sendToAllBut(gsl::not_null<ByteBuffer*> buffer, unsigned short ignoredClient)
+void AGameServer::sendToAllBut(const SharedByteBuffer& buffer, unsigned short ignoredClient)
 {
-    std::lock_guard lock(connectionMutex);
+    if (!buffer)
+    {
+        return;
+    }
+    std::lock_guard lock(liveClientsMutex);
     for (unsigned short port : liveClients)
     {
         if (port != ignoredClient)
         {
-            //todo: implement refcounted buffers or something like that, right now the buffer is just copied for each client
-            ByteBuffer* buff = bufferPool->getBuffer(buffer->getUsedSize());
-            memcpy(buff->getPointer(), buffer->getPointer(), buffer->getUsedSize());
-            sendTo(port, buff);
+            sendTo(port, buffer.share());
         }
     }
 }
 
-void AGameServer::sendToAllBut(gsl::not_null<ByteBuffer*> buffer, unsigned short ignoredClient1, unsigned short ignoredClient2)
+void AGameServer::sendToAllBut(const SharedByteBuffer& buffer, unsigned short ignoredClient1, unsigned short ignoredClient2)
 {
-    std::lock_guard lock(connectionMutex);
+    if (!buffer)
+    {
+        return;
+    }
+    std::lock_guard lock(liveClientsMutex);
     for (unsigned short port : liveClients)
     {
         if (port != ignoredClient1 && port != ignoredClient2)
         {
-            //todo: implement refcounted buffers or something like that, right now the buffer is just copied for each client
-            ByteBuffer* buff = bufferPool->getBuffer(buffer->getUsedSize());
-            memcpy(buff->getPointer(), buffer->getPointer(), buffer->getUsedSize());
-            sendTo(port, buff);
+            sendTo(port, buffer.share());
         }
     }
 }
 
 void AGameServer::sendTo(unsigned short client, gsl::not_null<ByteBuffer*> buffer)
 {
-    ClientBuffers* buffers = gameClientData[client].sendBuffers;
-    std::lock_guard lock(buffers->bufferMutex);
-    buffers->buffers.push_back(buffer);
+    const GameClientData* data = getClientData(client);
+    if (!data)
+    {
+        SPACEMMA_CATEGORY_WARN_LIMITED(Net, "Dropping {} data for {}. Client not found!", buffer->getUsedSize(), client);
+        bufferPool->freeBuffer(buffer);
+        return;
+    }
+    ClientSendQueue& buffers = data->sendBuffers->buffers;
+    size_t subject, kind;
+    ByteBuffer* replaced = nullptr;
+    bool pushed;
+    if (!getSendSubject(buffer, subject, kind))
+    {
+        pushed = buffers.push(buffer);
+    } else if (kind < SEND_CONFLATION_KINDS)
+    {
+        pushed = buffers.pushLatest(buffer, subject, kind, replaced);
+    } else
+    {
+        pushed = buffers.push(buffer, subject);
+    }
+    if (replaced)
+    {
+        bufferPool->freeBuffer(replaced);
+    }
+    if (!pushed)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "The send queue of {} is full! Disconnecting the client.", client);
+        bufferPool->freeBuffer(buffer);
+        std::lock_guard lock(disconnectMutex);
+        disconnectingPlayersWithTimeouts[client] = 0.0f;
+        return;
+    }
+    tcpServer->scheduleSend(client);
+}
+
+bool AGameServer::getSendSubject(gsl::not_null<const ByteBuffer*> buffer, size_t& subject, size_t& kind) const
+{
+    switch (buffer->getUsedSize() ? *buffer->getPointer() : static_cast<uint8_t>(S2C_HInvalidData))
+    {
+        case S2C_HPlayerMovement:
+            kind = buffer->getUsedSize() == sizeof(S2C_PlayerMovement) ? 0 : SEND_CONFLATION_KINDS;
+            break;
+        case S2C_HQuantizedPlayerMovement:
+            kind = buffer->getUsedSize() == sizeof(S2C_QuantizedPlayerMovement) ? 1 : SEND_CONFLATION_KINDS;
+            break;
+        case B2B_HRotate:
+            kind = buffer->getUsedSize() == sizeof(B2B_Rotate) ? 2 : SEND_CONFLATION_KINDS;
+            break;
+        case B2B_HUpdateVelocity:
+            kind = buffer->getUsedSize() == sizeof(B2B_UpdateVelocity) ? 3 : SEND_CONFLATION_KINDS;
+            break;
+        case S2C_HCreatePlayer:
+        case S2C_HDestroyPlayer:
+        case B2B_HRopeAttach:
+        case B2B_HRopeDetach:
+        case B2B_HDeadPlayer:
+        case B2B_HRespawnPlayer:
+            kind = SEND_CONFLATION_KINDS;
+            break;
+        default:
+            return false;
+    }
+    if (buffer->getUsedSize() < 2 * sizeof(uint16_t))
+    {
+        return false;
+    }
+    // all of these packets start with the header, a padding or length byte and the ID of the player they describe
+    uint16_t playerId;
+    memcpy(&playerId, buffer->getPointer() + sizeof(uint16_t), sizeof(uint16_t));
+    const unsigned char playerSlot = getClientSlot(playerId);
+    if (playerSlot >= gameClientData.size())
+    {
+        return false;
+    }
+    subject = playerSlot;
+    return true;
 }
 
 void AGameServer::disconnectClient(unsigned short client)
 {
-    SPACEMMA_WARN("Disconnecting player {}...", client);
+    SPACEMMA_CATEGORY_WARN(Gameplay, "Disconnecting player {}...", client);
     {
         std::lock_guard lock(liveClientsMutex);
-        const auto lcit = liveClients.find(client);
+        const auto lcit = std::find(liveClients.begin(), liveClients.end(), client);
         if (lcit != liveClients.end())
         {
-            SPACEMMA_DEBUG("Removing liveClients reference...");
+            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Removing liveClients reference...");
             liveClients.erase(lcit);
         }
     }
-    const std::map<unsigned short, GameClientData>::iterator& pair = gameClientData.find(client);
-    if (pair != gameClientData.end())
+    ClientBuffers* sendBuffers;
     {
-        SPACEMMA_DEBUG("Stopping player's receiveThread...");
-        tcpServer->closeClient(client);
-        pair->second.receiveThread->interrupt();
-        pair->second.receiveThread->join();
-        delete pair->second.receiveThread;
-        SPACEMMA_DEBUG("Stopping player's sendThread...");
-        pair->second.sendThread->interrupt();
-        pair->second.sendThread->join();
-        delete pair->second.sendThread;
-        SPACEMMA_DEBUG("Removing player's send buffers...");
-        for (auto buff : pair->second.sendBuffers->buffers)
+        // the network threads flush the send buffers under the same lock, so they no longer touch them once the data is reset
+        std::lock_guard lock(connectionMutex);
+        GameClientData* data = getClientData(client);
+        if (!data)
+        {
+            return;
+        }
+        data->live.store(false, std::memory_order_release);
+        playerStates->deactivate(getClientSlot(client));
+        // stops the traffic at once, the accept thread takes over the slot only once the reaper closes the connection
+        tcpServer->shutdownClient(client);
+        if (data->player)
         {
-            bufferPool->freeBuffer(buff);
+            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Removing player's actor...");
+            data->player->Destroy();
         }
-        delete pair->second.sendBuffers;
-        if (pair->second.player)
+        sendBuffers = data->sendBuffers;
+        data->reset();
+    }
+    sendPacketToAll(S2C_DestroyPlayer{ S2C_HDestroyPlayer, {}, client });
+    if (reapedClients.push({ client, sendBuffers }))
+    {
+        reapSignal.notify();
+    } else
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "The reaper queue is full! Closing the connection to {} on the game thread.", client);
+        reapClient(client, sendBuffers);
+    }
+}
+
+void AGameServer::reapClients()
+{
+    std::pair<unsigned short, ClientBuffers*> reaped[REAP_BATCH_SIZE];
+    while (size_t count = reapedClients.popBulk(reaped))
+    {
+        for (size_t i = 0; i < count; ++i)
         {
-            SPACEMMA_DEBUG("Removing player's actor...");
-            pair->second.player->Destroy();
+            reapClient(reaped[i].first, reaped[i].second);
         }
-        sendPacketToAll(S2C_DestroyPlayer{ S2C_HDestroyPlayer, {}, client });
     }
-    gameClientData.erase(pair);
 }
 
-void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteBuffer*> buffer)
+void AGameServer::reapClient(unsigned short client, ClientBuffers* sendBuffers)
+{
+    SPACEMMA_CATEGORY_DEBUG(Net, "Closing the connection to {}...", client);
+    tcpServer->closeClient(client);
+    clearSendBuffers(sendBuffers);
+    delete sendBuffers;
+}
+
+void AGameServer::processPacket(unsigned short sourceClient, gsl::span<uint8_t> span)
 {
-    gsl::span<uint8_t> span = buffer->getSpan();
     size_t buffPos = 0;
     bool dataValid = true;
     if (!isClientLive(sourceClient))
     {
+        GameClientData* sourceData = getClientData(sourceClient);
         bool unverified;
         {
             std::lock_guard lock(unverifiedPlayersMutex);
-            unverified = unverifiedPlayers.find(sourceClient) != unverifiedPlayers.end();
+            unverified = sourceData && sourceData->unverified;
         }
         if (unverified)
         {
-            SPACEMMA_INFO("Player {} is unverified. Expecting C2S_InitConnection.");
+            SPACEMMA_CATEGORY_INFO(Gameplay, "Player {} is unverified. Expecting C2S_InitConnection.", sourceClient);
             Header header = static_cast<Header>(span[buffPos]);
             if (header == C2S_HInitConnection)
             {
                 C2S_InitConnection packet;
                 if (reinterpretPacket(span, buffPos, packet))
                 {
-                    SPACEMMA_INFO("C2S_InitConnection: '{}', '{}'", packet.mapName, packet.nickname);
+                    SPACEMMA_CATEGORY_INFO(Gameplay, "C2S_InitConnection: '{}', '{}'", packet.mapName, packet.nickname);
                     bool mapValid = packet.mapName == mapName, nicknameValid = true;
                     if (mapValid)
                     {
 
-                        for (const auto& playerData : gameClientData)
+                        for (const GameClientData& playerData : gameClientData)
                         {
-                            if (playerData.second.nickname == packet.nickname)
+                            if (playerData.id && playerData.nickname == packet.nickname)
                             {
                                 nicknameValid = false;
                                 break;
@@ -357,15 +594,15 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                     {
                         if (nicknameValid)
                         {
-                            SPACEMMA_INFO("Player {} identified with nickname '{}'!", sourceClient, packet.nickname);
-                            gameClientData[sourceClient].nickname = packet.nickname;
+                            SPACEMMA_CATEGORY_INFO(Gameplay, "Player {} identified with nickname '{}'!", sourceClient, packet.nickname);
+                            sourceData->nickname = packet.nickname;
                             std::lock_guard lock1(spawnAwaitingMutex);
                             playersAwaitingSpawn.insert(sourceClient);
                             std::lock_guard lock2(unverifiedPlayersMutex);
-                            unverifiedPlayers.erase(sourceClient);
+                            sourceData->unverified = false;
                         } else
                         {
-                            SPACEMMA_WARN("Player {} provided invalid nickname '{}'. Closing connection.");
+                            SPACEMMA_CATEGORY_WARN(Gameplay, "Player {} provided invalid nickname '{}'. Closing connection.", sourceClient, packet.nickname);
                             ByteBuffer* buff = bufferPool->getBuffer(1);
                             *buff->getPointer() = S2C_HInvalidNickname;
                             tcpServer->sendTo(buff, sourceClient);
@@ -376,7 +613,7 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                         }
                     } else
                     {
-                        SPACEMMA_WARN("Player {} is playing on a different map ('{}' != '{}'). Closing connection.", sourceClient, mapName, packet.mapName);
+                        SPACEMMA_CATEGORY_WARN(Gameplay, "Player {} is playing on a different map ('{}' != '{}'). Closing connection.", sourceClient, mapName, packet.mapName);
                         S2C_InvalidMap invalidMapPacket{
                             S2C_HInvalidMap,
                             mapName.length(),
@@ -398,10 +635,10 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 std::lock_guard lock(disconnectMutex);
                 if (disconnectingPlayersWithTimeouts.find(sourceClient) != disconnectingPlayersWithTimeouts.end())
                 {
-                    SPACEMMA_WARN("Ignoring packet from player {} who is being disconnected.", sourceClient);
+                    SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Ignoring packet from player {} who is being disconnected.", sourceClient);
                 } else
                 {
-                    SPACEMMA_WARN("Player {} did not authorise. Closing connection.", sourceClient);
+                    SPACEMMA_CATEGORY_WARN(Gameplay, "Player {} did not authorise. Closing connection.", sourceClient);
                     ByteBuffer* buff = bufferPool->getBuffer(1);
                     *buff->getPointer() = S2C_HInvalidData;
                     tcpServer->sendTo(buff, sourceClient);
@@ -412,7 +649,7 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
             }
         } else
         {
-            SPACEMMA_WARN("Rejecting packet from client {} that is not live.", sourceClient);
+            SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Rejecting packet from client {} that is not live.", sourceClient);
             return;
         }
     }
@@ -426,63 +663,62 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 C2S_Shoot* packet = reinterpretPacket<C2S_Shoot>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("C2S_Shoot: {}, [{},{},{}], [{},{},{}]",
+                    SPACEMMA_CATEGORY_DEBUG(Gameplay, "C2S_Shoot: {}, [{},{},{}], [{},{},{}], {}",
                                    packet->playerId, packet->location.x, packet->location.y, packet->location.z,
-                                   packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
+                                   packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll, packet->serverTime);
                     uint16_t shootDistance = 10000;
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    if (GameClientData* shooterData = getLiveClientData(packet->playerId))
                     {
-                        GameClientData& clientData = gameClientData[packet->playerId];
+                        GameClientData& clientData = *shooterData;
                         FHitResult hitResult;
                         FVector startLocation = packet->location.asFVector();
-
-                        if (GetWorld()->LineTraceSingleByChannel(hitResult, startLocation,
-                                                                 startLocation + clientData.player->GetActorForwardVector() * shootDistance,
-                                                                 ECC_Visibility))
+                        const FVector direction = clientData.player->GetActorForwardVector();
+                        // the players are judged against their rewound capsules, so the world is only traced for obstacles
+                        FCollisionQueryParams queryParams{};
+                        for (unsigned short player : liveClients)
+                        {
+                            queryParams.AddIgnoredActor(gameClientData[getClientSlot(player)].player);
+                        }
+                        if (GetWorld()->LineTraceSingleByChannel(hitResult, startLocation, startLocation + direction * shootDistance,
+                                                                 ECC_Visibility, queryParams))
                         {
                             shootDistance = hitResult.Distance;
-                            if (hitResult.Actor.IsValid())
+                        }
+                        unsigned short otherPlayer;
+                        float hitDistance;
+                        if (lagCompensation->raycast(startLocation, direction, shootDistance, getRewindTime(packet->serverTime),
+                                                     liveClients, packet->playerId, otherPlayer, hitDistance))
+                        {
+                            shootDistance = static_cast<uint16_t>(hitDistance);
+                            GameClientData& otherPlayerData = gameClientData[getClientSlot(otherPlayer)];
+                            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Shooter object name: {}", StringCast<ANSICHAR>(*clientData.player->GetName()).Get());
+                            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Shooted object name: {}", StringCast<ANSICHAR>(*otherPlayerData.player->GetName()).Get());
+                            if (otherPlayerData.player->GetHealth() > 0.0f)
                             {
-                                FString name = hitResult.Actor->GetName();
-                                SPACEMMA_DEBUG("Shooter object name: {}", StringCast<ANSICHAR>(*gameClientData[packet->playerId].player->GetName()).Get());
-                                SPACEMMA_DEBUG("Shooted object name: {}", StringCast<ANSICHAR>(*name).Get());
-                                for (unsigned short otherPlayer : liveClients)
+                                sendPacketTo(packet->playerId, S2C_EnemyReceivedDamage{ S2C_HEnemyReceivedDamage });
+
+                                //TODO:change chardcoded damage value;
+                                uint16_t damage = 20;
+                                sendPacketTo(otherPlayer, S2C_Damage{ S2C_HDamage, {}, otherPlayer, 20 });
+                                SPACEMMA_CATEGORY_DEBUG(Gameplay, "Shooted object healt points: {}", otherPlayerData.player->GetHealth());
+
+                                const bool isPlayerDead = otherPlayerData.player->TakeDamage(20.0f);
+                                if (isPlayerDead)
                                 {
-                                    if (otherPlayer != packet->playerId)
-                                    {
-                                        GameClientData& otherPlayerData = gameClientData[otherPlayer];
-                                        if (otherPlayerData.player->GetName() == hitResult.Actor->GetName())
-                                        {
-                                            if (otherPlayerData.player->GetHealth() <= 0.0f)
-                                                break;
-                                            sendPacketTo(packet->playerId, S2C_EnemyReceivedDamage{ S2C_HEnemyReceivedDamage });
-
-                                            //TODO:change chardcoded damage value;
-                                            uint16_t damage = 20;
-                                            sendPacketTo(otherPlayer, S2C_Damage{ S2C_HDamage, {}, otherPlayer, 20 });
-                                            SPACEMMA_DEBUG("Shooted object healt points: {}", otherPlayerData.player->GetHealth());
-
-                                            const bool isPlayerDead = otherPlayerData.player->TakeDamage(20.0f);
-                                            if (isPlayerDead)
-                                            {
-                                                SPACEMMA_DEBUG("Shooted object health points: {}", otherPlayerData.player->GetHealth());
-                                                ++clientData.kills;
-                                                ++otherPlayerData.deaths;
-                                                SPACEMMA_DEBUG("S2C_UpdateScoreboard: {}, {}", packet->playerId, otherPlayer);
-                                                sendPacketToAll(S2C_UpdateScoreboard{ S2C_HUpdateScoreboard, packet->playerId, otherPlayer });
-                                            }
-                                            break;
-                                        }
-                                    }
+                                    SPACEMMA_CATEGORY_DEBUG(Gameplay, "Shooted object health points: {}", otherPlayerData.player->GetHealth());
+                                    ++clientData.kills;
+                                    ++otherPlayerData.deaths;
+                                    SPACEMMA_CATEGORY_DEBUG(Gameplay, "S2C_UpdateScoreboard: {}, {}", packet->playerId, otherPlayer);
+                                    sendPacketToAll(S2C_UpdateScoreboard{ S2C_HUpdateScoreboard, packet->playerId, otherPlayer });
                                 }
-                            } else
-                            {
-                                SPACEMMA_DEBUG("Shooted nothing!");
                             }
+                        } else
+                        {
+                            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Shooted nothing!");
                         }
                     } else
                     {
-                        SPACEMMA_WARN("Failed to shoot for {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to shoot for {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(S2C_Shoot{ S2C_HShoot, {}, packet->playerId, shootDistance, packet->location, packet->rotator }, sourceClient);
                 } else
@@ -496,14 +732,14 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_UpdateVelocity* packet = reinterpretPacket<B2B_UpdateVelocity>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_DEBUG("B2B_UpdateVelocity: {}, [{},{},{}]",
+                    SPACEMMA_CATEGORY_DEBUG(Gameplay, "B2B_UpdateVelocity: {}, [{},{},{}]",
                                    packet->playerId, packet->velocity.x, packet->velocity.y, packet->velocity.z);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->GetCharacterMovement()->Velocity = (packet->velocity.asFVector());
+                        playerData->player->GetCharacterMovement()->Velocity = (packet->velocity.asFVector());
                     } else
                     {
-                        SPACEMMA_WARN("Failed to update velocity of {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to update velocity of {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -517,14 +753,14 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_Rotate* packet = reinterpretPacket<B2B_Rotate>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_Rotate: {}, [{},{},{}]", packet->playerId,
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "B2B_Rotate: {}, [{},{},{}]", packet->playerId,
                                    packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->SetActorRotation(packet->rotator.asFRotator());
+                        playerData->player->SetActorRotation(packet->rotator.asFRotator());
                     } else
                     {
-                        SPACEMMA_WARN("Failed to change rotation of {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to change rotation of {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -538,14 +774,14 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_RopeAttach* packet = reinterpretPacket<B2B_RopeAttach>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_RopeAttach: {}, [{},{},{}]", packet->playerId,
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "B2B_RopeAttach: {}, [{},{},{}]", packet->playerId,
                                    packet->attachPosition.x, packet->attachPosition.y, packet->attachPosition.z);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->AttachRope(packet->attachPosition.asFVector(), false);
+                        playerData->player->AttachRope(packet->attachPosition.asFVector(), false);
                     } else
                     {
-                        SPACEMMA_WARN("Failed to attach rope for {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to attach rope for {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -559,13 +795,13 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_RopeDetach* packet = reinterpretPacket<B2B_RopeDetach>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_RopeDetach: {}", packet->playerId);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "B2B_RopeDetach: {}", packet->playerId);
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->DetachRope(false);
+                        playerData->player->DetachRope(false);
                     } else
                     {
-                        SPACEMMA_WARN("Failed to detach rope for {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to detach rope for {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -579,13 +815,13 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_DeadPlayer* packet = reinterpretPacket<B2B_DeadPlayer>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_DeadPlayer: {}", packet->playerId);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "B2B_DeadPlayer: {}", packet->playerId);
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->DeadPlayer();
+                        playerData->player->DeadPlayer();
                     } else
                     {
-                        SPACEMMA_WARN("Failed to dead player {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to dead player {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -599,15 +835,17 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 B2B_RespawnPlayer* packet = reinterpretPacket<B2B_RespawnPlayer>(span, buffPos);
                 if (packet)
                 {
-                    SPACEMMA_TRACE("B2B_RespawnPlayer: {}, [{},{},{}], [{},{},{}]",
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "B2B_RespawnPlayer: {}, [{},{},{}], [{},{},{}]",
                                    packet->playerId, packet->location.x, packet->location.y, packet->location.z,
                                    packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
-                    if (liveClients.find(packet->playerId) != liveClients.end())
+                    if (GameClientData* playerData = getLiveClientData(packet->playerId))
                     {
-                        gameClientData[packet->playerId].player->RespawnPlayer(packet->location.asFVector(), packet->rotator.asFRotator());
+                        playerData->player->RespawnPlayer(packet->location.asFVector(), packet->rotator.asFRotator());
+                        // shots are not judged against the capsules moving from where the player died
+                        lagCompensation->reset(getClientSlot(packet->playerId));
                     } else
                     {
-                        SPACEMMA_WARN("Failed to dead player {}. Player not found!", packet->playerId);
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to dead player {}. Player not found!", packet->playerId);
                     }
                     sendPacketToAllBut(*packet, sourceClient);
                 } else
@@ -616,9 +854,61 @@ void AGameServer::processPacket(unsigned short sourceClient, gsl::not_null<ByteB
                 }
                 break;
             }
+            case C2S_HAckMovement:
+            {
+                C2S_AckMovement* packet = reinterpretPacket<C2S_AckMovement>(span, buffPos);
+                if (packet)
+                {
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "C2S_AckMovement: {}, {}, {}", sourceClient, packet->sequence, packet->resync);
+                    movementEncoder->acknowledge(getClientSlot(sourceClient), packet->sequence, packet->resync != 0U);
+                } else
+                {
+                    dataValid = false;
+                }
+                break;
+            }
+            case C2S_HMovementInput:
+            {
+                C2S_MovementInput* packet = reinterpretPacket<C2S_MovementInput>(span, buffPos);
+                if (packet)
+                {
+                    SPACEMMA_CATEGORY_TRACE(Gameplay, "C2S_MovementInput: {}, {:x}, {}, {}, [{},{},{}], [{},{},{}]", sourceClient, packet->fields,
+                                   packet->sequence, packet->clientTime, packet->velocity.x, packet->velocity.y, packet->velocity.z,
+                                   packet->rotator.pitch, packet->rotator.yaw, packet->rotator.roll);
+                    GameClientData* playerData = getLiveClientData(sourceClient);
+                    if (!playerData)
+                    {
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to apply movement input of {}. Player not found!", sourceClient);
+                        break;
+                    }
+                    if (playerData->predicted && static_cast<int16_t>(packet->sequence - playerData->inputSequence) <= 0)
+                    {
+                        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Discarding outdated movement input {} of {}.", packet->sequence, sourceClient);
+                        break;
+                    }
+                    if (packet->fields & MI_Velocity)
+                    {
+                        playerData->player->GetCharacterMovement()->Velocity = packet->velocity.asFVector();
+                        sendPacketToAllBut(B2B_UpdateVelocity{ B2B_HUpdateVelocity, {}, sourceClient, packet->velocity }, sourceClient);
+                    }
+                    if (packet->fields & MI_Rotation)
+                    {
+                        playerData->player->SetActorRotation(packet->rotator.asFRotator());
+                        sendPacketToAllBut(B2B_Rotate{ B2B_HRotate, {}, sourceClient, packet->rotator }, sourceClient);
+                    }
+                    playerData->predicted = true;
+                    playerData->inputSequence = packet->sequence;
+                    playerData->inputClientTime = packet->clientTime;
+                    playerData->inputTime = FPlatformTime::Seconds();
+                } else
+                {
+                    dataValid = false;
+                }
+                break;
+            }
             default:
             {
-                SPACEMMA_ERROR("Received invalid packet header of {}! Discarding packet.", header);
+                SPACEMMA_CATEGORY_ERROR_LIMITED(Net, "Received invalid packet header of {}! Discarding packet.", header);
                 dataValid = false;
                 break;
             }
@@ -639,22 +929,35 @@ void AGameServer::handlePlayerAwaitingSpawn()
     }
     if (clientPort)
     {
-        SPACEMMA_DEBUG("Spawning player {}...", clientPort);
+        GameClientData* clientData = getClientData(clientPort);
+        if (!clientData)
+        {
+            SPACEMMA_CATEGORY_WARN(Gameplay, "Player {} disconnected before spawning.", clientPort);
+            return;
+        }
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Spawning player {}...", clientPort);
         FActorSpawnParameters params{};
         params.Name = FName(FString::Printf(TEXT("Player #%d"), static_cast<int32>(clientPort)));
         params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
         AShooterPlayer* actor = GetWorld()->SpawnActor<AShooterPlayer>(PlayerBP, FVector{ 100.0f, 100.0f, 100.0f },
                                                                        FRotator{}, params);
-        GameClientData& playerData = gameClientData[clientPort];
+        GameClientData& playerData = *clientData;
         playerData.player = actor;
-        playerData.recentPosition = actor->GetActorLocation();
-        playerData.recentRotation = actor->GetActorRotation();
+        const FVector position = actor->GetActorLocation();
+        const FRotator rotation = actor->GetActorRotation();
+        playerStates->activate(getClientSlot(clientPort), position, rotation, actor->GetCharacterMovement()->Velocity);
+        // the slot may have been used by a disconnected player, whose baselines are no longer valid
+        movementEncoder->resetReceiver(getClientSlot(clientPort));
+        movementEncoder->resetSubject(getClientSlot(clientPort));
+        bandwidthScheduler->resetReceiver(getClientSlot(clientPort));
+        bandwidthScheduler->resetSubject(getClientSlot(clientPort));
+        lagCompensation->reset(getClientSlot(clientPort));
         S2C_CreatePlayer createPlayerPacket{
             S2C_HCreatePlayer,
             playerData.nickname.length(),
             clientPort,
-            playerData.recentPosition,
-            playerData.recentRotation,
+            position,
+            rotation,
             (uint16)(RoundTime - currentRoundTime),
             playerData.kills,
             playerData.deaths,
@@ -662,17 +965,16 @@ void AGameServer::handlePlayerAwaitingSpawn()
         };
         {
             std::lock_guard lock(liveClientsMutex);
-            liveClients.insert(clientPort);
+            liveClients.push_back(clientPort);
+            playerData.live.store(true, std::memory_order_release);
         }
-        ByteBuffer* packetBuffer = createPacketBuffer(bufferPool.get(), createPlayerPacket);
-        sendToAll(packetBuffer);
-        bufferPool->freeBuffer(packetBuffer);
+        sendToAll(SharedByteBuffer{ *bufferPool, createPacketBuffer(bufferPool.get(), createPlayerPacket) });
         // tell the player about other players
         for (unsigned short port : liveClients)
         {
             if (port != clientPort)
             {
-                GameClientData& otherPlayerData = gameClientData[port];
+                GameClientData& otherPlayerData = gameClientData[getClientSlot(port)];
                 createPlayerPacket = {
                     S2C_HCreatePlayer,
                     static_cast<uint8_t>(otherPlayerData.nickname.length()),
@@ -684,105 +986,338 @@ void AGameServer::handlePlayerAwaitingSpawn()
                     otherPlayerData.deaths,
                     otherPlayerData.nickname
                 };
-                packetBuffer = createPacketBuffer(bufferPool.get(), createPlayerPacket);
-                sendTo(clientPort, packetBuffer);
-                bufferPool->freeBuffer(packetBuffer);
+                if (ByteBuffer* packetBuffer = createPacketBuffer(bufferPool.get(), createPlayerPacket))
+                {
+                    sendTo(clientPort, packetBuffer);
+                }
             }
         }
     }
 }
 
-void AGameServer::handlePendingDisconnect(float timeDelta)
+void AGameServer::handlePendingDisconnects(float timeDelta)
 {
-    unsigned short clientPortToDisconnect = 0;
+    expiredDisconnects.clear();
     {
         std::lock_guard lock(disconnectMutex);
-        if (!disconnectingPlayersWithTimeouts.empty())
+        std::map<unsigned short, float>::iterator pair = disconnectingPlayersWithTimeouts.begin();
+        while (pair != disconnectingPlayersWithTimeouts.end())
         {
-            std::map<unsigned short, float>::iterator pair = disconnectingPlayersWithTimeouts.begin();
             pair->second -= timeDelta;
             if (pair->second <= 0.0f)
             {
-                clientPortToDisconnect = pair->first;
-                disconnectingPlayersWithTimeouts.erase(pair);
+                expiredDisconnects.push_back(pair->first);
+                pair = disconnectingPlayersWithTimeouts.erase(pair);
+            } else
+            {
+                ++pair;
             }
         }
     }
-    if (clientPortToDisconnect)
+    // every disconnect only hands the connection over to the reaper, so a whole batch fits into a single tick
+    for (unsigned short client : expiredDisconnects)
     {
-        disconnectClient(clientPortToDisconnect);
+        disconnectClient(client);
     }
 }
 
 void AGameServer::processPendingPacket()
 {
-    ByteBuffer* buff = nullptr;
-    unsigned short clientPort = 0;
+    std::pair<unsigned short, ByteBuffer*> received;
+    if (receivedPackets.pop(received))
     {
-        std::lock_guard lock(receiveMutex);
-        if (!receivedPackets.empty())
+        processReceivedPacket(received.first, received.second);
+    }
+}
+
+void AGameServer::processAllPendingPackets()
+{
+    std::pair<unsigned short, ByteBuffer*> received[RECEIVE_BATCH_SIZE];
+    while (size_t count = receivedPackets.popBulk(received))
+    {
+        for (size_t i = 0; i < count; ++i)
         {
-            clientPort = receivedPackets[0].first;
-            buff = receivedPackets[0].second;
-            receivedPackets.erase(receivedPackets.begin());
+            processReceivedPacket(received[i].first, received[i].second);
         }
     }
-    if (buff)
+}
+
+void AGameServer::processReceivedPacket(unsigned short client, gsl::not_null<ByteBuffer*> buffer)
+{
+    gsl::span<uint8_t> frames = buffer->getSpan(), frame{};
+    size_t framePos = 0;
+    while (readFrame(frames, framePos, frame))
     {
-        processPacket(clientPort, buff);
-        bufferPool->freeBuffer(buff);
+        processPacket(client, frame);
     }
+    bufferPool->freeBuffer(buffer);
 }
 
-void AGameServer::processAllPendingPackets()
+void AGameServer::refreshPlayerStates()
 {
-    while (!receivedPackets.empty())
+    const uint32_t time = getSnapshotTime();
+    for (unsigned short client : liveClients)
     {
-        processPendingPacket();
+        const AShooterPlayer* player = gameClientData[getClientSlot(client)].player;
+        const FVector location = player->GetActorLocation();
+        playerStates->update(getClientSlot(client), location, player->GetActorRotation(),
+                             player->GetCharacterMovement()->Velocity);
+        const UCapsuleComponent* capsule = player->GetCapsuleComponent();
+        lagCompensation->record(getClientSlot(client), time, location, capsule->GetScaledCapsuleRadius(),
+                                capsule->GetScaledCapsuleHalfHeight());
     }
 }
 
 void AGameServer::broadcastPlayerMovement(unsigned short client)
 {
-    if (liveClients.find(client) != liveClients.end())
+    if (isClientLive(client))
     {
-        GameClientData& playerData = gameClientData[client];
-        sendPacketToAll(S2C_PlayerMovement{ S2C_HPlayerMovement, {}, client, playerData.player->GetActorLocation(),
-                           playerData.player->GetActorRotation(), playerData.player->GetCharacterMovement()->Velocity });
+        const unsigned char slot = getClientSlot(client);
+        sendPacketToAll(S2C_PlayerMovement{ S2C_HPlayerMovement, {}, client, playerStates->getPosition(slot),
+                           playerStates->getRotation(slot), playerStates->getVelocity(slot) });
     } else
     {
-        SPACEMMA_WARN("Failed to broadcast movement of {}. Player not found.", client);
+        SPACEMMA_CATEGORY_WARN_LIMITED(Gameplay, "Failed to broadcast movement of {}. Player not found.", client);
     }
 }
 
 void AGameServer::broadcastMovingPlayers()
 {
-    //std::lock_guard lock(liveClientsMutex);
-    for (unsigned short port : liveClients)
+    if (QuantizeMovement && DeltaCompressMovement)
+    {
+        sendMovementDeltas();
+        return;
+    }
+    if (!playerStates->detectChanges())
+    {
+        return;
+    }
+    if (QuantizeMovement)
     {
-        GameClientData& playerData = gameClientData[port];
-        FVector location = playerData.player->GetActorLocation();
-        FRotator rotation = playerData.player->GetActorRotation();
-        bool recentlyMoved = playerData.recentlyMoving;
-        bool currentlyMoved =
-            !playerData.player->GetCharacterMovement()->Velocity.IsNearlyZero() ||
-            //!playerPair->second->GetRotationVector().IsNearlyZero() ||
-            location != playerData.recentPosition ||
-            rotation != playerData.recentRotation;
-        if (recentlyMoved || currentlyMoved)
+        broadcastWorldSnapshot();
+    } else
+    {
+        for (unsigned short client : liveClients)
         {
-            playerData.recentPosition = location;
-            playerData.recentRotation = rotation;
-            broadcastPlayerMovement(port);
-            playerData.recentlyMoving = currentlyMoved;
+            if (playerStates->isDirty(getClientSlot(client)))
+            {
+                broadcastPlayerMovement(client);
+            }
         }
     }
+    playerStates->markSent();
+}
+
+void AGameServer::broadcastWorldSnapshot()
+{
+    ByteBuffer* buffer = bufferPool->getBuffer(getMaxWorldSnapshotSize(liveClients.size()));
+    if (!buffer)
+    {
+        SPACEMMA_CATEGORY_ERROR_LIMITED(Gameplay, "Failed to acquire a buffer for the world snapshot of {} players!", liveClients.size());
+        return;
+    }
+    uint8_t* dest = buffer->getPointer() + sizeof(S2C_WorldSnapshot);
+    uint16_t playerCount = 0;
+    for (unsigned short client : liveClients)
+    {
+        const unsigned char slot = getClientSlot(client);
+        if (playerStates->isDirty(slot))
+        {
+            dest += writeWorldSnapshotEntry(dest, client, MF_AllFields | MF_Full,
+                                            NetQuantizedMovement{ playerStates->getPosition(slot), playerStates->getRotation(slot),
+                                                                  playerStates->getVelocity(slot) });
+            ++playerCount;
+        }
+    }
+    const S2C_WorldSnapshot header{ S2C_HWorldSnapshot, {}, 0, getSnapshotTime(), playerCount };
+    memcpy(buffer->getPointer(), &header, sizeof(S2C_WorldSnapshot));
+    buffer->setUsedSize(dest - buffer->getPointer());
+    sendToAll(SharedByteBuffer{ *bufferPool, buffer });
+}
+
+void AGameServer::sendMovementDeltas()
+{
+    // players who did not move are still sent to receivers without their baseline
+    playerStates->detectChanges();
+    interestGrid->clear();
+    for (unsigned short client : liveClients)
+    {
+        const unsigned char slot = getClientSlot(client);
+        const FVector position = playerStates->getPosition(slot);
+        quantizedMovement[slot] = NetQuantizedMovement{ position, playerStates->getRotation(slot),
+                                                        playerStates->getVelocity(slot) };
+        interestGrid->insert(slot, position);
+    }
+    interestGrid->build();
+    bandwidthScheduler->refill(movementUpdateDelta);
+    const uint32_t snapshotTime = getSnapshotTime();
+    for (unsigned short receiver : liveClients)
+    {
+        const unsigned char receiverSlot = getClientSlot(receiver);
+        collectSnapshotSubjects(receiver);
+        bandwidthScheduler->prioritize(receiverSlot, snapshotSubjects);
+        const size_t budget = bandwidthScheduler->getAvailableBytes(receiverSlot,
+                                                                    gameClientData[receiverSlot].sendBuffers->buffers.getQueuedBytes());
+        size_t encodedCount;
+        ByteBuffer* buffer = movementEncoder->encodeSnapshot(*bufferPool, receiverSlot, snapshotSubjects, leavingSubjects,
+                                                             quantizedMovement, snapshotTime, budget, encodedCount);
+        // the players which did not fit keep their priorities and stay pending for the next tick
+        for (size_t i = 0; i < encodedCount; ++i)
+        {
+            bandwidthScheduler->markSent(receiverSlot, getClientSlot(snapshotSubjects[i]));
+        }
+        if (buffer)
+        {
+            bandwidthScheduler->consume(receiverSlot, buffer->getUsedSize());
+            sendTo(receiver, buffer);
+        }
+    }
+    playerStates->markSent();
+    ++movementTick;
+}
+
+void AGameServer::collectSnapshotSubjects(unsigned short receiver)
+{
+    const unsigned char receiverSlot = getClientSlot(receiver);
+    // clients predicting their own movement receive it with sendOwnMovement
+    const bool ownMovementPredicted = gameClientData[receiverSlot].predicted;
+    snapshotSubjects.clear();
+    leavingSubjects.clear();
+    if (!InterestManagement)
+    {
+        for (unsigned short subject : liveClients)
+        {
+            const unsigned char subjectSlot = getClientSlot(subject);
+            if (ownMovementPredicted && subjectSlot == receiverSlot)
+            {
+                continue;
+            }
+            if (playerStates->isDirty(subjectSlot) || movementEncoder->needsFullState(receiverSlot, subjectSlot) ||
+                bandwidthScheduler->isPending(receiverSlot, subjectSlot))
+            {
+                bandwidthScheduler->accumulate(receiverSlot, subjectSlot, 1.0f);
+                snapshotSubjects.push_back(subject);
+            }
+        }
+        return;
+    }
+    nearbyPlayers.clear();
+    interestGrid->query(playerStates->getPosition(receiverSlot), InterestReducedRateRadius, nearbyPlayers);
+    const float fullRateRadiusSquared = InterestFullRateRadius * InterestFullRateRadius;
+    interestSlots.assign(gameClientData.size(), false);
+    for (const std::pair<unsigned char, float>& nearbyPlayer : nearbyPlayers)
+    {
+        const unsigned char subjectSlot = nearbyPlayer.first;
+        interestSlots[subjectSlot] = true;
+        if (ownMovementPredicted && subjectSlot == receiverSlot)
+        {
+            continue;
+        }
+        if (!bandwidthScheduler->isPending(receiverSlot, subjectSlot))
+        {
+            if (subjectSlot == receiverSlot || nearbyPlayer.second <= fullRateRadiusSquared)
+            {
+                if (!playerStates->isDirty(subjectSlot) && !movementEncoder->needsFullState(receiverSlot, subjectSlot))
+                {
+                    continue;
+                }
+            } else if ((movementTick + subjectSlot) % InterestReducedRateDivisor)
+            {
+                // players at a reduced rate are spread over the movement ticks and on their tick they are left
+                // to the encoder's comparison with the baseline, as the dirty flags only cover the last tick
+                continue;
+            }
+        }
+        // nearer players gain priority faster, all players within the full rate radius equally
+        bandwidthScheduler->accumulate(receiverSlot, subjectSlot,
+                                       InterestFullRateRadius / std::max(std::sqrt(nearbyPlayer.second), InterestFullRateRadius));
+        snapshotSubjects.push_back(gameClientData[subjectSlot].id);
+    }
+    // players which are not sent anymore would otherwise be left frozen where the receiver saw them last
+    for (unsigned short subject : liveClients)
+    {
+        const unsigned char subjectSlot = getClientSlot(subject);
+        if (!interestSlots[subjectSlot] && movementEncoder->isShown(receiverSlot, subjectSlot))
+        {
+            leavingSubjects.push_back(subject);
+        }
+    }
+}
+
+void AGameServer::sendOwnMovement()
+{
+    if (++ownMovementTick % OwnMovementUpdateDivisor)
+    {
+        return;
+    }
+    const double now = FPlatformTime::Seconds();
+    for (unsigned short client : liveClients)
+    {
+        const unsigned char slot = getClientSlot(client);
+        const GameClientData& data = gameClientData[slot];
+        if (!data.predicted)
+        {
+            continue;
+        }
+        const uint32_t clientTime = data.inputClientTime + static_cast<uint32_t>((now - data.inputTime) * 1000.0);
+        sendPacketTo(client, S2C_OwnMovement{ S2C_HOwnMovement, {}, data.inputSequence, clientTime,
+                                              playerStates->getPosition(slot), playerStates->getVelocity(slot) });
+    }
+}
+
+uint32_t AGameServer::getRewindTime(uint32_t shotTime) const
+{
+    const uint32_t now = getSnapshotTime();
+    if (!shotTime)
+    {
+        return now;
+    }
+    const int32_t maxAge = static_cast<int32_t>(MaxLagCompensation * 1000.0f);
+    const int32_t age = std::min(std::max(static_cast<int32_t>(now - shotTime), 0), maxAge);
+    return now - static_cast<uint32_t>(age);
+}
+
+uint32_t AGameServer::getSnapshotTime() const
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>((FPlatformTime::Seconds() - serverStartTime) * 1000.0));
 }
 
 bool AGameServer::isClientLive(unsigned short client)
 {
-    //std::lock_guard lock(liveClientsMutex);
-    return liveClients.find(client) != liveClients.end();
+    return getLiveClientData(client) != nullptr;
+}
+
+AGameServer::GameClientData* AGameServer::getClientData(unsigned short client)
+{
+    const unsigned char slot = getClientSlot(client);
+    if (!client || slot >= gameClientData.size() || gameClientData[slot].id.load(std::memory_order_acquire) != client)
+    {
+        return nullptr;
+    }
+    return &gameClientData[slot];
+}
+
+AGameServer::GameClientData* AGameServer::getLiveClientData(unsigned short client)
+{
+    GameClientData* data = getClientData(client);
+    return data && data->live.load(std::memory_order_acquire) ? data : nullptr;
+}
+
+void AGameServer::GameClientData::reset()
+{
+    // the network threads stop finding the client before its fields change
+    id.store(0, std::memory_order_release);
+    live.store(false, std::memory_order_release);
+    unverified = false;
+    player = nullptr;
+    sendBuffers = nullptr;
+    kills = 0;
+    deaths = 0;
+    nickname.clear();
+    predicted = false;
+    inputSequence = 0;
+    inputClientTime = 0;
+    inputTime = 0.0;
 }
 
 void AGameServer::handleRoundTimer(float deltaTime)
@@ -791,10 +1326,10 @@ void AGameServer::handleRoundTimer(float deltaTime)
     if (currentRoundTime > RoundTime)
     {
         currentRoundTime = 0;
-        for (auto& clientData : gameClientData)
+        for (GameClientData& clientData : gameClientData)
         {
-            clientData.second.deaths = 0;
-            clientData.second.kills = 0;
+            clientData.deaths = 0;
+            clientData.kills = 0;
         }
 
         sendPacketToAll(S2C_StartRound{ S2C_HStartRound, {}, (uint16_t)RoundTime });
@@ -808,13 +1343,15 @@ void AGameServer::Tick(float DeltaTime)
     {
         handlePlayerAwaitingSpawn();
         processAllPendingPackets();
-        handlePendingDisconnect(DeltaTime);
+        refreshPlayerStates();
+        handlePendingDisconnects(DeltaTime);
         handleRoundTimer(DeltaTime);
         currentMovementUpdateDelta += DeltaTime;
         if (currentMovementUpdateDelta >= movementUpdateDelta)
         {
             currentMovementUpdateDelta -= movementUpdateDelta;
             broadcastMovingPlayers();
+            sendOwnMovement();
         }
     }
 }
@@ -2,34 +2,63 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Client/Server/BandwidthScheduler.h"
+#include "Client/Server/InterestGrid.h"
+#include "Client/Server/LagCompensationHistory.h"
+#include "Client/Server/MovementDeltaEncoder.h"
+#include "Client/Server/PlayerStateStore.h"
+#include "Client/Server/RingQueue.h"
+#include "Client/Server/SharedByteBuffer.h"
 #include "Client/Server/TCPMultiClientServer.h"
 #include "Client/Server/Thread.h"
+#include "Client/Server/WakeSignal.h"
 #include "Client/ShooterPlayer.h"
 #include "Client/Shared/Packets.h"
 #include "Engine/World.h"
+#include <atomic>
 #include <map>
 #include <set>
+#include <vector>
 #include "GameServer.generated.h"
 
+#define RECEIVED_PACKETS_CAPACITY 8192
+#define RECEIVE_BATCH_SIZE 64
+#define SEND_BATCH_SIZE 64
+/** Kinds of packets of which only the latest unsent one per player is kept in a client's send queue. */
+#define SEND_CONFLATION_KINDS 4
+/** Milliseconds the accepting thread waits before checking again whether a full server has a free slot. */
+#define ACCEPT_FULL_RETRY_DELAY 100
+/** Capacity of the queue of disconnected clients handed over to the reaper thread, which must exceed the max client amount. */
+#define REAP_QUEUE_CAPACITY 256
+#define REAP_BATCH_SIZE 32
+
 UCLASS()
 class CLIENT_API AGameServer : public AActor
 {
     /**
      * Contains all important information about a specific client.
+     * Stored in a flat array indexed by the client's slot, the entry is free while its id is zero.
      */
     struct GameClientData final
     {
-        spacemma::Thread* sendThread{};
-        spacemma::Thread* receiveThread{};
+        // written under connectionMutex, but read by the network threads without it
+        std::atomic<unsigned short> id{};
+        std::atomic_bool live{};
+        bool unverified{};
         AShooterPlayer* player{ nullptr };
         spacemma::ClientBuffers* sendBuffers{};
-        bool recentlyMoving{};
-        FVector recentPosition{};
-        FRotator recentRotation{};
         unsigned int kills{};
         unsigned int deaths{};
         std::string nickname{};
-
+        // the last movement input, echoed in S2C_OwnMovement once the client sent any
+        bool predicted{};
+        uint16_t inputSequence{};
+        uint32_t inputClientTime{};
+        double inputTime{};
+        /**
+         * Resets the data to that of a free slot.
+         */
+        void reset();
     };
     GENERATED_BODY()
 
@@ -55,11 +84,79 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
         int32 MaxClients = 8;
     /**
+    * Specifies the number of network threads serving all client connections, regardless of their amount.
+    * Zero uses one thread per CPU core.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int32 ReactorThreads = 0;
+    /**
     * Specifies the movement update frequency.
     */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
         int32 MovementUpdateTickRate = 10;
     /**
+    * Specifies if movement updates are batched into world snapshots with quantized positions, rotations and velocities.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        bool QuantizeMovement = true;
+    /**
+    * Specifies if world snapshots only contain the fields which changed since the last snapshot sent to the client.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        bool DeltaCompressMovement = true;
+    /**
+    * Specifies if world snapshots only contain the players near the client. Requires delta compression.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        bool InterestManagement = true;
+    /**
+    * Specifies the distance within which players are sent to the client in every world snapshot.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        float InterestFullRateRadius = 10000.0f;
+    /**
+    * Specifies the distance within which players are sent to the client at a reduced rate, farther players are not sent.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        float InterestReducedRateRadius = 30000.0f;
+    /**
+    * Specifies how many times less often the players within the reduced rate radius are sent.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int32 InterestReducedRateDivisor = 3;
+    /**
+    * Specifies the bytes per second available to every client for world snapshots, including the data still queued for it.
+    * The most stale and nearest players are sent first when the budget does not suffice. Zero disables the budget.
+    * Requires delta compression.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int32 ClientBandwidthBudget = 32768;
+    /**
+    * Specifies every how many movement updates the clients predicting their own movement receive its authoritative state.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int32 OwnMovementUpdateDivisor = 2;
+    /**
+    * Specifies how many seconds at most the other players are rewound to the time the shooter saw them at. Zero disables rewinding.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        float MaxLagCompensation = 0.25f;
+    /**
+    * Specifies the mask of CPUs the network threads (accepting, reactor and per-client threads) run on. Zero leaves them unpinned.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int64 NetworkThreadAffinity = 0;
+    /**
+    * Specifies the mask of CPUs the game thread running the server tick is pinned to while the server runs. Zero leaves it unpinned.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        int64 GameThreadAffinity = 0;
+    /**
+    * Specifies if the network threads run at a raised priority, which may require privileges (CAP_SYS_NICE on Linux).
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
+        bool RaiseNetworkThreadPriority = false;
+    /**
     * Specifies the round duration in seconds
     */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Server_Parameters)
@@ -95,17 +192,33 @@ protected:
 private:
     //todo: switch naming convention to match UE4!
     static void threadAcceptClients(gsl::not_null<spacemma::Thread*> thread, void* server);
-    static void threadSend(gsl::not_null<spacemma::Thread*> thread, void* args);
-    static void threadReceive(gsl::not_null<spacemma::Thread*> thread, void* args);
+    static void threadReapClients(gsl::not_null<spacemma::Thread*> thread, void* server);
+    static void handleClientEvent(spacemma::ClientEvent event, unsigned short client, void* server);
+    /**
+    * Names the network thread and applies the network thread affinity and priority to it.
+    */
+    void configureNetworkThread(spacemma::Thread* thread, const std::string& name) const;
+    /**
+    * Sends all buffers queued for the client. Called from the network threads once a send was scheduled for the client.
+    */
+    void flushSendBuffers(unsigned short client);
+    /**
+    * Frees all buffers still queued for the client.
+    */
+    void clearSendBuffers(gsl::not_null<spacemma::ClientBuffers*> buffers);
+    /**
+    * Queues the buffer received from the client for processing on the game thread.
+    */
+    void pushReceivedPacket(unsigned short client, gsl::not_null<spacemma::ByteBuffer*> buffer);
     /**
     * Sends packet to all connected clients.
     */
     template<typename T>
     void sendPacketToAll(T packet);
     /**
-    * Sends buffer to all connected clients.
+    * Sends buffer to all connected clients. The same buffer is queued for every client.
     */
-    void sendToAll(gsl::not_null<spacemma::ByteBuffer*> buffer);
+    void sendToAll(const spacemma::SharedByteBuffer& buffer);
     /**
     * Sends packet to all connected clients but one ignored client for whom the packet will not be sent, is specified.
     */
@@ -114,7 +227,7 @@ private:
     /**
     * Sends buffer to all connected clients but one ignored client for whom the packet will not be sent, is specified.
     */
-    void sendToAllBut(gsl::not_null<spacemma::ByteBuffer*> buffer, unsigned short ignoredClient);
+    void sendToAllBut(const spacemma::SharedByteBuffer& buffer, unsigned short ignoredClient);
     /**
     * Sends packet to all connected clients but two ignored clients for whom the packet will not be sent, are specified.
     */
@@ -123,32 +236,52 @@ private:
     /**
     * Sends buffer to all connected clients but two ignored clients for whom the packet will not be sent, are specified.
     */
-    void sendToAllBut(gsl::not_null<spacemma::ByteBuffer*> buffer, unsigned short ignoredClient1, unsigned short ignoredClient2);
+    void sendToAllBut(const spacemma::SharedByteBuffer& buffer, unsigned short ignoredClient1, unsigned short ignoredClient2);
     /**
     * Sends packet to client specified by its id.
     */
     template<typename T>
     void sendPacketTo(unsigned short client, T packet);
     /**
-    * Sends buffer to client specified by its id.
+    * Sends buffer to client specified by its id. Takes over the caller's reference to the buffer.
     */
     void sendTo(unsigned short client, gsl::not_null<spacemma::ByteBuffer*> buffer);
     /**
-    * Disconnects client from server.
+    * Returns true and sets the slot of the player the buffer is about if it contains a single packet about a player, false otherwise.
+    * The kind is set to the conflation kind if only the latest packet of the kind has to be sent, to SEND_CONFLATION_KINDS
+    * for events which the player's states queued before them must not overtake.
+    */
+    bool getSendSubject(gsl::not_null<const spacemma::ByteBuffer*> buffer, size_t& subject, size_t& kind) const;
+    /**
+    * Encodes packet into a buffer which can be shared by many clients.
+    */
+    template<typename T>
+    spacemma::SharedByteBuffer createSharedPacketBuffer(const T& packet);
+    /**
+    * Removes the client from the game and tells the other players about it at once.
+    * Closing the connection and freeing its send buffers is left to the reaper thread.
     */
     void disconnectClient(unsigned short client);
     /**
+    * Closes the connections and frees the send buffers of all clients queued for the reaper.
+    */
+    void reapClients();
+    /**
+    * Closes the connection and frees the send buffers of a disconnected client.
+    */
+    void reapClient(unsigned short client, spacemma::ClientBuffers* sendBuffers);
+    /**
     * Processes packet received from client.
     */
-    void processPacket(unsigned short sourceClient, gsl::not_null<spacemma::ByteBuffer*> buffer);
+    void processPacket(unsigned short sourceClient, gsl::span<uint8_t> span);
     /**
     * Handles a player, who is awaiting to be spawned.
     */
     void handlePlayerAwaitingSpawn();
     /**
-    * Handles disconnected clients.
+    * Disconnects all clients whose disconnect timeout expired.
     */
-    void handlePendingDisconnect(float timeDelta);
+    void handlePendingDisconnects(float timeDelta);
     /**
     * Checks if there is any available packet and then if it is true, processes the packet.
     */
@@ -158,6 +291,14 @@ private:
     */
     void processAllPendingPackets();
     /**
+    * Processes all frames of the buffer received from client and frees the buffer.
+    */
+    void processReceivedPacket(unsigned short client, gsl::not_null<spacemma::ByteBuffer*> buffer);
+    /**
+    * Copies the movement state of all live players from their actors to the player state store.
+    */
+    void refreshPlayerStates();
+    /**
     * Send the information about movement of specified client to all clients.
     */
     void broadcastPlayerMovement(unsigned short client);
@@ -166,24 +307,72 @@ private:
     */
     void broadcastMovingPlayers();
     /**
+    * Sends all clients a single world snapshot with full states of the moving players, encoded once and shared.
+    */
+    void broadcastWorldSnapshot();
+    /**
+    * Sends every live client a world snapshot with delta updates of all players which changed since its baselines.
+    */
+    void sendMovementDeltas();
+    /**
+    * Sends the clients predicting their own movement its authoritative state with the last processed input.
+    */
+    void sendOwnMovement();
+    /**
+    * Collects the players whose movement is sent to the receiver in this movement tick into snapshotSubjects
+    * and raises their priorities. The players the receiver still shows, but which left its area of interest,
+    * are collected into leavingSubjects.
+    */
+    void collectSnapshotSubjects(unsigned short receiver);
+    /**
+    * Returns the time in milliseconds since the server was started, wrapping around, which stamps world snapshots.
+    */
+    uint32_t getSnapshotTime() const;
+    /**
+    * Returns the time to which the other players are rewound for a shot fired at the given time, capped by MaxLagCompensation.
+    */
+    uint32_t getRewindTime(uint32_t shotTime) const;
+    /**
     * Checks if client is available and in game.
     */
     bool isClientLive(unsigned short client);
     /**
+    * Returns the data of the client with the given ID or null pointer if the ID is no longer valid.
+    */
+    GameClientData* getClientData(unsigned short client);
+    /**
+    * Returns the data of the client with the given ID or null pointer if the client is not in game.
+    */
+    GameClientData* getLiveClientData(unsigned short client);
+    /**
     * Updates round timer and handle round restart
     */
     void handleRoundTimer(float deltaTime);
     std::recursive_mutex connectionMutex{}, liveClientsMutex{};
-    std::mutex receiveMutex{}, startStopMutex{}, disconnectMutex{}, spawnAwaitingMutex{}, unverifiedPlayersMutex{};
+    std::mutex startStopMutex{}, disconnectMutex{}, spawnAwaitingMutex{}, unverifiedPlayersMutex{};
     std::unique_ptr<spacemma::BufferPool> bufferPool;
     std::unique_ptr<spacemma::TCPMultiClientServer> tcpServer{};
-    spacemma::Thread* acceptThread{};
-    std::vector<std::pair<unsigned short, spacemma::ByteBuffer*>> receivedPackets{};
+    std::unique_ptr<spacemma::PlayerStateStore> playerStates{};
+    std::unique_ptr<spacemma::MovementDeltaEncoder> movementEncoder{};
+    std::unique_ptr<spacemma::InterestGrid> interestGrid{};
+    std::unique_ptr<spacemma::BandwidthScheduler> bandwidthScheduler{};
+    std::unique_ptr<spacemma::LagCompensationHistory> lagCompensation{};
+    std::vector<std::pair<unsigned char, float>> nearbyPlayers{};
+    unsigned int movementTick{ 0 }, ownMovementTick{ 0 };
+    double serverStartTime{ 0.0 };
+    std::vector<spacemma::NetQuantizedMovement> quantizedMovement{};
+    std::vector<unsigned short> snapshotSubjects{}, leavingSubjects{};
+    std::vector<bool> interestSlots{};
+    spacemma::Thread* acceptThread{}, * reaperThread{};
+    // disconnected clients with their send buffers, pushed by the game thread and drained by the reaper thread
+    spacemma::SPSCRingQueue<std::pair<unsigned short, spacemma::ClientBuffers*>> reapedClients{ REAP_QUEUE_CAPACITY };
+    spacemma::WakeSignal reapSignal{};
+    spacemma::MPSCRingQueue<std::pair<unsigned short, spacemma::ByteBuffer*>> receivedPackets{ RECEIVED_PACKETS_CAPACITY };
     std::map<unsigned short, float> disconnectingPlayersWithTimeouts{};
-    std::set<unsigned short> liveClients{};
+    std::vector<unsigned short> expiredDisconnects{};
+    std::vector<unsigned short> liveClients{};
     std::set<unsigned short> playersAwaitingSpawn{};
-    std::set<unsigned short> unverifiedPlayers{};
-    std::map<unsigned short, GameClientData> gameClientData{};
+    std::vector<GameClientData> gameClientData{};
     float movementUpdateDelta{}, currentMovementUpdateDelta{ 0.0f };
     std::string mapName{};
     float currentRoundTime{ 0.0f };
@@ -193,39 +382,33 @@ template<typename T>
 void AGameServer::sendPacketToAll(T packet)
 {
     static_assert(!std::is_same<spacemma::packets::S2C_CreatePlayer, T>());
-    std::lock_guard lock(liveClientsMutex);
-    for (unsigned short port : liveClients)
-    {
-        sendPacketTo(port, packet);
-    }
+    sendToAll(createSharedPacketBuffer(packet));
 }
 
 template<typename T>
 void AGameServer::sendPacketToAllBut(T packet, unsigned short ignoredClient)
 {
     static_assert(!std::is_same<spacemma::packets::S2C_CreatePlayer, T>());
-    std::lock_guard lock(liveClientsMutex);
-    for (unsigned short port : liveClients)
-    {
-        if (port != ignoredClient)
-        {
-            sendPacketTo(port, packet);
-        }
-    }
+    sendToAllBut(createSharedPacketBuffer(packet), ignoredClient);
 }
 
 template<typename T>
 void AGameServer::sendPacketToAllBut(T packet, unsigned short ignoredClient1, unsigned short ignoredClient2)
 {
     static_assert(!std::is_same<spacemma::packets::S2C_CreatePlayer, T>());
-    std::lock_guard lock(liveClientsMutex);
-    for (unsigned short port : liveClients)
+    sendToAllBut(createSharedPacketBuffer(packet), ignoredClient1, ignoredClient2);
+}
+
+template<typename T>
+spacemma::SharedByteBuffer AGameServer::createSharedPacketBuffer(const T& packet)
+{
+    static_assert(!std::is_same<spacemma::packets::S2C_CreatePlayer, T>());
+    spacemma::SharedByteBuffer buff{ *bufferPool, sizeof(T) };
+    if (buff)
     {
-        if (port != ignoredClient1 && port != ignoredClient2)
-        {
-            sendPacketTo(port, packet);
-        }
+        memcpy(buff->getPointer(), &packet, sizeof(T));
     }
+    return buff;
 }
 
 template<typename T>
@@ -0,0 +1,77 @@
+#include "InterestGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+// cell coordinates are packed into 21 bits per axis, which covers the quantized positions even with 1 unit cells
+#define INTEREST_GRID_CELL_BITS 21
+#define INTEREST_GRID_CELL_BIAS (1 << (INTEREST_GRID_CELL_BITS - 1))
+
+spacemma::InterestGrid::InterestGrid(float cellSize) : cellSize(std::max(cellSize, 1.0f)) {}
+
+void spacemma::InterestGrid::clear()
+{
+    entries.clear();
+}
+
+void spacemma::InterestGrid::insert(unsigned char slot, const FVector& position)
+{
+    entries.push_back(Entry{ getCellKey(getCellCoordinate(position.X), getCellCoordinate(position.Y),
+                                        getCellCoordinate(position.Z)), position, slot });
+}
+
+void spacemma::InterestGrid::build()
+{
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.cell < b.cell; });
+}
+
+void spacemma::InterestGrid::query(const FVector& center, float radius,
+                                   std::vector<std::pair<unsigned char, float>>& result) const
+{
+    const float radiusSquared = radius * radius;
+    const int32_t minX = getCellCoordinate(center.X - radius), maxX = getCellCoordinate(center.X + radius);
+    const int32_t minY = getCellCoordinate(center.Y - radius), maxY = getCellCoordinate(center.Y + radius);
+    const int32_t minZ = getCellCoordinate(center.Z - radius), maxZ = getCellCoordinate(center.Z + radius);
+    for (int32_t x = minX; x <= maxX; ++x)
+    {
+        for (int32_t y = minY; y <= maxY; ++y)
+        {
+            for (int32_t z = minZ; z <= maxZ; ++z)
+            {
+                const uint64_t cell = getCellKey(x, y, z);
+                auto it = std::lower_bound(entries.begin(), entries.end(), cell,
+                                           [](const Entry& entry, uint64_t key) { return entry.cell < key; });
+                for (; it != entries.end() && it->cell == cell; ++it)
+                {
+                    const float distanceSquared = FVector::DistSquared(center, it->position);
+                    if (distanceSquared <= radiusSquared)
+                    {
+                        result.emplace_back(it->slot, distanceSquared);
+                    }
+                }
+            }
+        }
+    }
+}
+
+float spacemma::InterestGrid::getCellSize() const
+{
+    return cellSize;
+}
+
+int32_t spacemma::InterestGrid::getCellCoordinate(float value) const
+{
+    const float cell = std::floor(value / cellSize);
+    // also maps NaN to the highest cell
+    return cell < INTEREST_GRID_CELL_BIAS - 1
+               ? (cell > -INTEREST_GRID_CELL_BIAS ? static_cast<int32_t>(cell) : -INTEREST_GRID_CELL_BIAS)
+               : INTEREST_GRID_CELL_BIAS - 1;
+}
+
+uint64_t spacemma::InterestGrid::getCellKey(int32_t x, int32_t y, int32_t z)
+{
+    const uint64_t mask = (1ULL << INTEREST_GRID_CELL_BITS) - 1ULL;
+    return static_cast<uint64_t>(x + INTEREST_GRID_CELL_BIAS) & mask |
+        (static_cast<uint64_t>(y + INTEREST_GRID_CELL_BIAS) & mask) << INTEREST_GRID_CELL_BITS |
+        (static_cast<uint64_t>(z + INTEREST_GRID_CELL_BIAS) & mask) << 2U * INTEREST_GRID_CELL_BITS;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace spacemma
+{
+    /**
+     * A loose spatial hash of player positions used to find the players near a given point.
+     * The grid is rebuilt from scratch every time it is used: the entries are sorted by their cell, so that
+     * a query only visits the 27 cells around the point when the cell size is not smaller than the query radius.
+     * Rebuilding reuses the storage, so it does not allocate once the grid has grown to the player count.
+     */
+    class InterestGrid final
+    {
+    public:
+        InterestGrid(float cellSize);
+        ~InterestGrid() = default;
+        InterestGrid(InterestGrid&) = delete;
+        InterestGrid(InterestGrid&&) = delete;
+        InterestGrid& operator=(InterestGrid&) = delete;
+        InterestGrid& operator=(InterestGrid&&) = delete;
+        /**
+         * Removes all entries.
+         */
+        void clear();
+        /**
+         * Adds the slot at the given position. The grid has to be rebuilt before it is queried again.
+         */
+        void insert(unsigned char slot, const FVector& position);
+        /**
+         * Sorts the entries by their cells. Has to be called after inserting and before querying.
+         */
+        void build();
+        /**
+         * Appends all slots within the radius from the center together with their squared distances to the result.
+         */
+        void query(const FVector& center, float radius, std::vector<std::pair<unsigned char, float>>& result) const;
+        /**
+         * Returns the size of a single cell.
+         */
+        float getCellSize() const;
+    private:
+        struct Entry final
+        {
+            uint64_t cell;
+            FVector position;
+            unsigned char slot;
+        };
+        int32_t getCellCoordinate(float value) const;
+        static uint64_t getCellKey(int32_t x, int32_t y, int32_t z);
+        float cellSize;
+        std::vector<Entry> entries{};
+    };
+}
@@ -0,0 +1,71 @@
+#include "InterpolationBuffer.h"
+
+#include <algorithm>
+
+void spacemma::InterpolationBuffer::push(double time, const FVector& location, const FRotator& rotation,
+                                         const FVector& velocity)
+{
+    if (count && time <= samples[newest].time)
+    {
+        return;
+    }
+    newest = (newest + 1) % INTERPOLATION_BUFFER_CAPACITY;
+    samples[newest] = Sample{ time, location, rotation, velocity };
+    count = std::min<size_t>(count + 1, INTERPOLATION_BUFFER_CAPACITY);
+}
+
+void spacemma::InterpolationBuffer::clear()
+{
+    count = 0;
+}
+
+bool spacemma::InterpolationBuffer::isEmpty() const
+{
+    return !count;
+}
+
+double spacemma::InterpolationBuffer::getNewestTime() const
+{
+    return count ? samples[newest].time : 0.0;
+}
+
+bool spacemma::InterpolationBuffer::sample(double time, float maxExtrapolation, FVector& location, FRotator& rotation,
+                                           FVector& velocity) const
+{
+    if (!count)
+    {
+        return false;
+    }
+    const Sample& newestSample = getSample(0);
+    if (time >= newestSample.time)
+    {
+        const float extrapolation = static_cast<float>(std::min(time - newestSample.time, static_cast<double>(maxExtrapolation)));
+        location = newestSample.location + newestSample.velocity * extrapolation;
+        rotation = newestSample.rotation;
+        velocity = newestSample.velocity;
+        return true;
+    }
+    for (size_t age = 1; age < count; ++age)
+    {
+        const Sample& older = getSample(age);
+        if (time >= older.time)
+        {
+            const Sample& newer = getSample(age - 1);
+            const float alpha = static_cast<float>((time - older.time) / (newer.time - older.time));
+            location = FMath::Lerp(older.location, newer.location, alpha);
+            rotation = FQuat::Slerp(FQuat(older.rotation), FQuat(newer.rotation), alpha).Rotator();
+            velocity = FMath::Lerp(older.velocity, newer.velocity, alpha);
+            return true;
+        }
+    }
+    const Sample& oldest = getSample(count - 1);
+    location = oldest.location;
+    rotation = oldest.rotation;
+    velocity = oldest.velocity;
+    return true;
+}
+
+const spacemma::InterpolationBuffer::Sample& spacemma::InterpolationBuffer::getSample(size_t age) const
+{
+    return samples[(newest + INTERPOLATION_BUFFER_CAPACITY - age) % INTERPOLATION_BUFFER_CAPACITY];
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#define INTERPOLATION_BUFFER_CAPACITY 16
+
+namespace spacemma
+{
+    /**
+     * A ring of the latest timestamped movement samples of a single remote player.
+     * The movement is sampled at any time between the samples by interpolation, and briefly past the newest sample
+     * by extrapolation along its velocity, so that the player moves smoothly even though updates arrive in bursts.
+     */
+    class InterpolationBuffer final
+    {
+    public:
+        InterpolationBuffer() = default;
+        ~InterpolationBuffer() = default;
+        InterpolationBuffer(InterpolationBuffer&) = delete;
+        InterpolationBuffer(InterpolationBuffer&&) = delete;
+        InterpolationBuffer& operator=(InterpolationBuffer&) = delete;
+        InterpolationBuffer& operator=(InterpolationBuffer&&) = delete;
+        /**
+         * Adds the sample taken at the given time in seconds, overwriting the oldest one if the ring is full.
+         * Samples which are not newer than the newest one are ignored.
+         */
+        void push(double time, const FVector& location, const FRotator& rotation, const FVector& velocity);
+        /**
+         * Removes all samples, e.g. after the player was teleported.
+         */
+        void clear();
+        /**
+         * Returns true if there are no samples, false otherwise.
+         */
+        bool isEmpty() const;
+        /**
+         * Returns the time of the newest sample.
+         */
+        double getNewestTime() const;
+        /**
+         * Computes the movement at the given time. Times before the oldest sample are clamped to it, times past
+         * the newest sample are extrapolated for at most maxExtrapolation seconds.
+         * Returns false if there are no samples, true otherwise.
+         */
+        bool sample(double time, float maxExtrapolation, FVector& location, FRotator& rotation, FVector& velocity) const;
+    private:
+        struct Sample final
+        {
+            double time;
+            FVector location;
+            FRotator rotation;
+            FVector velocity;
+        };
+        const Sample& getSample(size_t age) const;
+        Sample samples[INTERPOLATION_BUFFER_CAPACITY]{};
+        size_t newest{ 0 };
+        size_t count{ 0 };
+    };
+}
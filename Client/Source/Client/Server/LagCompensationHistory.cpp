@@ -0,0 +1,117 @@
+#include "LagCompensationHistory.h"
+#include "ClientSlotAllocator.h"
+
+#include <algorithm>
+#include <cmath>
+
+spacemma::LagCompensationHistory::LagCompensationHistory(unsigned char slotCount)
+    : capsules(slotCount * LAG_COMPENSATION_HISTORY, Capsule{}), newest(slotCount, 0U), counts(slotCount, 0U) {}
+
+void spacemma::LagCompensationHistory::reset(unsigned char slot)
+{
+    counts[slot] = 0U;
+}
+
+void spacemma::LagCompensationHistory::record(unsigned char slot, uint32_t time, const FVector& center, float radius,
+                                              float halfHeight)
+{
+    Capsule* ring = &capsules[slot * LAG_COMPENSATION_HISTORY];
+    if (counts[slot] && static_cast<int32_t>(time - ring[newest[slot]].time) <= 0)
+    {
+        return;
+    }
+    newest[slot] = (newest[slot] + 1U) % LAG_COMPENSATION_HISTORY;
+    ring[newest[slot]] = Capsule{ time, center, radius, halfHeight };
+    counts[slot] = std::min<size_t>(counts[slot] + 1U, LAG_COMPENSATION_HISTORY);
+}
+
+bool spacemma::LagCompensationHistory::raycast(const FVector& start, const FVector& direction, float maxDistance,
+                                               uint32_t time, gsl::span<const unsigned short> players,
+                                               unsigned short ignoredPlayer, unsigned short& hitPlayer,
+                                               float& hitDistance) const
+{
+    bool hit = false;
+    hitDistance = maxDistance;
+    for (unsigned short player : players)
+    {
+        const unsigned char slot = getClientSlot(player);
+        if (player == ignoredPlayer || !counts[slot])
+        {
+            continue;
+        }
+        const float distance = intersect(start, direction, getCapsule(slot, time));
+        if (distance >= 0.0f && distance <= hitDistance)
+        {
+            hit = true;
+            hitPlayer = player;
+            hitDistance = distance;
+        }
+    }
+    return hit;
+}
+
+spacemma::LagCompensationHistory::Capsule spacemma::LagCompensationHistory::getCapsule(unsigned char slot, uint32_t time) const
+{
+    const Capsule* ring = &capsules[slot * LAG_COMPENSATION_HISTORY];
+    size_t newer = newest[slot];
+    if (static_cast<int32_t>(time - ring[newer].time) >= 0)
+    {
+        return ring[newer];
+    }
+    for (size_t age = 1U; age < counts[slot]; ++age)
+    {
+        const size_t older = (newest[slot] + LAG_COMPENSATION_HISTORY - age) % LAG_COMPENSATION_HISTORY;
+        const int32_t sinceOlder = static_cast<int32_t>(time - ring[older].time);
+        if (sinceOlder >= 0)
+        {
+            const float alpha = static_cast<float>(sinceOlder) / static_cast<float>(static_cast<int32_t>(ring[newer].time - ring[older].time));
+            return Capsule{ time, FMath::Lerp(ring[older].center, ring[newer].center, alpha),
+                            FMath::Lerp(ring[older].radius, ring[newer].radius, alpha),
+                            FMath::Lerp(ring[older].halfHeight, ring[newer].halfHeight, alpha) };
+        }
+        newer = older;
+    }
+    return ring[newer];
+}
+
+float spacemma::LagCompensationHistory::intersect(const FVector& start, const FVector& direction, const Capsule& capsule)
+{
+    // the capsule is the set of points within the radius from the vertical segment between the hemisphere centers
+    const float radiusSquared = capsule.radius * capsule.radius;
+    const float segmentHalfLength = std::max(capsule.halfHeight - capsule.radius, 0.0f);
+    const FVector toStart = start - capsule.center;
+    float nearest = -1.0f;
+    // the cylinder around the segment, in the horizontal plane
+    const float a = direction.X * direction.X + direction.Y * direction.Y;
+    if (a > KINDA_SMALL_NUMBER)
+    {
+        const float b = direction.X * toStart.X + direction.Y * toStart.Y;
+        const float c = toStart.X * toStart.X + toStart.Y * toStart.Y - radiusSquared;
+        const float discriminant = b * b - a * c;
+        if (discriminant >= 0.0f)
+        {
+            const float distance = (-b - std::sqrt(discriminant)) / a;
+            if (distance >= 0.0f && std::abs(toStart.Z + distance * direction.Z) <= segmentHalfLength)
+            {
+                return distance;
+            }
+        }
+    }
+    // the hemispheres, the segment entered the cylinder beyond one of them or runs parallel to it
+    for (const float end : { -segmentHalfLength, segmentHalfLength })
+    {
+        const FVector toSphere = toStart - FVector(0.0f, 0.0f, end);
+        const float b = FVector::DotProduct(direction, toSphere);
+        const float c = toSphere.SizeSquared() - radiusSquared;
+        const float discriminant = b * b - c;
+        if (discriminant >= 0.0f)
+        {
+            const float distance = -b - std::sqrt(discriminant);
+            if (distance >= 0.0f && (nearest < 0.0f || distance < nearest))
+            {
+                nearest = distance;
+            }
+        }
+    }
+    return nearest;
+}
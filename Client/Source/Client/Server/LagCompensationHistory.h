@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <gsl/gsl-lite.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#define LAG_COMPENSATION_HISTORY 64
+
+namespace spacemma
+{
+    /**
+     * Rings of the recent collision capsules of all players indexed by client slot, recorded every server tick
+     * and stamped with the world snapshot time in milliseconds, so that shots can be judged against the state
+     * which the shooter saw when firing.
+     * The capsules are upright, as those of characters are, and tested analytically, so rewinding does not move any actors.
+     */
+    class LagCompensationHistory final
+    {
+    public:
+        LagCompensationHistory(unsigned char slotCount);
+        ~LagCompensationHistory() = default;
+        LagCompensationHistory(LagCompensationHistory&) = delete;
+        LagCompensationHistory(LagCompensationHistory&&) = delete;
+        LagCompensationHistory& operator=(LagCompensationHistory&) = delete;
+        LagCompensationHistory& operator=(LagCompensationHistory&&) = delete;
+        /**
+         * Forgets the history of the slot, e.g. after it was taken by a new player or the player was teleported.
+         */
+        void reset(unsigned char slot);
+        /**
+         * Records the capsule of the slot at the given time. Records which are not newer than the newest one are ignored.
+         */
+        void record(unsigned char slot, uint32_t time, const FVector& center, float radius, float halfHeight);
+        /**
+         * Finds the nearest capsule hit by the segment from start in the direction (a unit vector) up to maxDistance,
+         * with the capsules rewound to the given time (clamped to the recorded ones).
+         * Only the given players are tested, except for the ignored one and those without history.
+         * Returns true and sets the player and the distance if a capsule was hit, false otherwise.
+         */
+        bool raycast(const FVector& start, const FVector& direction, float maxDistance, uint32_t time,
+                     gsl::span<const unsigned short> players, unsigned short ignoredPlayer,
+                     unsigned short& hitPlayer, float& hitDistance) const;
+    private:
+        struct Capsule final
+        {
+            uint32_t time;
+            FVector center;
+            float radius;
+            float halfHeight;
+        };
+        /**
+         * Returns the capsule of the slot interpolated at the given time, which must have history.
+         */
+        Capsule getCapsule(unsigned char slot, uint32_t time) const;
+        static float intersect(const FVector& start, const FVector& direction, const Capsule& capsule);
+        std::vector<Capsule> capsules;
+        std::vector<size_t> newest, counts;
+    };
+}
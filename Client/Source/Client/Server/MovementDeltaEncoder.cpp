@@ -0,0 +1,137 @@
+#include "MovementDeltaEncoder.h"
+#include "ClientSlotAllocator.h"
+#include "SpaceLog.h"
+
+#include <algorithm>
+
+spacemma::MovementDeltaEncoder::MovementDeltaEncoder(unsigned char slotCount) : slotCount(slotCount)
+{
+    baselines.resize(static_cast<size_t>(slotCount) * slotCount);
+    sentSequences.resize(slotCount, 0U);
+    ackedSequences.resize(slotCount, 0U);
+}
+
+void spacemma::MovementDeltaEncoder::resetReceiver(unsigned char receiverSlot)
+{
+    Baseline* receiverBaselines = &baselines[receiverSlot * slotCount];
+    for (size_t subjectSlot = 0; subjectSlot < slotCount; ++subjectSlot)
+    {
+        receiverBaselines[subjectSlot].valid = false;
+        receiverBaselines[subjectSlot].shown = true;
+    }
+    sentSequences[receiverSlot] = 0U;
+    ackedSequences[receiverSlot] = 0U;
+}
+
+void spacemma::MovementDeltaEncoder::resetSubject(unsigned char subjectSlot)
+{
+    for (size_t receiverSlot = 0; receiverSlot < slotCount; ++receiverSlot)
+    {
+        baselines[receiverSlot * slotCount + subjectSlot].valid = false;
+        baselines[receiverSlot * slotCount + subjectSlot].shown = true;
+    }
+}
+
+void spacemma::MovementDeltaEncoder::acknowledge(unsigned char receiverSlot, uint16_t sequence, bool resync)
+{
+    // sequences wrap around, an acknowledgement is only accepted if it is not ahead of the last sent sequence
+    const uint16_t acked = ackedSequences[receiverSlot];
+    if (static_cast<uint16_t>(sequence - acked) > static_cast<uint16_t>(sentSequences[receiverSlot] - acked))
+    {
+        SPACEMMA_CATEGORY_WARN(Gameplay, "Ignoring movement acknowledgement {} from slot {} (last sent {})!",
+                      sequence, receiverSlot, sentSequences[receiverSlot]);
+        return;
+    }
+    ackedSequences[receiverSlot] = sequence;
+    if (resync)
+    {
+        SPACEMMA_CATEGORY_DEBUG(Gameplay, "Resynchronizing movement of slot {} after sequence {}.", receiverSlot, sequence);
+        Baseline* receiverBaselines = &baselines[receiverSlot * slotCount];
+        for (size_t subjectSlot = 0; subjectSlot < slotCount; ++subjectSlot)
+        {
+            receiverBaselines[subjectSlot].valid = false;
+        }
+    }
+}
+
+bool spacemma::MovementDeltaEncoder::needsFullState(unsigned char receiverSlot, unsigned char subjectSlot) const
+{
+    const Baseline& baseline = baselines[receiverSlot * slotCount + subjectSlot];
+    // a subject coming back into the area of interest is shown at once instead of moving from where it left
+    return !baseline.valid || !baseline.shown ||
+        static_cast<uint16_t>(sentSequences[receiverSlot] - ackedSequences[receiverSlot]) >= MOVEMENT_ACK_WINDOW;
+}
+
+bool spacemma::MovementDeltaEncoder::isShown(unsigned char receiverSlot, unsigned char subjectSlot) const
+{
+    return baselines[receiverSlot * slotCount + subjectSlot].shown;
+}
+
+spacemma::ByteBuffer* spacemma::MovementDeltaEncoder::encodeSnapshot(BufferPool& bufferPool, unsigned char receiverSlot,
+                                                                     gsl::span<const unsigned short> subjects,
+                                                                     gsl::span<const unsigned short> leavingSubjects,
+                                                                     gsl::span<const NetQuantizedMovement> movements,
+                                                                     uint32_t serverTime, size_t maxSize, size_t& encodedCount)
+{
+    encodedCount = 0U;
+    const size_t size = std::min(packets::getMaxWorldSnapshotSize(subjects.size())
+                                     + leavingSubjects.size() * sizeof(packets::WorldSnapshotEntry), maxSize);
+    if (size <= sizeof(packets::S2C_WorldSnapshot))
+    {
+        return nullptr;
+    }
+    ByteBuffer* buffer = bufferPool.getBuffer(size);
+    if (!buffer)
+    {
+        return nullptr;
+    }
+    Baseline* receiverBaselines = &baselines[receiverSlot * slotCount];
+    uint8_t* dest = buffer->getPointer() + sizeof(packets::S2C_WorldSnapshot);
+    const uint8_t* end = buffer->getPointer() + size;
+    uint16_t playerCount = 0U;
+    for (const unsigned short subject : leavingSubjects)
+    {
+        if (static_cast<size_t>(end - dest) < sizeof(packets::WorldSnapshotEntry))
+        {
+            break;
+        }
+        dest += packets::writeWorldSnapshotEntry(dest, subject, 0U, NetQuantizedMovement{});
+        receiverBaselines[getClientSlot(subject)].shown = false;
+        ++playerCount;
+    }
+    for (; encodedCount < subjects.size(); ++encodedCount)
+    {
+        const unsigned short subject = subjects[encodedCount];
+        const unsigned char subjectSlot = getClientSlot(subject);
+        Baseline& baseline = receiverBaselines[subjectSlot];
+        const NetQuantizedMovement& movement = movements[subjectSlot];
+        const uint8_t fields = needsFullState(receiverSlot, subjectSlot)
+                                   ? packets::MF_AllFields | packets::MF_Full
+                                   : packets::getChangedMovementFields(baseline.movement, movement);
+        if (!fields)
+        {
+            continue;
+        }
+        if (static_cast<size_t>(end - dest) < sizeof(packets::WorldSnapshotEntry) + packets::getMovementFieldsSize(fields))
+        {
+            break;
+        }
+        dest += packets::writeWorldSnapshotEntry(dest, subject, fields, movement);
+        baseline.movement = movement;
+        baseline.valid = true;
+        baseline.shown = true;
+        ++playerCount;
+    }
+    if (!playerCount)
+    {
+        bufferPool.freeBuffer(buffer);
+        return nullptr;
+    }
+    const uint16_t sequence = static_cast<uint16_t>(sentSequences[receiverSlot] + 1U);
+    // zero marks snapshots which are not acknowledged
+    sentSequences[receiverSlot] = sequence ? sequence : 1U;
+    const packets::S2C_WorldSnapshot header{ packets::S2C_HWorldSnapshot, {}, sentSequences[receiverSlot], serverTime, playerCount };
+    memcpy(buffer->getPointer(), &header, sizeof(packets::S2C_WorldSnapshot));
+    buffer->setUsedSize(dest - buffer->getPointer());
+    return buffer;
+}
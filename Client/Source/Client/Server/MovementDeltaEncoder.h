@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Client/Server/BufferPool.h"
+#include "Client/Shared/Packets.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Maximum amount of world snapshots a receiver may leave unacknowledged.
+ * Once exceeded, the receiver gets full states until it acknowledges again.
+ */
+#define MOVEMENT_ACK_WINDOW 64
+
+namespace spacemma
+{
+    /**
+     * Encodes S2C_WorldSnapshot packets with delta updates of every player (subject) for every receiving client.
+     * For each pair of receiver and subject slot the last state sent to the receiver is kept as the baseline,
+     * so that only the fields which changed since are sent. The stream is ordered, so a baseline is valid as soon
+     * as it is sent; the receiver acknowledges the sequences it applied and requests a resync if it missed
+     * an update, after which all subjects are sent with full states. Subjects which left the receiver's area of interest
+     * are sent as entries without fields, so that the receiver hides them. Used only by the game thread.
+     */
+    class MovementDeltaEncoder final
+    {
+    public:
+        MovementDeltaEncoder(unsigned char slotCount);
+        ~MovementDeltaEncoder() = default;
+        MovementDeltaEncoder(MovementDeltaEncoder&) = delete;
+        MovementDeltaEncoder(MovementDeltaEncoder&&) = delete;
+        MovementDeltaEncoder& operator=(MovementDeltaEncoder&) = delete;
+        MovementDeltaEncoder& operator=(MovementDeltaEncoder&&) = delete;
+        /**
+         * Forgets all baselines and sequences of the receiver, so that it gets full states of all subjects.
+         */
+        void resetReceiver(unsigned char receiverSlot);
+        /**
+         * Forgets the baselines of the subject for all receivers, so that they get its full state.
+         */
+        void resetSubject(unsigned char subjectSlot);
+        /**
+         * Handles the acknowledgement of the receiver. If resync is set, all baselines of the receiver are dropped.
+         */
+        void acknowledge(unsigned char receiverSlot, uint16_t sequence, bool resync);
+        /**
+         * Returns true if the next update of the subject for the receiver will be a full state, false otherwise.
+         */
+        bool needsFullState(unsigned char receiverSlot, unsigned char subjectSlot) const;
+        /**
+         * Returns true if the receiver may show the subject, false if it was told that the subject left its area of interest
+         * and was not sent the subject since.
+         */
+        bool isShown(unsigned char receiverSlot, unsigned char subjectSlot) const;
+        /**
+         * Encodes a world snapshot with the updates of the subjects for the receiver and stores them as the new baselines.
+         * The leaving subjects are encoded first as entries without fields, those which do not fit stay shown.
+         * The movements are indexed by the subjects' slots. Subjects which did not change since their baselines are left out.
+         * The subjects are encoded in the given order until the next entry would not fit within maxSize,
+         * encodedCount is set to the amount of subjects which were either encoded or left out as unchanged.
+         * The snapshot is stamped with the given server time in milliseconds.
+         * Returns null pointer if no subject was encoded or the buffer could not be acquired.
+         */
+        ByteBuffer* encodeSnapshot(BufferPool& bufferPool, unsigned char receiverSlot, gsl::span<const unsigned short> subjects,
+                                   gsl::span<const unsigned short> leavingSubjects,
+                                   gsl::span<const NetQuantizedMovement> movements, uint32_t serverTime, size_t maxSize,
+                                   size_t& encodedCount);
+    private:
+        struct Baseline final
+        {
+            NetQuantizedMovement movement{};
+            bool valid{};
+            // a receiver shows every subject until it is told that the subject left its area of interest
+            bool shown{ true };
+        };
+        size_t slotCount;
+        // indexed by receiverSlot * slotCount + subjectSlot
+        std::vector<Baseline> baselines{};
+        std::vector<uint16_t> sentSequences{}, ackedSequences{};
+    };
+}
@@ -0,0 +1,80 @@
+#include "MovementPredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+void spacemma::MovementPredictor::reset()
+{
+    count = 0;
+    resetSequence = inputSequence;
+    ackedSequence = inputSequence;
+    stateTime = 0.0;
+    pendingCorrection = FVector::ZeroVector;
+}
+
+uint16_t spacemma::MovementPredictor::nextInputSequence()
+{
+    return ++inputSequence;
+}
+
+void spacemma::MovementPredictor::record(double time, const FVector& location)
+{
+    if (count && time <= samples[newest].time)
+    {
+        return;
+    }
+    newest = (newest + 1) % MOVEMENT_PREDICTION_HISTORY;
+    // the history holds where the player should be, including the part of the correction not applied yet
+    samples[newest] = Sample{ time, location + pendingCorrection };
+    count = std::min<size_t>(count + 1, MOVEMENT_PREDICTION_HISTORY);
+}
+
+bool spacemma::MovementPredictor::reconcile(uint16_t sequence, double time, const FVector& location)
+{
+    if (!count || static_cast<int16_t>(sequence - resetSequence) <= 0 ||
+        static_cast<int16_t>(sequence - ackedSequence) < 0 || time <= stateTime)
+    {
+        return false;
+    }
+    FVector predicted = getSample(0).location;
+    if (time < getSample(0).time)
+    {
+        size_t age = 1;
+        while (age < count && getSample(age).time > time)
+        {
+            ++age;
+        }
+        if (age == count)
+        {
+            return false;
+        }
+        const Sample& older = getSample(age);
+        const Sample& newer = getSample(age - 1);
+        predicted = FMath::Lerp(older.location, newer.location, static_cast<float>((time - older.time) / (newer.time - older.time)));
+    }
+    ackedSequence = sequence;
+    stateTime = time;
+    const FVector error = location - predicted;
+    for (size_t age = 0; age < count; ++age)
+    {
+        samples[(newest + MOVEMENT_PREDICTION_HISTORY - age) % MOVEMENT_PREDICTION_HISTORY].location += error;
+    }
+    pendingCorrection += error;
+    return true;
+}
+
+FVector spacemma::MovementPredictor::takeCorrection(float deltaTime, float smoothingTime, float snapDistance)
+{
+    FVector correction = pendingCorrection;
+    if (smoothingTime > 0.0f && pendingCorrection.Size() <= snapDistance)
+    {
+        correction *= 1.0f - std::exp(-deltaTime / smoothingTime);
+    }
+    pendingCorrection -= correction;
+    return correction;
+}
+
+const spacemma::MovementPredictor::Sample& spacemma::MovementPredictor::getSample(size_t age) const
+{
+    return samples[(newest + MOVEMENT_PREDICTION_HISTORY - age) % MOVEMENT_PREDICTION_HISTORY];
+}
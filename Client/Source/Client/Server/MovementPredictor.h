@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <cstdint>
+
+#define MOVEMENT_PREDICTION_HISTORY 256
+
+namespace spacemma
+{
+    /**
+     * Keeps the locally predicted locations of the own player and reconciles them with the authoritative ones.
+     * Replaying the inputs which the server has not processed yet from the authoritative location offsets the prediction
+     * by the error at the time of the authoritative state, so that error is added to the recorded history and handed
+     * out as a correction, which is smoothed unless it is too large.
+     */
+    class MovementPredictor final
+    {
+    public:
+        MovementPredictor() = default;
+        ~MovementPredictor() = default;
+        MovementPredictor(MovementPredictor&) = delete;
+        MovementPredictor(MovementPredictor&&) = delete;
+        MovementPredictor& operator=(MovementPredictor&) = delete;
+        MovementPredictor& operator=(MovementPredictor&&) = delete;
+        /**
+         * Forgets the history and the pending correction, e.g. after the player was teleported.
+         * Authoritative states which do not acknowledge any newer input are ignored afterwards.
+         */
+        void reset();
+        /**
+         * Returns the sequence of a new movement input.
+         */
+        uint16_t nextInputSequence();
+        /**
+         * Records the location of the player at the local time in seconds.
+         */
+        void record(double time, const FVector& location);
+        /**
+         * Reconciles the prediction with the authoritative location, which the player had at the local time in seconds
+         * after the server processed the input with the given sequence.
+         * Returns false if the state is outdated or older than the history, true otherwise.
+         */
+        bool reconcile(uint16_t inputSequence, double time, const FVector& location);
+        /**
+         * Returns the part of the pending correction to apply after deltaTime seconds, all of it if it is larger
+         * than snapDistance.
+         */
+        FVector takeCorrection(float deltaTime, float smoothingTime, float snapDistance);
+    private:
+        struct Sample final
+        {
+            double time;
+            FVector location;
+        };
+        const Sample& getSample(size_t age) const;
+        Sample samples[MOVEMENT_PREDICTION_HISTORY]{};
+        size_t newest{ 0 };
+        size_t count{ 0 };
+        uint16_t inputSequence{ 0 }, resetSequence{ 0 }, ackedSequence{ 0 };
+        double stateTime{ 0.0 };
+        FVector pendingCorrection{ FVector::ZeroVector };
+    };
+}
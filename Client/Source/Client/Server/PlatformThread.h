@@ -0,0 +1,19 @@
+#pragma once
+
+#if PLATFORM_WINDOWS
+#include "WinThread.h"
+#elif PLATFORM_LINUX
+#include "PosixThread.h"
+#endif
+
+namespace spacemma
+{
+    /**
+     * The Thread implementation native to the platform being compiled for.
+     */
+#if PLATFORM_WINDOWS
+    using PlatformThread = WinThread;
+#elif PLATFORM_LINUX
+    using PlatformThread = PosixThread;
+#endif
+}
@@ -0,0 +1,126 @@
+#include "PlayerStateStore.h"
+
+#include <cmath>
+
+spacemma::PlayerStateStore::PlayerStateStore(unsigned char slotCount) : slotCount(slotCount)
+{
+    for (std::vector<float>* values : { &positionX, &positionY, &positionZ, &pitch, &yaw, &roll,
+                                        &velocityX, &velocityY, &velocityZ, &sentPositionX, &sentPositionY,
+                                        &sentPositionZ, &sentPitch, &sentYaw, &sentRoll })
+    {
+        values->resize(slotCount, 0.0f);
+    }
+    active.resize(slotCount, 0U);
+    moving.resize(slotCount, 0U);
+    dirty.resize(slotCount, 0U);
+}
+
+void spacemma::PlayerStateStore::activate(unsigned char slot, const FVector& position, const FRotator& rotation,
+                                          const FVector& velocity)
+{
+    update(slot, position, rotation, velocity);
+    sentPositionX[slot] = position.X;
+    sentPositionY[slot] = position.Y;
+    sentPositionZ[slot] = position.Z;
+    sentPitch[slot] = rotation.Pitch;
+    sentYaw[slot] = rotation.Yaw;
+    sentRoll[slot] = rotation.Roll;
+    active[slot] = 1U;
+    moving[slot] = 0U;
+    dirty[slot] = 0U;
+}
+
+void spacemma::PlayerStateStore::deactivate(unsigned char slot)
+{
+    active[slot] = 0U;
+    moving[slot] = 0U;
+    dirty[slot] = 0U;
+}
+
+void spacemma::PlayerStateStore::update(unsigned char slot, const FVector& position, const FRotator& rotation,
+                                        const FVector& velocity)
+{
+    positionX[slot] = position.X;
+    positionY[slot] = position.Y;
+    positionZ[slot] = position.Z;
+    pitch[slot] = rotation.Pitch;
+    yaw[slot] = rotation.Yaw;
+    roll[slot] = rotation.Roll;
+    velocityX[slot] = velocity.X;
+    velocityY[slot] = velocity.Y;
+    velocityZ[slot] = velocity.Z;
+}
+
+size_t spacemma::PlayerStateStore::detectChanges()
+{
+    // local copies keep the compiler from assuming that writing the flags changes the arrays or the slot count
+    const size_t count = slotCount;
+    const float* px = positionX.data(), * py = positionY.data(), * pz = positionZ.data();
+    const float* sx = sentPositionX.data(), * sy = sentPositionY.data(), * sz = sentPositionZ.data();
+    const float* rp = pitch.data(), * ry = yaw.data(), * rr = roll.data();
+    const float* sp = sentPitch.data(), * sw = sentYaw.data(), * sr = sentRoll.data();
+    const float* vx = velocityX.data(), * vy = velocityY.data(), * vz = velocityZ.data();
+    const uint32_t* isActive = active.data();
+    uint32_t* isMoving = moving.data(), * isDirty = dirty.data();
+    size_t dirtyCount = 0;
+    // branchless on purpose, so that the loop can be vectorized
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t moved = static_cast<uint32_t>(
+            (std::fabs(vx[i]) > PLAYER_STATE_VELOCITY_TOLERANCE) | (std::fabs(vy[i]) > PLAYER_STATE_VELOCITY_TOLERANCE) |
+            (std::fabs(vz[i]) > PLAYER_STATE_VELOCITY_TOLERANCE) | (px[i] != sx[i]) | (py[i] != sy[i]) |
+            (pz[i] != sz[i]) | (rp[i] != sp[i]) | (ry[i] != sw[i]) | (rr[i] != sr[i])) & isActive[i];
+        const uint32_t changed = moved | isMoving[i];
+        isDirty[i] = changed;
+        isMoving[i] = moved;
+        dirtyCount += changed;
+    }
+    return dirtyCount;
+}
+
+void spacemma::PlayerStateStore::markSent()
+{
+    for (size_t i = 0; i < slotCount; ++i)
+    {
+        if (dirty[i])
+        {
+            sentPositionX[i] = positionX[i];
+            sentPositionY[i] = positionY[i];
+            sentPositionZ[i] = positionZ[i];
+            sentPitch[i] = pitch[i];
+            sentYaw[i] = yaw[i];
+            sentRoll[i] = roll[i];
+            dirty[i] = 0U;
+        }
+    }
+}
+
+bool spacemma::PlayerStateStore::isActive(unsigned char slot) const
+{
+    return active[slot];
+}
+
+bool spacemma::PlayerStateStore::isDirty(unsigned char slot) const
+{
+    return dirty[slot];
+}
+
+FVector spacemma::PlayerStateStore::getPosition(unsigned char slot) const
+{
+    return FVector(positionX[slot], positionY[slot], positionZ[slot]);
+}
+
+FRotator spacemma::PlayerStateStore::getRotation(unsigned char slot) const
+{
+    return FRotator(pitch[slot], yaw[slot], roll[slot]);
+}
+
+FVector spacemma::PlayerStateStore::getVelocity(unsigned char slot) const
+{
+    return FVector(velocityX[slot], velocityY[slot], velocityZ[slot]);
+}
+
+unsigned char spacemma::PlayerStateStore::getSlotCount() const
+{
+    return static_cast<unsigned char>(slotCount);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <cstdint>
+#include <vector>
+
+#define PLAYER_STATE_VELOCITY_TOLERANCE KINDA_SMALL_NUMBER
+
+namespace spacemma
+{
+    /**
+     * Movement state of all players kept as a structure of arrays indexed by client slot.
+     * The state is refreshed from the actors once per tick, so that change detection and packet encoding
+     * walk contiguous arrays instead of the actors and the per-client data.
+     */
+    class PlayerStateStore final
+    {
+    public:
+        PlayerStateStore(unsigned char slotCount);
+        ~PlayerStateStore() = default;
+        PlayerStateStore(PlayerStateStore&) = delete;
+        PlayerStateStore(PlayerStateStore&&) = delete;
+        PlayerStateStore& operator=(PlayerStateStore&) = delete;
+        PlayerStateStore& operator=(PlayerStateStore&&) = delete;
+        /**
+         * Starts tracking the slot with the given state, which is treated as already sent.
+         */
+        void activate(unsigned char slot, const FVector& position, const FRotator& rotation, const FVector& velocity);
+        /**
+         * Stops tracking the slot. Inactive slots are never dirty.
+         */
+        void deactivate(unsigned char slot);
+        /**
+         * Stores the current state of the slot.
+         */
+        void update(unsigned char slot, const FVector& position, const FRotator& rotation, const FVector& velocity);
+        /**
+         * Marks the slots which moved since their state was last sent, or moved when it was sent,
+         * so that a player coming to a halt is sent once more. Returns the amount of dirty slots.
+         */
+        size_t detectChanges();
+        /**
+         * Stores the current state of every dirty slot as sent and clears the dirty flags.
+         */
+        void markSent();
+        /**
+         * Returns true if the slot is tracked, false otherwise.
+         */
+        bool isActive(unsigned char slot) const;
+        /**
+         * Returns true if the slot was marked by the last detectChanges call and not sent yet, false otherwise.
+         */
+        bool isDirty(unsigned char slot) const;
+        /**
+         * Returns the current position of the slot.
+         */
+        FVector getPosition(unsigned char slot) const;
+        /**
+         * Returns the current rotation of the slot.
+         */
+        FRotator getRotation(unsigned char slot) const;
+        /**
+         * Returns the current velocity of the slot.
+         */
+        FVector getVelocity(unsigned char slot) const;
+        /**
+         * Returns the amount of slots.
+         */
+        unsigned char getSlotCount() const;
+    private:
+        size_t slotCount;
+        std::vector<float> positionX{}, positionY{}, positionZ{};
+        std::vector<float> pitch{}, yaw{}, roll{};
+        std::vector<float> velocityX{}, velocityY{}, velocityZ{};
+        std::vector<float> sentPositionX{}, sentPositionY{}, sentPositionZ{};
+        std::vector<float> sentPitch{}, sentYaw{}, sentRoll{};
+        // the flags are as wide as the state values, so that detectChanges can be vectorized
+        std::vector<uint32_t> active{}, moving{}, dirty{};
+    };
+}
@@ -0,0 +1,58 @@
+#include "PlayoutClock.h"
+
+#include <algorithm>
+
+spacemma::PlayoutClock::PlayoutClock(float minDelay, float maxDelay)
+    : minDelay(minDelay), maxDelay(std::max(minDelay, maxDelay)), delay(minDelay) {}
+
+double spacemma::PlayoutClock::onSnapshot(uint32_t serverTime, double localTime)
+{
+    if (!synchronized)
+    {
+        synchronized = true;
+        serverTimeMs = serverTime;
+        lastServerTime = serverTime;
+        lastLocalTime = localTime;
+        offset = serverTimeMs / 1000.0 - localTime;
+        return serverTimeMs / 1000.0;
+    }
+    const int32_t serverDelta = static_cast<int32_t>(serverTime - lastServerTime);
+    serverTimeMs += serverDelta;
+    lastServerTime = serverTime;
+    const double time = serverTimeMs / 1000.0;
+    const double sampleOffset = time - localTime;
+    offset = std::max(sampleOffset, offset - PLAYOUT_OFFSET_DECAY * (localTime - lastLocalTime));
+    lastLocalTime = localTime;
+    jitter += (static_cast<float>(offset - sampleOffset) - jitter) * PLAYOUT_SMOOTHING;
+    if (serverDelta > 0)
+    {
+        interval += (serverDelta / 1000.0f - interval) * PLAYOUT_SMOOTHING;
+    }
+    delay = std::min(std::max(interval + PLAYOUT_JITTER_MULTIPLIER * jitter, minDelay), maxDelay);
+    return time;
+}
+
+double spacemma::PlayoutClock::getServerTime(double localTime) const
+{
+    return localTime + offset;
+}
+
+double spacemma::PlayoutClock::getRenderTime(double localTime) const
+{
+    return localTime + offset - delay;
+}
+
+float spacemma::PlayoutClock::getPlayoutDelay() const
+{
+    return delay;
+}
+
+float spacemma::PlayoutClock::getJitter() const
+{
+    return jitter;
+}
+
+bool spacemma::PlayoutClock::isSynchronized() const
+{
+    return synchronized;
+}
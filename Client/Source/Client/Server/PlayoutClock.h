@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+/** Portion of the difference to a new measurement by which the jitter and snapshot interval estimates move. */
+#define PLAYOUT_SMOOTHING 0.1f
+/** Seconds per second by which the clock offset estimate decays, so that it follows clock drift and rising latency. */
+#define PLAYOUT_OFFSET_DECAY 0.01
+/** Amount of measured jitter added to the snapshot interval to get the playout delay. */
+#define PLAYOUT_JITTER_MULTIPLIER 2.0f
+
+namespace spacemma
+{
+    /**
+     * Maps the local time to the server time at which received movement should be rendered.
+     * The clock offset follows the least delayed snapshots, the jitter is the smoothed amount by which snapshots arrive
+     * later than those. The playout delay covers the interval between snapshots and the jitter, so that there usually
+     * is a newer snapshot to interpolate towards, and adapts as the network conditions change.
+     */
+    class PlayoutClock final
+    {
+    public:
+        PlayoutClock(float minDelay, float maxDelay);
+        ~PlayoutClock() = default;
+        PlayoutClock(PlayoutClock&) = delete;
+        PlayoutClock(PlayoutClock&&) = delete;
+        PlayoutClock& operator=(PlayoutClock&) = delete;
+        PlayoutClock& operator=(PlayoutClock&&) = delete;
+        /**
+         * Registers a snapshot stamped with the server time in milliseconds (wrapping around), which arrived
+         * at the local time in seconds. Returns the server time of the snapshot in seconds.
+         */
+        double onSnapshot(uint32_t serverTime, double localTime);
+        /**
+         * Returns the estimated server time in seconds at the local time.
+         */
+        double getServerTime(double localTime) const;
+        /**
+         * Returns the server time in seconds which should be rendered at the local time.
+         */
+        double getRenderTime(double localTime) const;
+        /**
+         * Returns the current playout delay in seconds.
+         */
+        float getPlayoutDelay() const;
+        /**
+         * Returns the measured jitter in seconds.
+         */
+        float getJitter() const;
+        /**
+         * Returns true if any snapshot was registered, false otherwise.
+         */
+        bool isSynchronized() const;
+    private:
+        float minDelay, maxDelay;
+        bool synchronized{ false };
+        uint32_t lastServerTime{ 0 };
+        int64_t serverTimeMs{ 0 };
+        double offset{ 0.0 }, lastLocalTime{ 0.0 };
+        float jitter{ 0.0f }, interval{ 0.0f }, delay;
+    };
+}
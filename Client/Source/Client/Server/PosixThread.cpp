@@ -0,0 +1,301 @@
+#if PLATFORM_LINUX
+#include "PosixThread.h"
+#include "SpaceLog.h"
+
+#include <cerrno>
+#include <ctime>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+spacemma::PosixThread::PosixThread()
+{
+    interruptFd = eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (interruptFd == -1)
+    {
+        SPACEMMA_CATEGORY_ERROR(Thread, "Failed to create the thread interrupt eventfd ({})! Sleeps will not be interruptible.", errno);
+    }
+}
+
+spacemma::PosixThread::~PosixThread()
+{
+    if (joinable)
+    {
+        if (running && !join())
+        {
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to join thread while destroying the object, terminating...");
+            if (!terminate())
+            {
+                SPACEMMA_CATEGORY_ERROR(Thread, "Failed to terminate thread while destroying the object!");
+            }
+        }
+        if (joinable)
+        {
+            pthread_detach(threadHandle);
+            joinable = false;
+        }
+    }
+    if (interruptFd != -1)
+    {
+        ::close(interruptFd);
+    }
+}
+
+bool spacemma::PosixThread::run(ThreadFunc func, void* _ptr)
+{
+    std::lock_guard lock(mutex);
+    if (running)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Attempted to invoke run on a thread that is already running!");
+        return false;
+    }
+    if (joinable)
+    {
+        pthread_join(threadHandle, nullptr);
+        joinable = false;
+    }
+    running = true;
+    finished = false;
+    interrupted = false;
+    tid = 0;
+    if (interruptFd != -1)
+    {
+        // consume the interrupt of the previous run
+        eventfd_t value;
+        eventfd_read(interruptFd, &value);
+    }
+    this->threadFunc = func;
+    this->ptr = _ptr;
+    if (int ret = pthread_create(&threadHandle, nullptr, threadProc, this); ret != 0)
+    {
+        SPACEMMA_CATEGORY_ERROR(Thread, "Failed to create a thread ({})!", ret);
+        running = false;
+        return false;
+    }
+    joinable = true;
+    return true;
+}
+
+bool spacemma::PosixThread::isRunning()
+{
+    if (running && finished)
+    {
+        running = false;
+    }
+    return running;
+}
+
+void spacemma::PosixThread::interrupt()
+{
+    if (!interrupted.exchange(true) && interruptFd != -1 && eventfd_write(interruptFd, 1U) == -1)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to signal the thread interrupt ({})!", errno);
+    }
+}
+
+bool spacemma::PosixThread::isInterrupted()
+{
+    return interrupted;
+}
+
+bool spacemma::PosixThread::join()
+{
+    std::lock_guard lock(mutex);
+    if (!joinable)
+    {
+        running = false;
+        return true;
+    }
+    interrupt();
+    timespec deadline{};
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += THREAD_JOIN_TIMEOUT / 1000;
+    deadline.tv_nsec += (THREAD_JOIN_TIMEOUT % 1000) * 1'000'000L;
+    if (deadline.tv_nsec >= 1'000'000'000L)
+    {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1'000'000'000L;
+    }
+    switch (int ret = pthread_timedjoin_np(threadHandle, nullptr, &deadline))
+    {
+    case 0:
+        running = false;
+        joinable = false;
+        return true;
+    case ETIMEDOUT:
+        SPACEMMA_CATEGORY_WARN(Thread, "Thread join attempt timed out!");
+        return false;
+    default:
+        SPACEMMA_CATEGORY_ERROR(Thread, "Thread join attempt failed ({})!", ret);
+        running = false;
+        return false;
+    }
+}
+
+bool spacemma::PosixThread::terminate()
+{
+    std::lock_guard lock(mutex);
+    if (!joinable)
+    {
+        return true;
+    }
+    if (int ret = pthread_cancel(threadHandle); ret != 0 && ret != ESRCH)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Thread termination attempt failed ({})!", ret);
+        return false;
+    }
+    pthread_join(threadHandle, nullptr);
+    running = false;
+    joinable = false;
+    return true;
+}
+
+bool spacemma::PosixThread::sleep(uint32_t milliseconds)
+{
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t deadline = now.tv_sec * 1000LL + now.tv_nsec / 1'000'000L + milliseconds;
+    while (!interrupted)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t remaining = deadline - (now.tv_sec * 1000LL + now.tv_nsec / 1'000'000L);
+        if (remaining <= 0)
+        {
+            return true;
+        }
+        pollfd interruptPoll{ interruptFd, POLLIN, 0 };
+        // a negative descriptor is ignored by poll, which then sleeps for the whole timeout
+        if (poll(&interruptPoll, 1U, static_cast<int>(remaining)) == -1 && errno != EINTR)
+        {
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to wait for the thread interrupt ({})!", errno);
+            return !interrupted;
+        }
+    }
+    return false;
+}
+
+bool spacemma::PosixThread::setName(const std::string& _name)
+{
+    std::lock_guard lock(settingsMutex);
+    name = _name;
+    return !tid || finished || applyName(threadHandle);
+}
+
+bool spacemma::PosixThread::setAffinity(uint64_t _cpuMask)
+{
+    std::lock_guard lock(settingsMutex);
+    cpuMask = _cpuMask;
+    return !tid || finished || applyAffinity(threadHandle);
+}
+
+bool spacemma::PosixThread::setPriority(ThreadPriority _priority)
+{
+    std::lock_guard lock(settingsMutex);
+    priority = _priority;
+    return !tid || finished || applyPriority(threadHandle, tid);
+}
+
+pthread_t spacemma::PosixThread::getThreadId() const
+{
+    return threadHandle;
+}
+
+int spacemma::PosixThread::getInterruptFd() const
+{
+    return interruptFd;
+}
+
+bool spacemma::PosixThread::applyName(pthread_t thread) const
+{
+    if (name.empty())
+    {
+        return true;
+    }
+    if (int ret = pthread_setname_np(thread, name.substr(0U, POSIX_THREAD_NAME_LENGTH).c_str()); ret != 0)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the name of thread '{}' ({})!", name, ret);
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::PosixThread::applyAffinity(pthread_t thread) const
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (unsigned int cpu = 0U; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!cpuMask || (cpu < 64U && (cpuMask >> cpu) & 1U))
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (int ret = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpus); ret != 0)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the affinity of thread '{}' to {:#x} ({})!", name, cpuMask, ret);
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::PosixThread::applyPriority(pthread_t thread, pid_t threadTid) const
+{
+    sched_param param{};
+    int policy = SCHED_OTHER;
+    if (priority == ThreadPriority::Realtime)
+    {
+        policy = SCHED_FIFO;
+        param.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+    }
+    if (int ret = pthread_setschedparam(thread, policy, &param); ret != 0)
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the scheduling policy of thread '{}' ({})!", name, ret);
+        return false;
+    }
+    if (policy == SCHED_OTHER)
+    {
+        const int nice = priority == ThreadPriority::Low ? POSIX_THREAD_LOW_NICE
+                             : priority == ThreadPriority::High ? POSIX_THREAD_HIGH_NICE : 0;
+        // on Linux the nice value is a property of the kernel thread, not of the whole process
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(threadTid), nice) == -1)
+        {
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the nice value of thread '{}' to {} ({})!", name, nice, errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void* spacemma::PosixThread::threadProc(void* param)
+{
+    PosixThread* thread = reinterpret_cast<PosixThread*>(param);
+    {
+        std::lock_guard lock(thread->settingsMutex);
+        thread->tid = static_cast<pid_t>(syscall(SYS_gettid));
+        thread->applyName(pthread_self());
+        if (thread->cpuMask)
+        {
+            thread->applyAffinity(pthread_self());
+        }
+        if (thread->priority != ThreadPriority::Normal)
+        {
+            thread->applyPriority(pthread_self(), thread->tid);
+        }
+    }
+    ThreadFunc threadFunc = thread->getThreadFunc();
+    if (threadFunc)
+    {
+        threadFunc(thread, thread->getPtr());
+    }
+    else
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "An empty thread has been started!");
+    }
+    thread->finished = true;
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#if PLATFORM_LINUX
+#include "Thread.h"
+#include "SpaceLog.h"
+
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define POSIX_THREAD_NAME_LENGTH 15
+#define POSIX_THREAD_LOW_NICE 5
+#define POSIX_THREAD_HIGH_NICE -5
+
+namespace spacemma
+{
+    /**
+     * Thread built on pthreads. Interrupts are signalled through an eventfd, so that sleeping threads
+     * and threads polling the descriptor returned by getInterruptFd wake up at once.
+     */
+    class PosixThread final : public Thread
+    {
+    public:
+        PosixThread();
+        ~PosixThread();
+        PosixThread(PosixThread&) = delete;
+        PosixThread(PosixThread&&) = delete;
+        PosixThread& operator=(PosixThread&) = delete;
+        PosixThread& operator=(PosixThread&&) = delete;
+        bool run(ThreadFunc func, void* ptr) override;
+        bool isRunning() override;
+        void interrupt() override;
+        bool isInterrupted() override;
+        bool join() override;
+        bool terminate() override;
+        bool sleep(uint32_t milliseconds) override;
+        bool setName(const std::string& name) override;
+        bool setAffinity(uint64_t cpuMask) override;
+        bool setPriority(ThreadPriority priority) override;
+        pthread_t getThreadId() const;
+        /**
+         * Returns the eventfd which becomes readable once the thread is interrupted,
+         * so that threads blocked in poll or epoll_wait can be woken up by interrupt.
+         */
+        int getInterruptFd() const;
+    private:
+        static void* threadProc(void* param);
+        /**
+         * Applies the settings to the given thread. The kernel thread ID is required for the nice value.
+         */
+        bool applyName(pthread_t thread) const;
+        bool applyAffinity(pthread_t thread) const;
+        bool applyPriority(pthread_t thread, pid_t tid) const;
+        std::atomic_bool interrupted{false}, running{false}, finished{false};
+        std::atomic<pid_t> tid{0};
+        std::mutex mutex;
+        pthread_t threadHandle{};
+        int interruptFd{-1};
+        bool joinable{false};
+    };
+}
+
+#endif
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#define RING_QUEUE_CACHE_LINE_SIZE 64
+
+namespace spacemma
+{
+    /**
+     * Rounds the given ring queue capacity up to the nearest power of two.
+     */
+    inline size_t getRingQueueCapacity(size_t capacity)
+    {
+        size_t result = 1ULL;
+        while (result < capacity)
+        {
+            result <<= 1U;
+        }
+        return result;
+    }
+
+    /**
+     * A bounded lock-free ring queue for a single producer thread and a single consumer thread.
+     * The capacity is rounded up to a power of two. Pushing to a full queue fails instead of blocking.
+     */
+    template <typename T>
+    class SPSCRingQueue final
+    {
+    public:
+        SPSCRingQueue(size_t capacity);
+        ~SPSCRingQueue();
+        SPSCRingQueue(SPSCRingQueue&) = delete;
+        SPSCRingQueue(SPSCRingQueue&&) = delete;
+        SPSCRingQueue& operator=(SPSCRingQueue&) = delete;
+        SPSCRingQueue& operator=(SPSCRingQueue&&) = delete;
+        /**
+         * Pushes the value to the queue. May only be called from the producer thread.
+         * Returns false if the queue is full, true otherwise.
+         */
+        bool push(const T& value);
+        /**
+         * Pushes as many of the given values as fit into the queue. May only be called from the producer thread.
+         * Returns the amount of values pushed.
+         */
+        size_t pushBulk(gsl::span<const T> values);
+        /**
+         * Pops the oldest value from the queue. May only be called from the consumer thread.
+         * Returns false if the queue is empty, true otherwise.
+         */
+        bool pop(T& value);
+        /**
+         * Pops up to values.size() oldest values from the queue. May only be called from the consumer thread.
+         * Returns the amount of values popped.
+         */
+        size_t popBulk(gsl::span<T> values);
+        /**
+         * Returns true if the queue contained no values at the moment of the call, false otherwise.
+         */
+        bool isEmpty() const;
+        /**
+         * Returns the amount of values contained in the queue at the moment of the call.
+         */
+        size_t getSize() const;
+        /**
+         * Returns the maximum amount of values that can be contained in the queue.
+         */
+        size_t getCapacity() const;
+    private:
+        T* slots;
+        size_t capacity, mask;
+        alignas(RING_QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> tail{ 0ULL };
+        size_t cachedHead{ 0ULL };
+        alignas(RING_QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> head{ 0ULL };
+        size_t cachedTail{ 0ULL };
+    };
+
+    /**
+     * A bounded lock-free ring queue for any amount of producer threads and a single consumer thread.
+     * The capacity is rounded up to a power of two. Pushing to a full queue fails instead of blocking.
+     */
+    template <typename T>
+    class MPSCRingQueue final
+    {
+    public:
+        MPSCRingQueue(size_t capacity);
+        ~MPSCRingQueue();
+        MPSCRingQueue(MPSCRingQueue&) = delete;
+        MPSCRingQueue(MPSCRingQueue&&) = delete;
+        MPSCRingQueue& operator=(MPSCRingQueue&) = delete;
+        MPSCRingQueue& operator=(MPSCRingQueue&&) = delete;
+        /**
+         * Pushes the value to the queue.
+         * Returns false if the queue is full, true otherwise.
+         */
+        bool push(const T& value);
+        /**
+         * Pushes as many of the given values as fit into the queue. The pushed values are kept together.
+         * Returns the amount of values pushed.
+         */
+        size_t pushBulk(gsl::span<const T> values);
+        /**
+         * Pops the oldest value from the queue. May only be called from the consumer thread.
+         * Returns false if the queue is empty, true otherwise.
+         */
+        bool pop(T& value);
+        /**
+         * Pops up to values.size() oldest values from the queue. May only be called from the consumer thread.
+         * Returns the amount of values popped.
+         */
+        size_t popBulk(gsl::span<T> values);
+        /**
+         * Returns true if the queue contained no values at the moment of the call, false otherwise.
+         */
+        bool isEmpty() const;
+        /**
+         * Returns the amount of values contained in the queue at the moment of the call.
+         */
+        size_t getSize() const;
+        /**
+         * Returns the maximum amount of values that can be contained in the queue.
+         */
+        size_t getCapacity() const;
+    private:
+        struct Cell
+        {
+            /** Equal to the cell's position when free and to the position + 1 once a value was written. */
+            std::atomic<size_t> sequence;
+            T value;
+        };
+        Cell* cells;
+        size_t capacity, mask;
+        alignas(RING_QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> tail{ 0ULL };
+        alignas(RING_QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> head{ 0ULL };
+    };
+
+    template <typename T>
+    SPSCRingQueue<T>::SPSCRingQueue(size_t capacity)
+        : capacity(getRingQueueCapacity(capacity)), mask(getRingQueueCapacity(capacity) - 1ULL)
+    {
+        slots = new T[this->capacity]{};
+    }
+
+    template <typename T>
+    SPSCRingQueue<T>::~SPSCRingQueue()
+    {
+        delete[] slots;
+        slots = nullptr;
+    }
+
+    template <typename T>
+    bool SPSCRingQueue<T>::push(const T& value)
+    {
+        const size_t pos = tail.load(std::memory_order_relaxed);
+        if (pos - cachedHead >= capacity)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (pos - cachedHead >= capacity)
+            {
+                return false;
+            }
+        }
+        slots[pos & mask] = value;
+        tail.store(pos + 1ULL, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    size_t SPSCRingQueue<T>::pushBulk(gsl::span<const T> values)
+    {
+        const size_t pos = tail.load(std::memory_order_relaxed);
+        size_t count = static_cast<size_t>(values.size());
+        if (capacity - (pos - cachedHead) < count)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            count = std::min(count, capacity - (pos - cachedHead));
+        }
+        if (count == 0ULL)
+        {
+            return 0ULL;
+        }
+        const size_t first = std::min(count, capacity - (pos & mask));
+        std::copy_n(values.begin(), first, slots + (pos & mask));
+        std::copy_n(values.begin() + first, count - first, slots);
+        tail.store(pos + count, std::memory_order_release);
+        return count;
+    }
+
+    template <typename T>
+    bool SPSCRingQueue<T>::pop(T& value)
+    {
+        const size_t pos = head.load(std::memory_order_relaxed);
+        if (pos == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (pos == cachedTail)
+            {
+                return false;
+            }
+        }
+        value = slots[pos & mask];
+        head.store(pos + 1ULL, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    size_t SPSCRingQueue<T>::popBulk(gsl::span<T> values)
+    {
+        const size_t pos = head.load(std::memory_order_relaxed);
+        size_t count = static_cast<size_t>(values.size());
+        if (cachedTail - pos < count)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            count = std::min(count, cachedTail - pos);
+        }
+        if (count == 0ULL)
+        {
+            return 0ULL;
+        }
+        const size_t first = std::min(count, capacity - (pos & mask));
+        std::copy_n(slots + (pos & mask), first, values.begin());
+        std::copy_n(slots, count - first, values.begin() + first);
+        head.store(pos + count, std::memory_order_release);
+        return count;
+    }
+
+    template <typename T>
+    bool SPSCRingQueue<T>::isEmpty() const
+    {
+        return getSize() == 0ULL;
+    }
+
+    template <typename T>
+    size_t SPSCRingQueue<T>::getSize() const
+    {
+        const size_t pos = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - pos;
+    }
+
+    template <typename T>
+    size_t SPSCRingQueue<T>::getCapacity() const
+    {
+        return capacity;
+    }
+
+    template <typename T>
+    MPSCRingQueue<T>::MPSCRingQueue(size_t capacity)
+        : capacity(getRingQueueCapacity(capacity)), mask(getRingQueueCapacity(capacity) - 1ULL)
+    {
+        cells = new Cell[this->capacity]{};
+        for (size_t i = 0ULL; i < this->capacity; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    MPSCRingQueue<T>::~MPSCRingQueue()
+    {
+        delete[] cells;
+        cells = nullptr;
+    }
+
+    template <typename T>
+    bool MPSCRingQueue<T>::push(const T& value)
+    {
+        return pushBulk(gsl::make_span(&value, 1)) == 1ULL;
+    }
+
+    template <typename T>
+    size_t MPSCRingQueue<T>::pushBulk(gsl::span<const T> values)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        size_t count;
+        do
+        {
+            // the consumer frees cells in order, so every cell before the head is free
+            count = std::min(static_cast<size_t>(values.size()), capacity - (pos - head.load(std::memory_order_acquire)));
+            if (count == 0ULL)
+            {
+                return 0ULL;
+            }
+        } while (!tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed));
+        for (size_t i = 0ULL; i < count; ++i)
+        {
+            Cell& cell = cells[(pos + i) & mask];
+            cell.value = values[i];
+            cell.sequence.store(pos + i + 1ULL, std::memory_order_release);
+        }
+        return count;
+    }
+
+    template <typename T>
+    bool MPSCRingQueue<T>::pop(T& value)
+    {
+        return popBulk(gsl::make_span(&value, 1)) == 1ULL;
+    }
+
+    template <typename T>
+    size_t MPSCRingQueue<T>::popBulk(gsl::span<T> values)
+    {
+        const size_t pos = head.load(std::memory_order_relaxed);
+        size_t count = 0ULL;
+        while (count < static_cast<size_t>(values.size()))
+        {
+            Cell& cell = cells[(pos + count) & mask];
+            // a producer may still be writing a claimed cell, the values after it are popped later
+            if (cell.sequence.load(std::memory_order_acquire) != pos + count + 1ULL)
+            {
+                break;
+            }
+            values[count] = cell.value;
+            cell.sequence.store(pos + count + capacity, std::memory_order_relaxed);
+            ++count;
+        }
+        if (count)
+        {
+            head.store(pos + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    template <typename T>
+    bool MPSCRingQueue<T>::isEmpty() const
+    {
+        return getSize() == 0ULL;
+    }
+
+    template <typename T>
+    size_t MPSCRingQueue<T>::getSize() const
+    {
+        const size_t pos = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - pos;
+    }
+
+    template <typename T>
+    size_t MPSCRingQueue<T>::getCapacity() const
+    {
+        return capacity;
+    }
+}
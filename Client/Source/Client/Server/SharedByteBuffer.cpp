@@ -0,0 +1,43 @@
+#include "SharedByteBuffer.h"
+
+spacemma::SharedByteBuffer::SharedByteBuffer(BufferPool& bufferPool, size_t size)
+    : bufferPool(&bufferPool), buffer(bufferPool.getBuffer(size)) {}
+
+spacemma::SharedByteBuffer::SharedByteBuffer(BufferPool& bufferPool, ByteBuffer* buffer)
+    : bufferPool(&bufferPool), buffer(buffer) {}
+
+spacemma::SharedByteBuffer::~SharedByteBuffer()
+{
+    if (buffer)
+    {
+        bufferPool->freeBuffer(buffer);
+        buffer = nullptr;
+    }
+}
+
+spacemma::SharedByteBuffer::SharedByteBuffer(SharedByteBuffer&& other) noexcept
+    : bufferPool(other.bufferPool), buffer(other.buffer)
+{
+    other.buffer = nullptr;
+}
+
+spacemma::ByteBuffer* spacemma::SharedByteBuffer::get() const
+{
+    return buffer;
+}
+
+spacemma::ByteBuffer* spacemma::SharedByteBuffer::operator->() const
+{
+    return buffer;
+}
+
+spacemma::SharedByteBuffer::operator bool() const
+{
+    return buffer != nullptr;
+}
+
+gsl::not_null<spacemma::ByteBuffer*> spacemma::SharedByteBuffer::share() const
+{
+    bufferPool->retainBuffer(buffer);
+    return buffer;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BufferPool.h"
+
+namespace spacemma
+{
+    /**
+     * Holds a single reference to a pool buffer and releases it when destroyed.
+     * Used to encode data once and hand the same buffer to many send queues.
+     */
+    class SharedByteBuffer final
+    {
+    public:
+        /**
+         * Acquires a buffer of the given size from the pool.
+         */
+        SharedByteBuffer(BufferPool& bufferPool, size_t size);
+        /**
+         * Takes over the reference held by the caller to the given buffer, which may be null.
+         */
+        SharedByteBuffer(BufferPool& bufferPool, ByteBuffer* buffer);
+        ~SharedByteBuffer();
+        SharedByteBuffer(SharedByteBuffer&) = delete;
+        SharedByteBuffer(SharedByteBuffer&& other) noexcept;
+        SharedByteBuffer& operator=(SharedByteBuffer&) = delete;
+        SharedByteBuffer& operator=(SharedByteBuffer&&) = delete;
+        /**
+         * Returns the held buffer or null pointer if the buffer could not be acquired.
+         */
+        ByteBuffer* get() const;
+        ByteBuffer* operator->() const;
+        explicit operator bool() const;
+        /**
+         * Returns the held buffer with a new reference added for the caller.
+         * The reference must be released with BufferPool::freeBuffer.
+         */
+        gsl::not_null<ByteBuffer*> share() const;
+    private:
+        BufferPool* bufferPool;
+        ByteBuffer* buffer;
+    };
+}
@@ -1,9 +1,13 @@
 #include "SpaceLog.h"
+#include "AsyncLogSink.h"
 #include "Client/Shared/UEConsoleSink.h"
 
 #include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
+#include <algorithm>
+#include <chrono>
+
 spdlog::logger* spacemma::SpaceLog::getLogger()
 {
     if (!logger)
@@ -13,10 +17,113 @@ spdlog::logger* spacemma::SpaceLog::getLogger()
             SPACEMMA_LOG_FILENAME, SPACEMMA_LOG_FILE_SIZE, SPACEMMA_LOG_MAX_FILES);
         auto ueSink = std::make_shared<UEConsoleSink_mt>();
         ueSink->set_pattern("[%Y-%m-%d %T.%e] [%s:%#] %v");
+#if SPACEMMA_LOG_ASYNC
+        asyncSink = std::make_shared<AsyncLogSink>(std::vector<spdlog::sink_ptr>{ ueSink, rotatingFileSink },
+                                                   SPACEMMA_LOG_QUEUE_CAPACITY,
+                                                   static_cast<LogOverflowPolicy>(SPACEMMA_LOG_OVERFLOW_POLICY));
+        logger = std::make_shared<spdlog::logger>(SPACEMMA_LOG_NAME, asyncSink);
+#else
         spdlog::sinks_init_list sinkList{ ueSink, rotatingFileSink };
         logger = std::make_shared<spdlog::logger>(SPACEMMA_LOG_NAME, sinkList);
+#endif
         logger->set_level(static_cast<spdlog::level::level_enum>(SPACEMMA_LOG_LEVEL));
         set_default_logger(logger);
     }
     return logger.get();
 }
+
+void spacemma::SpaceLog::setOverflowPolicy(LogOverflowPolicy policy)
+{
+    getLogger();
+    if (asyncSink)
+    {
+        asyncSink->setOverflowPolicy(policy);
+    }
+}
+
+uint64_t spacemma::SpaceLog::getDroppedCount()
+{
+    return asyncSink ? asyncSink->getDroppedCount() : 0;
+}
+
+void spacemma::SpaceLog::shutdown()
+{
+    if (asyncSink)
+    {
+        asyncSink->stop();
+    }
+}
+
+void spacemma::SpaceLog::setLevel(LogCategory category, spdlog::level::level_enum level)
+{
+    categoryLevels[static_cast<uint8_t>(category)] = static_cast<uint8_t>(level);
+}
+
+spdlog::level::level_enum spacemma::SpaceLog::getLevel(LogCategory category)
+{
+    return static_cast<spdlog::level::level_enum>(categoryLevels[static_cast<uint8_t>(category)].load());
+}
+
+bool spacemma::SpaceLog::setLevels(const std::string& levels)
+{
+    bool valid = true;
+    size_t pos = 0;
+    while (pos < levels.size())
+    {
+        size_t end = levels.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = levels.size();
+        }
+        const std::string pair = levels.substr(pos, end - pos);
+        pos = end + 1;
+        const size_t separator = pair.find('=');
+        if (separator == std::string::npos)
+        {
+            SPACEMMA_WARN("Invalid log level setting '{}'!", pair);
+            valid = false;
+            continue;
+        }
+        const std::string categoryName = pair.substr(0, separator), levelName = pair.substr(separator + 1);
+        const char* const* category = std::find_if(std::begin(CATEGORY_NAMES), std::end(CATEGORY_NAMES),
+                                                   [&categoryName](const char* name) { return categoryName == name; });
+        // from_str returns off for unknown names as well
+        const spdlog::level::level_enum level = spdlog::level::from_str(levelName);
+        if (category == std::end(CATEGORY_NAMES) || (level == spdlog::level::off && levelName != "off"))
+        {
+            SPACEMMA_WARN("Invalid log level setting '{}'!", pair);
+            valid = false;
+            continue;
+        }
+        setLevel(static_cast<LogCategory>(category - std::begin(CATEGORY_NAMES)), level);
+    }
+    return valid;
+}
+
+spacemma::LogRateLimiter::LogRateLimiter(uint32_t messagesPerSecond)
+    : interval(1'000'000'000LL / std::max<uint32_t>(messagesPerSecond, 1))
+{
+}
+
+bool spacemma::LogRateLimiter::tryAcquire(uint32_t& suppressed)
+{
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t full = fullAt.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const int64_t start = std::max(full, now);
+        // every message takes an interval out of the bucket, which holds a second worth of them
+        if (start + interval - now > 1'000'000'000LL)
+        {
+            suppressedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (fullAt.compare_exchange_weak(full, start + interval, std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+    suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+    return true;
+}
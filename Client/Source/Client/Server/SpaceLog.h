@@ -1,12 +1,18 @@
 #pragma once
 
+#if PLATFORM_WINDOWS
 #include "Windows/MinWindows.h"
 #define WIN32_LEAN_AND_MEAN
 #include <WinSock2.h>
 #include <windows.h>
+#endif
 #include <gsl/gsl-lite.hpp>
 #include "spdlog/spdlog.h"
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+
 #define SPACEMMA_LEVEL_TRACE 0
 #define SPACEMMA_LEVEL_DEBUG 1
 #define SPACEMMA_LEVEL_INFO 2
@@ -21,68 +27,262 @@
 #define SPACEMMA_LOG_LEVEL SPACEMMA_LEVEL_DEBUG
 #endif
 
+#define SPACEMMA_LOG_OVERFLOW_BLOCK 0
+#define SPACEMMA_LOG_OVERFLOW_DROP 1
+#define SPACEMMA_LOG_OVERFLOW_DROP_AND_COUNT 2
+
+// messages are written by a background thread, set to 0 to write them on the logging threads
+#ifndef SPACEMMA_LOG_ASYNC
+#define SPACEMMA_LOG_ASYNC 1
+#endif
+
+// the amount of messages waiting for the background thread before the overflow policy applies
+#ifndef SPACEMMA_LOG_QUEUE_CAPACITY
+#define SPACEMMA_LOG_QUEUE_CAPACITY 8192
+#endif
+
+#ifndef SPACEMMA_LOG_OVERFLOW_POLICY
+#define SPACEMMA_LOG_OVERFLOW_POLICY SPACEMMA_LOG_OVERFLOW_DROP_AND_COUNT
+#endif
+
+// the amount of messages a single rate-limited call site may log per second
+#ifndef SPACEMMA_LOG_RATE_LIMIT
+#define SPACEMMA_LOG_RATE_LIMIT 5
+#endif
+
+#define SPACEMMA_LOG_CATEGORY_COUNT 5
+
 #define SPACEMMA_LOGGER_CALL(logger, level, ...) (logger)->log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, level, __VA_ARGS__)
 
+// logs if the runtime level of the category allows it, category is a LogCategory enumerator name
+#define SPACEMMA_CATEGORY_CALL(category, level, ...) \
+    do \
+    { \
+        if (spacemma::SpaceLog::shouldLog(spacemma::LogCategory::category, level)) \
+        { \
+            SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), level, __VA_ARGS__); \
+        } \
+    } while (false)
+
+// as SPACEMMA_CATEGORY_CALL, but logs at most SPACEMMA_LOG_RATE_LIMIT messages per second from the call site,
+// the next message let through tells how many were suppressed
+#define SPACEMMA_CATEGORY_LIMITED_CALL(category, level, ...) \
+    do \
+    { \
+        static spacemma::LogRateLimiter spacemmaRateLimiter{ SPACEMMA_LOG_RATE_LIMIT }; \
+        uint32_t spacemmaSuppressed; \
+        if (spacemma::SpaceLog::shouldLog(spacemma::LogCategory::category, level) \
+            && spacemmaRateLimiter.tryAcquire(spacemmaSuppressed)) \
+        { \
+            if (spacemmaSuppressed) \
+            { \
+                SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), level, "{} ({} similar messages suppressed)", \
+                                     fmt::format(__VA_ARGS__), spacemmaSuppressed); \
+            } else \
+            { \
+                SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), level, __VA_ARGS__); \
+            } \
+        } \
+    } while (false)
+
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_TRACE
 #define SPACEMMA_LOGGER_TRACE(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::trace, __VA_ARGS__)
 #define SPACEMMA_TRACE(...) SPACEMMA_LOGGER_TRACE(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_TRACE(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::trace, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_TRACE_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::trace, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_TRACE(logger, ...) (void)0
 #define SPACEMMA_TRACE(...) (void)0
+#define SPACEMMA_CATEGORY_TRACE(category, ...) (void)0
+#define SPACEMMA_CATEGORY_TRACE_LIMITED(category, ...) (void)0
 #endif
 
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_DEBUG
 #define SPACEMMA_LOGGER_DEBUG(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::debug, __VA_ARGS__)
 #define SPACEMMA_DEBUG(...) SPACEMMA_LOGGER_DEBUG(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_DEBUG(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::debug, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_DEBUG_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::debug, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_DEBUG(logger, ...) (void)0
 #define SPACEMMA_DEBUG(...) (void)0
+#define SPACEMMA_CATEGORY_DEBUG(category, ...) (void)0
+#define SPACEMMA_CATEGORY_DEBUG_LIMITED(category, ...) (void)0
 #endif
 
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_INFO
 #define SPACEMMA_LOGGER_INFO(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::info, __VA_ARGS__)
 #define SPACEMMA_INFO(...) SPACEMMA_LOGGER_INFO(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_INFO(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::info, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_INFO_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::info, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_INFO(logger, ...) (void)0
 #define SPACEMMA_INFO(...) (void)0
+#define SPACEMMA_CATEGORY_INFO(category, ...) (void)0
+#define SPACEMMA_CATEGORY_INFO_LIMITED(category, ...) (void)0
 #endif
 
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_WARN
 #define SPACEMMA_LOGGER_WARN(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::warn, __VA_ARGS__)
 #define SPACEMMA_WARN(...) SPACEMMA_LOGGER_WARN(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_WARN(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::warn, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_WARN_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::warn, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_WARN(logger, ...) (void)0
 #define SPACEMMA_WARN(...) (void)0
+#define SPACEMMA_CATEGORY_WARN(category, ...) (void)0
+#define SPACEMMA_CATEGORY_WARN_LIMITED(category, ...) (void)0
 #endif
 
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_ERROR
 #define SPACEMMA_LOGGER_ERROR(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::err, __VA_ARGS__)
 #define SPACEMMA_ERROR(...) SPACEMMA_LOGGER_ERROR(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_ERROR(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::err, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_ERROR_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::err, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_ERROR(logger, ...) (void)0
 #define SPACEMMA_ERROR(...) (void)0
+#define SPACEMMA_CATEGORY_ERROR(category, ...) (void)0
+#define SPACEMMA_CATEGORY_ERROR_LIMITED(category, ...) (void)0
 #endif
 
 #if SPACEMMA_LOG_LEVEL <= SPACEMMA_LEVEL_CRITICAL
 #define SPACEMMA_LOGGER_CRITICAL(logger, ...) SPACEMMA_LOGGER_CALL(spacemma::SpaceLog::getLogger(), spdlog::level::critical, __VA_ARGS__)
 #define SPACEMMA_CRITICAL(...) SPACEMMA_LOGGER_CRITICAL(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPACEMMA_CATEGORY_CRITICAL(category, ...) SPACEMMA_CATEGORY_CALL(category, spdlog::level::critical, __VA_ARGS__)
+#define SPACEMMA_CATEGORY_CRITICAL_LIMITED(category, ...) SPACEMMA_CATEGORY_LIMITED_CALL(category, spdlog::level::critical, __VA_ARGS__)
 #else
 #define SPACEMMA_LOGGER_CRITICAL(logger, ...) (void)0
 #define SPACEMMA_CRITICAL(...) (void)0
+#define SPACEMMA_CATEGORY_CRITICAL(category, ...) (void)0
+#define SPACEMMA_CATEGORY_CRITICAL_LIMITED(category, ...) (void)0
 #endif
 
 namespace spacemma
 {
+    class AsyncLogSink;
+
+    /**
+     * What happens to a message logged while the queue of the asynchronous logger is full.
+     */
+    enum class LogOverflowPolicy : uint8_t
+    {
+        /**
+         * The logging thread waits until the message fits into the queue.
+         */
+        Block = SPACEMMA_LOG_OVERFLOW_BLOCK,
+        /**
+         * The message is dropped.
+         */
+        Drop = SPACEMMA_LOG_OVERFLOW_DROP,
+        /**
+         * The message is dropped and the amount of dropped messages is logged once the queue drains.
+         */
+        DropAndCount = SPACEMMA_LOG_OVERFLOW_DROP_AND_COUNT
+    };
+
+    /**
+     * Subsystems of which the log levels can be changed at runtime.
+     */
+    enum class LogCategory : uint8_t
+    {
+        /**
+         * Sockets, connections and the packet stream.
+         */
+        Net,
+        /**
+         * Buffer and worker pools.
+         */
+        Pool,
+        /**
+         * Game server logic and the players.
+         */
+        Gameplay,
+        /**
+         * Game client logic.
+         */
+        Client,
+        /**
+         * Lifecycle and scheduling settings of the threads.
+         */
+        Thread
+    };
+
+    /**
+     * A token bucket limiting the amount of messages logged from a single call site.
+     * Every rejected message is counted, so that the next accepted one can tell how many were suppressed.
+     */
+    class LogRateLimiter final
+    {
+    public:
+        /**
+         * Creates the limiter letting through the given amount of messages per second, which may all come at once.
+         */
+        LogRateLimiter(uint32_t messagesPerSecond);
+        ~LogRateLimiter() = default;
+        LogRateLimiter(LogRateLimiter&) = delete;
+        LogRateLimiter(LogRateLimiter&&) = delete;
+        LogRateLimiter& operator=(LogRateLimiter&) = delete;
+        LogRateLimiter& operator=(LogRateLimiter&&) = delete;
+        /**
+         * Returns true and sets suppressed to the amount of messages rejected since the last accepted one
+         * if the message may be logged, false otherwise.
+         */
+        bool tryAcquire(uint32_t& suppressed);
+    private:
+        // the time in nanoseconds at which the bucket is full again, the bucket is empty while it is a second ahead
+        std::atomic<int64_t> fullAt{ 0 };
+        std::atomic<uint32_t> suppressedCount{ 0 };
+        int64_t interval;
+    };
+
     class SpaceLog final
     {
     public:
         SpaceLog() = delete;
         static spdlog::logger* getLogger();
+        /**
+         * Returns true if messages of the given level are logged for the category, false otherwise.
+         */
+        static bool shouldLog(LogCategory category, spdlog::level::level_enum level);
+        /**
+         * Sets the minimal level of the messages logged for the category.
+         * Levels below SPACEMMA_LOG_LEVEL have no effect, as those messages are not compiled in.
+         */
+        static void setLevel(LogCategory category, spdlog::level::level_enum level);
+        static spdlog::level::level_enum getLevel(LogCategory category);
+        /**
+         * Sets the levels of the categories from comma-separated category=level pairs, such as "net=warn,gameplay=info".
+         * The category names are net, pool, gameplay, client and thread, the level names are the ones of spdlog.
+         * Returns false if any of the pairs is invalid, true otherwise. The valid pairs are applied either way.
+         */
+        static bool setLevels(const std::string& levels);
+        /**
+         * Sets the overflow policy of the asynchronous logger. Has no effect if SPACEMMA_LOG_ASYNC is disabled.
+         */
+        static void setOverflowPolicy(LogOverflowPolicy policy);
+        /**
+         * Returns the amount of messages dropped by the asynchronous logger so far.
+         */
+        static uint64_t getDroppedCount();
+        /**
+         * Writes all queued messages and stops the background thread of the asynchronous logger.
+         * Messages logged afterwards are written on the logging threads.
+         */
+        static void shutdown();
     private:
         inline static std::shared_ptr<spdlog::logger> logger{};
+        inline static std::shared_ptr<AsyncLogSink> asyncSink{};
+        inline static std::atomic<uint8_t> categoryLevels[SPACEMMA_LOG_CATEGORY_COUNT]{
+            SPACEMMA_LOG_LEVEL, SPACEMMA_LOG_LEVEL, SPACEMMA_LOG_LEVEL, SPACEMMA_LOG_LEVEL, SPACEMMA_LOG_LEVEL };
+        inline static const char* const CATEGORY_NAMES[SPACEMMA_LOG_CATEGORY_COUNT]{ "net", "pool", "gameplay", "client", "thread" };
         inline static const std::string SPACEMMA_LOG_NAME{ "SpaceMMA" };
         inline static const std::string SPACEMMA_LOG_FILENAME{ "spacemma.log" };
         inline static const size_t SPACEMMA_LOG_FILE_SIZE{ 8'388'608ULL };
         inline static const size_t SPACEMMA_LOG_MAX_FILES{ 3ULL };
     };
+
+    inline bool SpaceLog::shouldLog(LogCategory category, spdlog::level::level_enum level)
+    {
+        return static_cast<uint8_t>(level) >= categoryLevels[static_cast<uint8_t>(category)].load(std::memory_order_relaxed);
+    }
 }
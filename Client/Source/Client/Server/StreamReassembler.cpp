@@ -0,0 +1,103 @@
+#include "StreamReassembler.h"
+#include "SpaceLog.h"
+
+#include <cassert>
+#include <cstring>
+
+spacemma::StreamReassembler::StreamReassembler(size_t capacity) : capacity(capacity) {}
+
+spacemma::StreamReassembler::~StreamReassembler()
+{
+    reset();
+}
+
+gsl::span<uint8_t> spacemma::StreamReassembler::getFreeSpace(BufferPool& pool)
+{
+    if (!buffer)
+    {
+        buffer = pool.getBuffer(capacity);
+        if (!buffer)
+        {
+            return {};
+        }
+        bufferPool = &pool;
+    }
+    return gsl::make_span<uint8_t>(buffer->getPointer() + usedSize, capacity - usedSize);
+}
+
+bool spacemma::StreamReassembler::commit(size_t received)
+{
+    assert(buffer && usedSize + received <= capacity);
+    const uint8_t* data = buffer->getPointer();
+    usedSize += received;
+    while (usedSize - completeSize >= TCP_FRAME_HEADER_SIZE)
+    {
+        FrameLength frameLength;
+        memcpy(&frameLength, data + completeSize, TCP_FRAME_HEADER_SIZE);
+        if (frameLength == 0 || frameLength > capacity - TCP_FRAME_HEADER_SIZE)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Received invalid frame length of {} (max {})!", frameLength, capacity - TCP_FRAME_HEADER_SIZE);
+            return false;
+        }
+        if (usedSize - completeSize - TCP_FRAME_HEADER_SIZE < frameLength)
+        {
+            break;
+        }
+        completeSize += TCP_FRAME_HEADER_SIZE + frameLength;
+    }
+    return true;
+}
+
+spacemma::ByteBuffer* spacemma::StreamReassembler::takeFrames()
+{
+    if (completeSize == 0)
+    {
+        return nullptr;
+    }
+    ByteBuffer* frames;
+    const size_t remainingSize = usedSize - completeSize;
+    if (completeSize < capacity / 2)
+    {
+        // a mostly empty staging buffer would pin its whole capacity downstream, so the frames are copied out instead
+        frames = bufferPool->getBuffer(completeSize);
+        if (!frames)
+        {
+            return nullptr;
+        }
+        memcpy(frames->getPointer(), buffer->getPointer(), completeSize);
+        memmove(buffer->getPointer(), buffer->getPointer() + completeSize, remainingSize);
+        usedSize = remainingSize;
+        completeSize = 0;
+        return frames;
+    }
+    frames = buffer;
+    if (remainingSize)
+    {
+        // only the beginning of a partially received frame is moved to the next staging buffer
+        buffer = bufferPool->getBuffer(capacity);
+        if (!buffer)
+        {
+            buffer = frames;
+            return nullptr;
+        }
+        memcpy(buffer->getPointer(), frames->getPointer() + completeSize, remainingSize);
+    } else
+    {
+        buffer = nullptr;
+    }
+    frames->setUsedSize(completeSize);
+    usedSize = remainingSize;
+    completeSize = 0;
+    return frames;
+}
+
+void spacemma::StreamReassembler::reset()
+{
+    if (buffer)
+    {
+        bufferPool->freeBuffer(buffer);
+        buffer = nullptr;
+    }
+    usedSize = 0;
+    completeSize = 0;
+}
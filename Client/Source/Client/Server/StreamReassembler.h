@@ -0,0 +1,97 @@
+#pragma once
+
+#include "TCPSocket.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define TCP_FRAME_HEADER_SIZE sizeof(spacemma::FrameLength)
+#define TCP_MAX_FRAME_SIZE (TCP_SOCKET_BUFFER_SIZE - TCP_FRAME_HEADER_SIZE)
+
+namespace spacemma
+{
+    /**
+     * Type of the length prefix preceding every frame sent through a TCP stream.
+     * A frame contains exactly the data of a single buffer passed to send/sendTo and cannot exceed TCP_MAX_FRAME_SIZE.
+     */
+    using FrameLength = uint16_t;
+
+    /**
+     * Reassembles length-prefixed frames from a TCP stream.
+     * Received data is written directly into a staging buffer acquired from the pool, so that frames split across
+     * several recv calls are joined. Once complete frames fill at least half of the staging buffer, the staging buffer
+     * itself is handed out and only the beginning of a partially received frame is copied to the next one.
+     * Fewer complete frames are copied into a buffer of their own size and the staging buffer is kept.
+     */
+    class StreamReassembler final
+    {
+    public:
+        StreamReassembler(size_t capacity = TCP_SOCKET_BUFFER_SIZE);
+        ~StreamReassembler();
+        StreamReassembler(StreamReassembler&) = delete;
+        StreamReassembler(StreamReassembler&&) = delete;
+        StreamReassembler& operator=(StreamReassembler&) = delete;
+        StreamReassembler& operator=(StreamReassembler&&) = delete;
+        /**
+         * Returns the region the next received data should be written to or an empty span if
+         * no staging buffer could be acquired from the pool.
+         */
+        gsl::span<uint8_t> getFreeSpace(BufferPool& bufferPool);
+        /**
+         * Marks the given amount of bytes written to the free space as received.
+         * Returns false if the stream contains a frame which can never be reassembled, true otherwise.
+         */
+        bool commit(size_t received);
+        /**
+         * Returns a pool buffer containing all complete frames (including their length prefixes) received so far
+         * or null pointer if there is no complete frame. The frames can be walked in place with readFrame.
+         */
+        ByteBuffer* takeFrames();
+        /**
+         * Discards all received data and returns the staging buffer to the pool.
+         */
+        void reset();
+    private:
+        BufferPool* bufferPool{ nullptr };
+        ByteBuffer* buffer{ nullptr };
+        size_t capacity, usedSize{ 0ULL }, completeSize{ 0ULL };
+    };
+
+    /**
+     * Reads the frame starting at framePos of the given frames and advances framePos to the next frame.
+     * Returns false if there are no more complete frames.
+     */
+    inline bool readFrame(gsl::span<uint8_t> frames, size_t& framePos, gsl::span<uint8_t>& frame)
+    {
+        if (frames.size() - framePos < TCP_FRAME_HEADER_SIZE)
+        {
+            return false;
+        }
+        FrameLength frameLength;
+        memcpy(&frameLength, frames.data() + framePos, TCP_FRAME_HEADER_SIZE);
+        if (frames.size() - framePos - TCP_FRAME_HEADER_SIZE < frameLength)
+        {
+            return false;
+        }
+        frame = frames.subspan(framePos + TCP_FRAME_HEADER_SIZE, frameLength);
+        framePos += TCP_FRAME_HEADER_SIZE + frameLength;
+        return true;
+    }
+
+    /**
+     * Appends the frame of the given buffer, including its length prefix, to output, starting at the given offset into the frame.
+     */
+    inline void appendFrame(std::vector<uint8_t>& output, const ByteBuffer& buffer, size_t offset)
+    {
+        if (offset < TCP_FRAME_HEADER_SIZE)
+        {
+            const FrameLength frameLength = static_cast<FrameLength>(buffer.getUsedSize());
+            const uint8_t* header = reinterpret_cast<const uint8_t*>(&frameLength);
+            output.insert(output.end(), header + offset, header + TCP_FRAME_HEADER_SIZE);
+            offset = TCP_FRAME_HEADER_SIZE;
+        }
+        const uint8_t* payload = buffer.getPointer();
+        output.insert(output.end(), payload + offset - TCP_FRAME_HEADER_SIZE, payload + buffer.getUsedSize());
+    }
+}
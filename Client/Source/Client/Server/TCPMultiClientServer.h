@@ -1,26 +1,90 @@
 #pragma once
 
+#include "ClientSendQueue.h"
 #include "TCPServer.h"
+#include "Thread.h"
+
+#define CLIENT_SEND_QUEUE_CAPACITY 4096
+/** Clients leaving more than this amount of unsent data on the server are disconnected. */
+#define TCP_MAX_OUTBOUND_SIZE (64 * TCP_SOCKET_BUFFER_SIZE)
 
 namespace spacemma
 {
+    /**
+     * Buffers waiting to be sent to a single client.
+     */
     struct ClientBuffers
     {
-        std::recursive_mutex bufferMutex{};
-        std::vector<ByteBuffer*> buffers{}; // todo: change it to queue
+        ClientBuffers(size_t subjectCount, size_t kindCount) : buffers(CLIENT_SEND_QUEUE_CAPACITY, subjectCount, kindCount) {}
+        ClientSendQueue buffers;
+    };
+
+    /**
+     * Client connection events reported by multi-client servers.
+     */
+    enum class ClientEvent : uint8_t
+    {
+        /**
+         * The client socket has pending data. The handler should call receiveFrom until it returns a null pointer.
+         */
+        Received,
+        /**
+         * A send was scheduled for the client with scheduleSend. The handler should send all queued data.
+         */
+        SendReady,
+        /**
+         * The connection was closed by the peer or has failed.
+         */
+        Disconnected
     };
+    typedef void (*ClientEventHandler)(ClientEvent event, unsigned short client, void* ptr);
 
+    /**
+     * Base for servers handling many clients at once. Servers report client readiness through the event handler
+     * from their own threads, so that no thread has to block in receiveFrom or sendTo.
+     * Clients are identified by the IDs returned from acceptClient, which are handed out by a ClientSlotAllocator,
+     * so getClientSlot of an ID is a dense index smaller than the maximum client amount.
+     */
     class TCPMultiClientServer : public TCPServer
     {
     public:
         TCPMultiClientServer(BufferPool& bufferPool) : TCPServer(bufferPool) {}
         virtual unsigned char getClientCount() const = 0;
-        virtual std::vector<unsigned short> getClientPorts() const = 0;
-        virtual bool isClientAlive(unsigned short clientPort) const = 0;
-        virtual bool sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short clientPort) = 0;
-        virtual ByteBuffer* receiveFrom(unsigned short clientPort) = 0;
-        virtual bool shutdownClient(unsigned short port) const = 0;
-        virtual bool closeClient(unsigned short port) const = 0;
-        virtual bool isConnected(unsigned short port) const = 0;
+        virtual std::vector<unsigned short> getClientIds() const = 0;
+        virtual bool isClientAlive(unsigned short client) const = 0;
+        /**
+         * Starts reporting the events of a client returned from acceptClient, which are not reported before,
+         * so that the caller can set the client up first.
+         * Returns true if the client was started, false otherwise. The caller has to close a client which failed to start.
+         */
+        virtual bool startClient(unsigned short client) = 0;
+        virtual bool sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short client) = 0;
+        virtual ByteBuffer* receiveFrom(unsigned short client) = 0;
+        virtual bool shutdownClient(unsigned short client) const = 0;
+        /**
+         * Closes the client socket and frees the client ID. Servers handling the client on one of their threads at the
+         * time of the call may close the socket once that thread is done with it, the client ID is not reused before.
+         */
+        virtual bool closeClient(unsigned short client) const = 0;
+        virtual bool isConnected(unsigned short client) const = 0;
+        /**
+         * Returns true if data accepted by sendTo still waits for the client socket to become writable, false otherwise.
+         * The server reports ClientEvent::SendReady once the waiting data was sent.
+         */
+        virtual bool hasPendingOutput(unsigned short client) const = 0;
+        /**
+         * Sets the handler invoked from the server's own threads for every client event.
+         */
+        virtual void setEventHandler(ClientEventHandler handler, void* ptr) = 0;
+        /**
+         * Requests a ClientEvent::SendReady event for the given client.
+         * Returns true if the event was scheduled, false otherwise.
+         */
+        virtual bool scheduleSend(unsigned short client) = 0;
+        /**
+         * Sets the CPU affinity mask and the priority of the threads the server creates itself.
+         * Has to be called before bindAndListen.
+         */
+        virtual void setThreadSettings(uint64_t cpuMask, ThreadPriority priority) = 0;
     };
 }
@@ -20,7 +20,7 @@ namespace spacemma
         virtual bool isListening() = 0;
         /**
          * Attempts to accept a pending client connection. This is a blocking call.
-         * Returns client port if a client connection was established, 0 otherwise.
+         * Returns a nonzero client ID if a client connection was established, 0 otherwise.
          */
         virtual unsigned short acceptClient() = 0;
     };
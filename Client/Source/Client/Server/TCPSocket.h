@@ -16,13 +16,13 @@ namespace spacemma
         TCPSocket(BufferPool& bufferPool);
         virtual ~TCPSocket() = default;
         /**
-         * Sends data through this socket. This is a blocking call.
+         * Sends data through this socket as a single length-prefixed frame. This is a blocking call.
          * Returns true if data was successfully sent, false otherwise.
          */
         virtual bool send(gsl::not_null<ByteBuffer*> buff) = 0;
         /**
          * Attempts to receive data acquired by this socket. This is a blocking call.
-         * Returns a valid ByteBuffer pointer containing received data or null pointer if
+         * Returns a valid ByteBuffer pointer containing complete received frames (see readFrame) or null pointer if
          * failed or there is no data to be received.
          */
         virtual ByteBuffer* receive() = 0;
@@ -3,6 +3,10 @@
 
 #include <gsl/gsl-lite.hpp>
 
+#include <cstdint>
+#include <mutex>
+#include <string>
+
 #define THREAD_JOIN_TIMEOUT 10000
 
 namespace spacemma
@@ -10,6 +14,18 @@ namespace spacemma
     class Thread;
     typedef void (*ThreadFunc)(gsl::not_null<Thread*>, void* ptr);
 
+    /**
+     * Scheduling priorities of threads. Raising the priority above Normal may require privileges
+     * (CAP_SYS_NICE on Linux), Realtime uses a fixed-priority scheduling policy where available.
+     */
+    enum class ThreadPriority : uint8_t
+    {
+        Low,
+        Normal,
+        High,
+        Realtime
+    };
+
     /**
      * Base for thread implementations.
      */
@@ -28,7 +44,7 @@ namespace spacemma
          */
         virtual bool isRunning() = 0;
         /**
-         * Sets the interrupt flag of the thread.
+         * Sets the interrupt flag of the thread and wakes it up if it is sleeping.
          */
         virtual void interrupt() = 0;
         /**
@@ -43,6 +59,27 @@ namespace spacemma
          * Terminates the thread.
          */
         virtual bool terminate() = 0;
+        /**
+         * Blocks the calling thread until the timeout in milliseconds passes or this thread is interrupted.
+         * Returns true if the whole timeout passed, false if the thread was interrupted.
+         */
+        virtual bool sleep(uint32_t milliseconds) = 0;
+        /**
+         * Sets the name shown by debuggers and system tools (truncated to 15 characters on Linux).
+         * Settings are applied when the thread starts, or at once if it is already running.
+         * Returns false if the running thread could not be changed, true otherwise.
+         */
+        virtual bool setName(const std::string& name) = 0;
+        /**
+         * Restricts the thread to the CPUs set in the mask, zero allows all of them.
+         * Returns false if the running thread could not be changed, true otherwise.
+         */
+        virtual bool setAffinity(uint64_t cpuMask) = 0;
+        /**
+         * Sets the scheduling priority of the thread.
+         * Returns false if the running thread could not be changed, true otherwise.
+         */
+        virtual bool setPriority(ThreadPriority priority) = 0;
         /**
          * Returns the ThreadFunc used by this thread.
          */
@@ -54,5 +91,10 @@ namespace spacemma
     protected:
         ThreadFunc threadFunc{ nullptr };
         void* ptr{ nullptr };
+        // guards the settings, which are applied by both the starting thread and the setters
+        std::mutex settingsMutex{};
+        std::string name{};
+        uint64_t cpuMask{ 0 };
+        ThreadPriority priority{ ThreadPriority::Normal };
     };
 }
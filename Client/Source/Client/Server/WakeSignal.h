@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace spacemma
+{
+    /**
+     * Lets a consumer thread sleep until a lock-free queue it drains has work for it.
+     * Producers call notify after pushing, which only touches the mutex when the consumer is actually sleeping.
+     */
+    class WakeSignal final
+    {
+    public:
+        WakeSignal() = default;
+        ~WakeSignal() = default;
+        WakeSignal(WakeSignal&) = delete;
+        WakeSignal(WakeSignal&&) = delete;
+        WakeSignal& operator=(WakeSignal&) = delete;
+        WakeSignal& operator=(WakeSignal&&) = delete;
+        /**
+         * Blocks the calling thread until the given predicate returns true.
+         * The predicate is reevaluated every time notify is called.
+         */
+        template <typename Predicate>
+        void wait(Predicate predicate);
+        /**
+         * Wakes up the waiting thread, if there is one.
+         */
+        void notify();
+    private:
+        std::mutex mutex{};
+        std::condition_variable condition{};
+        std::atomic_bool waiting{ false };
+    };
+
+    template <typename Predicate>
+    void WakeSignal::wait(Predicate predicate)
+    {
+        if (predicate())
+        {
+            return;
+        }
+        std::unique_lock lock(mutex);
+        waiting.store(true);
+        // pairs with the fence in notify, either the predicate sees the pushed data or notify sees the waiting flag
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        condition.wait(lock, predicate);
+        waiting.store(false);
+    }
+
+    inline void WakeSignal::notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load())
+        {
+            {
+                std::lock_guard lock(mutex);
+            }
+            condition.notify_all();
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#if PLATFORM_WINDOWS
 #include "WinTCPClient.h"
 #include "SpaceLog.h"
 
@@ -17,10 +18,10 @@ bool spacemma::WinTCPClient::connect(gsl::cstring_span ipAddress, unsigned short
 {
     if (ipAddress.empty())
     {
-        SPACEMMA_ERROR("Provided IP address is empty!");
+        SPACEMMA_CATEGORY_ERROR(Net, "Provided IP address is empty!");
         return false;
     }
-    SPACEMMA_DEBUG("Attempting to connect to {}:{}...", ipAddress.cbegin(), port);
+    SPACEMMA_CATEGORY_DEBUG(Net, "Attempting to connect to {}:{}...", ipAddress.cbegin(), port);
     if (!WinsockUtil::wsaStartup(this))
     {
         return false;
@@ -30,7 +31,7 @@ bool spacemma::WinTCPClient::connect(gsl::cstring_span ipAddress, unsigned short
     socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (socket == INVALID_SOCKET)
     {
-        SPACEMMA_ERROR("Failed to create socket ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create socket ({})!", WSAGetLastError());
         WinsockUtil::wsaCleanup(this);
         return false;
     }
@@ -38,7 +39,7 @@ bool spacemma::WinTCPClient::connect(gsl::cstring_span ipAddress, unsigned short
     //if (int ret = setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO,
     //                         reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
     //{
-    //    SPACEMMA_ERROR("Failed to set receive timeout ({})!", WSAGetLastError());
+    //    SPACEMMA_CATEGORY_ERROR(Net, "Failed to set receive timeout ({})!", WSAGetLastError());
     //    shutdown();
     //    close();
     //    WinsockUtil::wsaCleanup(this);
@@ -47,7 +48,7 @@ bool spacemma::WinTCPClient::connect(gsl::cstring_span ipAddress, unsigned short
     if (int ret = setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO,
                              reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
     {
-        SPACEMMA_ERROR("Failed to set send timeout ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to set send timeout ({})!", WSAGetLastError());
         shutdown();
         close();
         WinsockUtil::wsaCleanup(this);
@@ -58,41 +59,41 @@ bool spacemma::WinTCPClient::connect(gsl::cstring_span ipAddress, unsigned short
     {
         if (ret == 0)
         {
-            SPACEMMA_ERROR("An invalid IP address was provided!");
+            SPACEMMA_CATEGORY_ERROR(Net, "An invalid IP address was provided!");
         } else
         {
-            SPACEMMA_ERROR("Failed to convert the IP address ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to convert the IP address ({})!", WSAGetLastError());
         }
         shutdown();
         close();
         WinsockUtil::wsaCleanup(this);
         return false;
     }
+    reassembler.reset();
     if (::connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR)
     {
-        SPACEMMA_ERROR("Connection failed ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Connection failed ({})!", WSAGetLastError());
         shutdown();
         close();
         WinsockUtil::wsaCleanup(this);
         return false;
     }
     connected = true;
-    SPACEMMA_DEBUG("Connection established!");
+    SPACEMMA_CATEGORY_DEBUG(Net, "Connection established!");
     return true;
 }
 
 bool spacemma::WinTCPClient::send(gsl::not_null<ByteBuffer*> buff)
 {
-    if (::send(socket, reinterpret_cast<char*>(buff->getPointer()), static_cast<int>(buff->getUsedSize()), 0) ==
-        SOCKET_ERROR)
+    if (WinsockUtil::sendFrame(socket, buff) == SOCKET_ERROR)
     {
         if (int error = WSAGetLastError(); error == WSAECONNRESET)
         {
-            SPACEMMA_ERROR("Failed to send {} data! Connection reset by peer.", buff->getUsedSize());
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data! Connection reset by peer.", buff->getUsedSize());
             connected = false;
         } else
         {
-            SPACEMMA_ERROR("Failed to send {} data ({})!", buff->getUsedSize(), error);
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data ({})!", buff->getUsedSize(), error);
         }
         return false;
     }
@@ -101,26 +102,42 @@ bool spacemma::WinTCPClient::send(gsl::not_null<ByteBuffer*> buff)
 
 spacemma::ByteBuffer* spacemma::WinTCPClient::receive()
 {
-    int received = recv(socket, recvBuffer, TCP_SOCKET_BUFFER_SIZE, 0);
-    if (received == 0)
+    while (true)
     {
-        return nullptr;
-    }
-    if (received == SOCKET_ERROR)
-    {
-        if (int error = WSAGetLastError(); error == WSAECONNRESET)
+        gsl::span<uint8_t> freeSpace = reassembler.getFreeSpace(*bufferPool);
+        if (freeSpace.empty())
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to acquire a receive buffer!");
+            return nullptr;
+        }
+        int received = recv(socket, reinterpret_cast<char*>(freeSpace.data()), static_cast<int>(freeSpace.size()), 0);
+        if (received == 0)
+        {
+            return nullptr;
+        }
+        if (received == SOCKET_ERROR)
+        {
+            if (int error = WSAGetLastError(); error == WSAECONNRESET)
+            {
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data! Connection reset by peer.");
+                connected = false;
+            } else
+            {
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data ({})!", error);
+            }
+            return nullptr;
+        }
+        if (!reassembler.commit(received))
         {
-            SPACEMMA_ERROR("Failed to receive data! Connection reset by peer.");
+            SPACEMMA_CATEGORY_ERROR(Net, "Received malformed data stream!");
             connected = false;
-        } else
+            return nullptr;
+        }
+        if (ByteBuffer* buff = reassembler.takeFrames())
         {
-            SPACEMMA_ERROR("Failed to receive data ({})!", error);
+            return buff;
         }
-        return nullptr;
     }
-    ByteBuffer* buff = bufferPool->getBuffer(received);
-    memcpy(buff->getPointer(), recvBuffer, received);
-    return buff;
 }
 
 bool spacemma::WinTCPClient::shutdown()
@@ -129,7 +146,7 @@ bool spacemma::WinTCPClient::shutdown()
     {
         if (::shutdown(socket, SD_BOTH) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to shut down socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down socket ({})!", WSAGetLastError());
             return false;
         }
     }
@@ -142,7 +159,7 @@ bool spacemma::WinTCPClient::close()
     {
         if (closesocket(socket) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to close socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to close socket ({})!", WSAGetLastError());
             return false;
         }
         socket = INVALID_SOCKET;
@@ -154,3 +171,5 @@ bool spacemma::WinTCPClient::isConnected()
 {
     return socket != INVALID_SOCKET && connected;
 }
+
+#endif
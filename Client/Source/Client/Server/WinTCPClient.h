@@ -1,5 +1,6 @@
 #pragma once
 
+#if PLATFORM_WINDOWS
 #include "TCPClient.h"
 #include "WinsockUtil.h"
 
@@ -23,7 +24,9 @@ namespace spacemma
     private:
         SOCKET socket{ INVALID_SOCKET };
         sockaddr_in address{};
-        char recvBuffer[TCP_SOCKET_BUFFER_SIZE]{ 0 };
+        StreamReassembler reassembler{};
         bool connected{ false };
     };
 }
+
+#endif
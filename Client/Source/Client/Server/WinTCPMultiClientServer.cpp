@@ -1,14 +1,24 @@
+#if PLATFORM_WINDOWS
 #include "WinTCPMultiClientServer.h"
+#include "PlatformThread.h"
 #include "SpaceLog.h"
 
-spacemma::WinTCPMultiClientServer::WinTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients)
-    : TCPMultiClientServer(bufferPool), maxClients(maxClients)
+spacemma::WinTCPMultiClientServer::WinTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients,
+                                                           unsigned char workerThreadCount)
+    : TCPMultiClientServer(bufferPool), maxClients(maxClients), workerThreadCount(workerThreadCount),
+      clientSlots(maxClients),
+      // every client has at most one queued receive task and one queued send task
+      workerPool(static_cast<size_t>(maxClients) * 2)
 {
     if (!maxClients)
     {
-        SPACEMMA_ERROR("Max client amount must be greater than zero!");
+        SPACEMMA_CATEGORY_ERROR(Net, "Max client amount must be greater than zero!");
         //throw std::exception("Max client amount must be greater than zero!");
     }
+    if (!workerThreadCount)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Worker thread amount must be greater than zero!");
+    }
     clientData = gsl::make_span<ClientData>(new ClientData[maxClients]{}, maxClients);
 }
 
@@ -19,6 +29,7 @@ spacemma::WinTCPMultiClientServer::~WinTCPMultiClientServer()
         shutdown();
         close();
     }
+    stopThreads();
     WinsockUtil::wsaCleanup(this);
     delete[] clientData.begin();
 }
@@ -27,10 +38,10 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
 {
     if (ipAddress.empty())
     {
-        SPACEMMA_ERROR("Provided IP address is empty!");
+        SPACEMMA_CATEGORY_ERROR(Net, "Provided IP address is empty!");
         return false;
     }
-    SPACEMMA_DEBUG("Attempting to bind a socket to {}:{}...", ipAddress.cbegin(), port);
+    SPACEMMA_CATEGORY_DEBUG(Net, "Attempting to bind a socket to {}:{}...", ipAddress.cbegin(), port);
     if (!WinsockUtil::wsaStartup(this))
     {
         return false;
@@ -40,7 +51,7 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
     serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (serverSocket == INVALID_SOCKET)
     {
-        SPACEMMA_ERROR("Failed to create socket ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create socket ({})!", WSAGetLastError());
         WinsockUtil::wsaCleanup(this);
         return false;
     }
@@ -49,10 +60,10 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
     {
         if (ret == 0)
         {
-            SPACEMMA_ERROR("An invalid IP address was provided!");
+            SPACEMMA_CATEGORY_ERROR(Net, "An invalid IP address was provided!");
         } else
         {
-            SPACEMMA_ERROR("Failed to convert the IP address ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to convert the IP address ({})!", WSAGetLastError());
         }
         shutdownServer();
         closeServer();
@@ -61,7 +72,7 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
     }
     if (bind(serverSocket, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0)
     {
-        SPACEMMA_ERROR("Failed to bind socket ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to bind socket ({})!", WSAGetLastError());
         shutdownServer();
         closeServer();
         WinsockUtil::wsaCleanup(this);
@@ -69,7 +80,15 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
     }
     if (listen(serverSocket, SOMAXCONN) == SOCKET_ERROR)
     {
-        SPACEMMA_ERROR("Failed to start listening ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to start listening ({})!", WSAGetLastError());
+        shutdownServer();
+        closeServer();
+        WinsockUtil::wsaCleanup(this);
+        return false;
+    }
+    if (!createWakeSocket() || !startThreads())
+    {
+        stopThreads();
         shutdownServer();
         closeServer();
         WinsockUtil::wsaCleanup(this);
@@ -79,11 +98,13 @@ bool spacemma::WinTCPMultiClientServer::bindAndListen(gsl::cstring_span ipAddres
     PCSTR str = InetNtopA(AF_INET, &address.sin_addr, buff, 64);
     if (str == nullptr)
     {
-        SPACEMMA_WARN("Unable to convert the address to string ({})!", WSAGetLastError());
-        SPACEMMA_DEBUG("Socket bound and listening for {} clients!", maxClients);
+        SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound and listening for {} clients with {} worker threads!", maxClients,
+                       workerThreadCount);
     } else
     {
-        SPACEMMA_DEBUG("Socket bound to {}:{} and listening for {} clients!", str, address.sin_port, maxClients);
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound to {}:{} and listening for {} clients with {} worker threads!", str,
+                       address.sin_port, maxClients, workerThreadCount);
     }
     return true;
 }
@@ -95,27 +116,19 @@ bool spacemma::WinTCPMultiClientServer::isListening()
 
 unsigned short spacemma::WinTCPMultiClientServer::acceptClient()
 {
-    ClientData* data = getClientData(0U);
-    if (data)
+    if (clientSlots.hasFreeSlot())
     {
         SOCKET clientSocket = accept(serverSocket, static_cast<sockaddr*>(nullptr), nullptr);
         if (clientSocket == INVALID_SOCKET)
         {
-            SPACEMMA_ERROR("Failed to accept a client connection ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to accept a client connection ({})!", WSAGetLastError());
             return 0;
         }
-        const int TIMEOUT = TCP_SOCKET_TIMEOUT;
-        //if (int ret = setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO,
-        //                         reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
-        //{
-        //    SPACEMMA_ERROR("Failed to set client receive timeout ({})!", WSAGetLastError());
-        //    closesocket(clientSocket);
-        //    return 0;
-        //}
-        if (int ret = setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
-        {
-            SPACEMMA_ERROR("Failed to set client send timeout ({})!", WSAGetLastError());
+        // the data a full socket does not take is kept by sendTo until the socket becomes writable
+        u_long nonBlocking = 1;
+        if (ioctlsocket(clientSocket, FIONBIO, &nonBlocking) == SOCKET_ERROR)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to make the client socket non-blocking ({})!", WSAGetLastError());
             closesocket(clientSocket);
             return 0;
         }
@@ -123,8 +136,8 @@ unsigned short spacemma::WinTCPMultiClientServer::acceptClient()
         int addrSize{ sizeof(addr) };
         if (getpeername(clientSocket, reinterpret_cast<sockaddr*>(&addr), &addrSize) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Accepted connection, but getpeername failed ({})!", WSAGetLastError());
-            SPACEMMA_ERROR("Unable to acquire the client port. Closing connection!");
+            SPACEMMA_CATEGORY_WARN(Net, "Accepted connection, but getpeername failed ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "Unable to acquire the client address. Closing connection!");
             closesocket(clientSocket);
             return 0;
         }
@@ -132,49 +145,71 @@ unsigned short spacemma::WinTCPMultiClientServer::acceptClient()
         PCSTR str = InetNtopA(AF_INET, &address.sin_addr, buff, 64);
         if (str == nullptr)
         {
-            SPACEMMA_WARN("Unable to convert the address to string ({})!", WSAGetLastError());
-            SPACEMMA_DEBUG("Accepted connection!");
+            SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection!");
         } else
         {
-            SPACEMMA_DEBUG("Accepted connection from {}:{}!", str, addr.sin_port);
+            SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection from {}:{}!", str, addr.sin_port);
+        }
+        const unsigned short client = clientSlots.acquire();
+        if (!client)
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Unable to acquire a client slot. Closing connection!");
+            closesocket(clientSocket);
+            return 0;
+        }
+        ClientData* data = &clientData[getClientSlot(client)];
+        {
+            std::lock_guard lock(data->socketMutex);
+            data->reassembler.reset();
+            data->outbound.clear();
+            data->socket = clientSocket;
+            data->receiveScheduled = false;
+            data->sendScheduled = false;
+            data->outputPending = false;
+            data->started = false;
+            data->isConnected = true;
         }
-        data->port = addr.sin_port;
-        data->socket = clientSocket;
-        data->isConnected = true;
-        return addr.sin_port;
+        // published last, so that the polling thread and the workers see the socket of the client along with its ID
+        data->id.store(client, std::memory_order_release);
+        return client;
     }
     return 0;
 }
 
 unsigned char spacemma::WinTCPMultiClientServer::getClientCount() const
 {
-    unsigned char result{ 0U };
-    for (unsigned char i = 0; i < maxClients; ++i)
-    {
-        if (clientData[i].port)
-        {
-            ++result;
-        }
-    }
-    return result;
+    return clientSlots.getUsedCount();
 }
 
-std::vector<unsigned short> spacemma::WinTCPMultiClientServer::getClientPorts() const
+std::vector<unsigned short> spacemma::WinTCPMultiClientServer::getClientIds() const
 {
     std::vector<unsigned short> result{};
     for (unsigned char i = 0; i < maxClients; ++i)
     {
-        if (clientData[i].port)
+        if (const unsigned short client = clientData[i].id)
         {
-            result.push_back(clientData[i].port);
+            result.push_back(client);
         }
     }
     return result;
 }
 
-bool spacemma::WinTCPMultiClientServer::isClientAlive(unsigned short clientPort) const
+bool spacemma::WinTCPMultiClientServer::isClientAlive(unsigned short client) const
 {
-    return getClientData(clientPort) != nullptr;
+    return getClientData(client) != nullptr;
+}
+
+bool spacemma::WinTCPMultiClientServer::startClient(unsigned short client)
+{
+    ClientData* data = getClientData(client);
+    if (!data || data->started.exchange(true))
+    {
+        return false;
+    }
+    // lets the polling thread pick up the new socket at once
+    wakePoller();
+    return true;
 }
 
 bool spacemma::WinTCPMultiClientServer::send(gsl::not_null<ByteBuffer*> buff)
@@ -182,64 +217,75 @@ bool spacemma::WinTCPMultiClientServer::send(gsl::not_null<ByteBuffer*> buff)
     bool sent = false;
     for (unsigned char i = 0; i < maxClients; ++i)
     {
-        if (clientData[i].port)
+        const unsigned short client = clientData[i].id;
+        if (client && sendTo(buff, client))
         {
-            if (::send(clientData[i].socket, reinterpret_cast<char*>(buff->getPointer()), static_cast<int>(buff->getUsedSize()),
-                       0) == SOCKET_ERROR)
-            {
-                const int error = WSAGetLastError();
-                switch (error)
-                {
-                    case WSAECONNRESET:
-                        SPACEMMA_ERROR("Failed to send {} data to client at port {}! Connection reset by peer.", buff->getUsedSize(), clientData[i].port);
-                        clientData[i].isConnected = false;
-                        break;
-                    case WSAETIMEDOUT:
-                        SPACEMMA_ERROR("Failed to send {} data to client at port {}! Connection timed out.", buff->getUsedSize(), clientData[i].port);
-                        clientData[i].isConnected = false;
-                        break;
-                    default:
-                        SPACEMMA_ERROR("Failed to send {} data ({}) to client at port {}!", buff->getUsedSize(), error, clientData[i].port);
-                        break;
-                }
-            } else
-            {
-                sent = true;
-            }
+            sent = true;
         }
     }
     return sent;
 }
 
-bool spacemma::WinTCPMultiClientServer::sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short port)
+bool spacemma::WinTCPMultiClientServer::sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short client)
 {
-    ClientData* data = getClientData(port);
-    if (data)
+    ClientData* data = getClientData(client);
+    if (!data)
+    {
+        return false;
+    }
+    std::lock_guard lock(data->socketMutex);
+    if (data->id != client || !data->isConnected)
+    {
+        return false;
+    }
+    const size_t frameSize = TCP_FRAME_HEADER_SIZE + buff->getUsedSize();
+    size_t sent = 0;
+    // the frame may only go straight to the socket once the data of the previous ones is gone
+    if (data->outbound.empty())
     {
-        if (::send(data->socket, reinterpret_cast<char*>(buff->getPointer()), static_cast<int>(buff->getUsedSize()),
-                   0) == SOCKET_ERROR)
+        if (WinsockUtil::sendFrame(data->socket, buff, sent) == SOCKET_ERROR)
         {
-
             const int error = WSAGetLastError();
             switch (error)
             {
                 case WSAECONNRESET:
-                    SPACEMMA_ERROR("Failed to send {} data to client at port {}! Connection reset by peer.", buff->getUsedSize(), port);
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! Connection reset by peer.", buff->getUsedSize(), client);
                     data->isConnected = false;
                     break;
                 case WSAETIMEDOUT:
-                    SPACEMMA_ERROR("Failed to send {} data to client at port {}! Connection timed out.", buff->getUsedSize(), port);
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! Connection timed out.", buff->getUsedSize(), client);
                     data->isConnected = false;
                     break;
                 default:
-                    SPACEMMA_ERROR("Failed to send {} data ({}) to client at port {}!", buff->getUsedSize(), error, port);
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data ({}) to client {}!", buff->getUsedSize(), error, client);
                     break;
             }
+            if (!data->isConnected)
+            {
+                // the polling thread hands the client over to a receive task, which reports the disconnection
+                wakePoller();
+            }
             return false;
         }
-        return true;
+        if (sent == frameSize)
+        {
+            return true;
+        }
     }
-    return false;
+    if (data->outbound.size() + frameSize - sent > TCP_MAX_OUTBOUND_SIZE)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data to client {}! The client does not take its data.", buff->getUsedSize(), client);
+        data->isConnected = false;
+        wakePoller();
+        return false;
+    }
+    // the socket buffer is full, a send task sends the rest of the frame once the socket becomes writable
+    appendFrame(data->outbound, *buff, sent);
+    if (!data->outputPending.exchange(true))
+    {
+        wakePoller();
+    }
+    return true;
 }
 
 spacemma::ByteBuffer* spacemma::WinTCPMultiClientServer::receive()
@@ -247,38 +293,59 @@ spacemma::ByteBuffer* spacemma::WinTCPMultiClientServer::receive()
     return nullptr; // unspecified client to receive from, just return nullptr
 }
 
-spacemma::ByteBuffer* spacemma::WinTCPMultiClientServer::receiveFrom(unsigned short port)
+spacemma::ByteBuffer* spacemma::WinTCPMultiClientServer::receiveFrom(unsigned short client)
 {
-    ClientData* data = getClientData(port);
+    ClientData* data = getClientData(client);
     if (data)
     {
-        int received = recv(data->socket, data->recvBuffer, TCP_SOCKET_BUFFER_SIZE, 0);
-        if (received == 0)
-        {
-            return nullptr;
-        }
-        if (received == SOCKET_ERROR)
+        while (true)
         {
-            const int error = WSAGetLastError();
-            switch (error)
+            gsl::span<uint8_t> freeSpace = data->reassembler.getFreeSpace(*bufferPool);
+            if (freeSpace.empty())
             {
-                case WSAECONNRESET:
-                    SPACEMMA_ERROR("Failed to receive data from client at port {}! Connection reset by peer.", port);
-                    data->isConnected = false;
-                    break;
-                case WSAETIMEDOUT:
-                    SPACEMMA_ERROR("Failed to receive data from client at port {}! Connection timed out.", port);
-                    data->isConnected = false;
-                    break;
-                default:
-                    SPACEMMA_ERROR("Failed to receive data ({}) from client at port {}!", error, port);
-                    break;
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to acquire a receive buffer for client {}!", client);
+                return nullptr;
+            }
+            int received = recv(data->socket, reinterpret_cast<char*>(freeSpace.data()), static_cast<int>(freeSpace.size()), 0);
+            if (received == 0)
+            {
+                data->isConnected = false;
+                return nullptr;
+            }
+            if (received == SOCKET_ERROR)
+            {
+                const int error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK)
+                {
+                    return nullptr;
+                }
+                switch (error)
+                {
+                    case WSAECONNRESET:
+                        SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data from client {}! Connection reset by peer.", client);
+                        data->isConnected = false;
+                        break;
+                    case WSAETIMEDOUT:
+                        SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data from client {}! Connection timed out.", client);
+                        data->isConnected = false;
+                        break;
+                    default:
+                        SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data ({}) from client {}!", error, client);
+                        break;
+                }
+                return nullptr;
+            }
+            if (!data->reassembler.commit(received))
+            {
+                SPACEMMA_CATEGORY_ERROR(Net, "Received malformed data stream from client {}!", client);
+                data->isConnected = false;
+                return nullptr;
+            }
+            if (ByteBuffer* buff = data->reassembler.takeFrames())
+            {
+                return buff;
             }
-            return nullptr;
         }
-        ByteBuffer* buff = bufferPool->getBuffer(received);
-        memcpy(buff->getPointer(), data->recvBuffer, received);
-        return buff;
     }
     return nullptr;
 }
@@ -287,9 +354,9 @@ bool spacemma::WinTCPMultiClientServer::shutdown()
 {
     for (unsigned char i = 0; i < maxClients; ++i)
     {
-        if (clientData[i].port)
+        if (clientData[i].id)
         {
-            shutdownClient(clientData[i].port);
+            shutdownClient(clientData[i].id);
         }
     }
     return shutdownServer();
@@ -297,11 +364,12 @@ bool spacemma::WinTCPMultiClientServer::shutdown()
 
 bool spacemma::WinTCPMultiClientServer::close()
 {
+    stopThreads();
     for (unsigned char i = 0; i < maxClients; ++i)
     {
-        if (clientData[i].port)
+        if (clientData[i].id)
         {
-            closeClient(clientData[i].port);
+            closeClient(clientData[i].id);
         }
     }
     return closeServer();
@@ -318,25 +386,30 @@ bool spacemma::WinTCPMultiClientServer::shutdownServer() const
     {
         if (::shutdown(serverSocket, SD_BOTH) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to shut down server socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down server socket ({})!", WSAGetLastError());
             return false;
         }
     }
     return true;
 }
 
-bool spacemma::WinTCPMultiClientServer::shutdownClient(unsigned short port) const
+bool spacemma::WinTCPMultiClientServer::shutdownClient(unsigned short client) const
 {
-    if (!port)
+    if (!client)
     {
         return false;
     }
-    ClientData* data = getClientData(port);
+    ClientData* data = getClientData(client);
     if (data)
     {
+        std::lock_guard lock(data->socketMutex);
+        if (data->id != client)
+        {
+            return false;
+        }
         if (::shutdown(data->socket, SD_BOTH) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to shut down client socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down client socket ({})!", WSAGetLastError());
             return false;
         }
         return true;
@@ -346,11 +419,16 @@ bool spacemma::WinTCPMultiClientServer::shutdownClient(unsigned short port) cons
 
 bool spacemma::WinTCPMultiClientServer::closeServer()
 {
+    if (wakeSocket != INVALID_SOCKET)
+    {
+        closesocket(wakeSocket);
+        wakeSocket = INVALID_SOCKET;
+    }
     if (serverSocket != INVALID_SOCKET)
     {
         if (closesocket(serverSocket) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to close server socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to close server socket ({})!", WSAGetLastError());
             return false;
         }
         serverSocket = INVALID_SOCKET;
@@ -358,30 +436,44 @@ bool spacemma::WinTCPMultiClientServer::closeServer()
     return true;
 }
 
-bool spacemma::WinTCPMultiClientServer::closeClient(unsigned short port) const
+bool spacemma::WinTCPMultiClientServer::closeClient(unsigned short client) const
 {
-    if (!port)
+    if (!client)
     {
         return false;
     }
-    ClientData* data = getClientData(port);
-    if (data)
+    ClientData* data = getClientData(client);
+    if (!data)
     {
-        if (closesocket(data->socket) == SOCKET_ERROR)
-        {
-            SPACEMMA_WARN("Failed to close client socket ({})!", WSAGetLastError());
-            return false;
-        }
-        data->port = 0;
-        data->socket = INVALID_SOCKET;
-        return true;
+        return false;
     }
-    return false;
+    // waits for the receive and send tasks running for the client, so that the socket is never closed under them
+    std::scoped_lock lock(data->receiveMutex, data->sendMutex, data->socketMutex);
+    if (data->id != client)
+    {
+        return false;
+    }
+    // the tasks still queued for the slot find no client
+    data->id = 0;
+    data->isConnected = false;
+    data->sendScheduled = false;
+    data->outputPending = false;
+    data->started = false;
+    data->outbound.clear();
+    bool closed = true;
+    if (closesocket(data->socket) == SOCKET_ERROR)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to close client socket ({})!", WSAGetLastError());
+        closed = false;
+    }
+    data->socket = INVALID_SOCKET;
+    clientSlots.release(client);
+    return closed;
 }
 
-bool spacemma::WinTCPMultiClientServer::isConnected(unsigned short port) const
+bool spacemma::WinTCPMultiClientServer::isConnected(unsigned short client) const
 {
-    ClientData* data = getClientData(port);
+    ClientData* data = getClientData(client);
     if (!data)
     {
         return false;
@@ -389,14 +481,294 @@ bool spacemma::WinTCPMultiClientServer::isConnected(unsigned short port) const
     return data->isConnected;
 }
 
-spacemma::ClientData* spacemma::WinTCPMultiClientServer::getClientData(unsigned short port) const
+bool spacemma::WinTCPMultiClientServer::hasPendingOutput(unsigned short client) const
+{
+    ClientData* data = getClientData(client);
+    return data && data->outputPending;
+}
+
+void spacemma::WinTCPMultiClientServer::setEventHandler(ClientEventHandler handler, void* ptr)
 {
+    if (pollThread)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Changing the event handler while the polling thread is running!");
+    }
+    eventHandler = handler;
+    eventHandlerPtr = ptr;
+}
+
+bool spacemma::WinTCPMultiClientServer::scheduleSend(unsigned short client)
+{
+    ClientData* data = getClientData(client);
+    if (!data || !data->isConnected)
+    {
+        return false;
+    }
+    if (!data->sendScheduled.exchange(true))
+    {
+        if (!workerPool.submit(handleSendTask, this, getClientSlot(client)))
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to schedule a send to client {}!", client);
+            data->sendScheduled = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+void spacemma::WinTCPMultiClientServer::setThreadSettings(uint64_t cpuMask, ThreadPriority priority)
+{
+    threadCpuMask = cpuMask;
+    threadPriority = priority;
+}
+
+void spacemma::WinTCPMultiClientServer::threadPoll(gsl::not_null<Thread*> thread, void* server)
+{
+    WinTCPMultiClientServer* srv = reinterpret_cast<WinTCPMultiClientServer*>(server);
+    std::vector<WSAPOLLFD> fds{};
+    std::vector<unsigned char> slots{};
+    fds.reserve(static_cast<size_t>(srv->maxClients) + 1);
+    slots.reserve(srv->maxClients);
+    SPACEMMA_CATEGORY_DEBUG(Net, "Starting threadPoll...");
+    do
+    {
+        srv->pollClients(fds, slots);
+    } while (!thread->isInterrupted());
+    SPACEMMA_CATEGORY_DEBUG(Net, "Stopping threadPoll...");
+}
+
+void spacemma::WinTCPMultiClientServer::handleReceiveTask(void* server, uintptr_t slot)
+{
+    WinTCPMultiClientServer* srv = reinterpret_cast<WinTCPMultiClientServer*>(server);
+    ClientData& data = srv->clientData[slot];
+    {
+        // a task of a closed client may still be queued when its slot is taken over, so receivers are serialized
+        std::lock_guard lock(data.receiveMutex);
+        const unsigned short client = data.id;
+        // a client of which a send failed is only handed over to report its disconnection
+        if (client && data.isConnected && srv->eventHandler)
+        {
+            srv->eventHandler(ClientEvent::Received, client, srv->eventHandlerPtr);
+        }
+        if (client && !data.isConnected)
+        {
+            // the socket is not polled anymore, so the disconnection is reported exactly once
+            SPACEMMA_CATEGORY_DEBUG(Net, "Client {} disconnected.", client);
+            if (srv->eventHandler)
+            {
+                srv->eventHandler(ClientEvent::Disconnected, client, srv->eventHandlerPtr);
+            }
+            return;
+        }
+    }
+    data.receiveScheduled = false;
+    srv->wakePoller();
+}
+
+void spacemma::WinTCPMultiClientServer::handleSendTask(void* server, uintptr_t slot)
+{
+    WinTCPMultiClientServer* srv = reinterpret_cast<WinTCPMultiClientServer*>(server);
+    ClientData& data = srv->clientData[slot];
+    if (data.sendScheduled.exchange(false))
+    {
+        // serializes senders, so a client's buffers are never sent by two workers at once
+        std::lock_guard lock(data.sendMutex);
+        const unsigned short client = data.id;
+        if (!client || !data.isConnected)
+        {
+            return;
+        }
+        if (!srv->sendOutbound(data))
+        {
+            // the buffers stay queued until the polling thread finds the socket writable again,
+            // if the send failed instead, the polling thread hands the client over to report the disconnection
+            srv->wakePoller();
+            return;
+        }
+        if (srv->eventHandler)
+        {
+            srv->eventHandler(ClientEvent::SendReady, client, srv->eventHandlerPtr);
+        }
+    }
+}
+
+bool spacemma::WinTCPMultiClientServer::sendOutbound(ClientData& data) const
+{
+    std::lock_guard lock(data.socketMutex);
+    size_t sent = 0;
+    while (sent < data.outbound.size())
+    {
+        const int ret = ::send(data.socket, reinterpret_cast<const char*>(data.outbound.data() + sent),
+                               static_cast<int>(data.outbound.size() - sent), 0);
+        if (ret == SOCKET_ERROR)
+        {
+            const int error = WSAGetLastError();
+            if (error != WSAEWOULDBLOCK)
+            {
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} pending data ({}) to client {}!", data.outbound.size() - sent,
+                               error, data.id.load());
+                data.isConnected = false;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(ret);
+    }
+    data.outbound.erase(data.outbound.begin(), data.outbound.begin() + sent);
+    data.outputPending = !data.outbound.empty();
+    return data.outbound.empty();
+}
+
+void spacemma::WinTCPMultiClientServer::pollClients(std::vector<WSAPOLLFD>& fds, std::vector<unsigned char>& slots)
+{
+    fds.clear();
+    slots.clear();
+    fds.push_back({ wakeSocket, POLLRDNORM, 0 });
     for (unsigned char i = 0; i < maxClients; ++i)
     {
-        if (clientData[i].port == port)
+        ClientData& data = clientData[i];
+        if (!data.id || !data.started)
+        {
+            continue;
+        }
+        if (!data.isConnected)
+        {
+            // the sends only mark a failed client, its receive task reports the disconnection exactly once
+            if (!data.receiveScheduled.exchange(true) && !workerPool.submit(handleReceiveTask, this, i))
+            {
+                SPACEMMA_CATEGORY_WARN(Net, "Failed to schedule the disconnection of client {}!", data.id.load());
+                data.receiveScheduled = false;
+            }
+            continue;
+        }
+        short events = data.receiveScheduled ? 0 : POLLRDNORM;
+        // the socket is waited for only while there is outbound data and no send task to take it
+        if (data.outputPending && !data.sendScheduled)
+        {
+            events |= POLLWRNORM;
+        }
+        if (events)
+        {
+            fds.push_back({ data.socket, events, 0 });
+            slots.push_back(i);
+        }
+    }
+    if (WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), WIN_POLL_TIMEOUT) == SOCKET_ERROR)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to poll client sockets ({})!", WSAGetLastError());
+        return;
+    }
+    if (fds[0].revents)
+    {
+        drainWakeSocket();
+    }
+    for (size_t i = 1; i < fds.size(); ++i)
+    {
+        const unsigned char slot = slots[i - 1];
+        ClientData& data = clientData[slot];
+        if ((fds[i].events & POLLWRNORM) && (fds[i].revents & (POLLWRNORM | POLLERR | POLLHUP)))
+        {
+            scheduleSend(data.id);
+        }
+        // errors and hang-ups are reported as well, the receive task finds them out
+        if (!(fds[i].events & POLLRDNORM) || !(fds[i].revents & ~POLLWRNORM))
         {
-            return &clientData[i];
+            continue;
+        }
+        if (!data.receiveScheduled.exchange(true) && !workerPool.submit(handleReceiveTask, this, slot))
+        {
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to schedule a receive from client {}!", data.id.load());
+            data.receiveScheduled = false;
         }
     }
-    return nullptr;
 }
+
+bool spacemma::WinTCPMultiClientServer::createWakeSocket()
+{
+    wakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (wakeSocket == INVALID_SOCKET)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create wake socket ({})!", WSAGetLastError());
+        return false;
+    }
+    // the socket is connected to itself, so that anything sent through it makes it readable
+    sockaddr_in wakeAddress{};
+    wakeAddress.sin_family = AF_INET;
+    wakeAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int wakeAddressSize{ sizeof(wakeAddress) };
+    u_long nonBlocking = 1;
+    if (bind(wakeSocket, reinterpret_cast<SOCKADDR*>(&wakeAddress), sizeof(wakeAddress)) == SOCKET_ERROR
+        || getsockname(wakeSocket, reinterpret_cast<SOCKADDR*>(&wakeAddress), &wakeAddressSize) == SOCKET_ERROR
+        || connect(wakeSocket, reinterpret_cast<SOCKADDR*>(&wakeAddress), wakeAddressSize) == SOCKET_ERROR
+        || ioctlsocket(wakeSocket, FIONBIO, &nonBlocking) == SOCKET_ERROR)
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to set up wake socket ({})!", WSAGetLastError());
+        closesocket(wakeSocket);
+        wakeSocket = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::WinTCPMultiClientServer::wakePoller() const
+{
+    if (wakeSocket == INVALID_SOCKET)
+    {
+        return false;
+    }
+    const char WAKE_DATA = 0;
+    if (::send(wakeSocket, &WAKE_DATA, 1, 0) == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK)
+    {
+        SPACEMMA_CATEGORY_WARN(Net, "Failed to wake the polling thread ({})!", WSAGetLastError());
+        return false;
+    }
+    return true;
+}
+
+void spacemma::WinTCPMultiClientServer::drainWakeSocket() const
+{
+    char wakeData[64];
+    while (recv(wakeSocket, wakeData, sizeof(wakeData), 0) > 0);
+}
+
+bool spacemma::WinTCPMultiClientServer::startThreads()
+{
+    if (!workerPool.start(workerThreadCount, "srv-io-", threadCpuMask, threadPriority))
+    {
+        return false;
+    }
+    pollThread = new PlatformThread();
+    pollThread->setName("srv-poll");
+    pollThread->setAffinity(threadCpuMask);
+    pollThread->setPriority(threadPriority);
+    if (!pollThread->run(threadPoll, this))
+    {
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to start the polling thread!");
+        return false;
+    }
+    return true;
+}
+
+void spacemma::WinTCPMultiClientServer::stopThreads()
+{
+    if (pollThread)
+    {
+        pollThread->interrupt();
+        wakePoller();
+        pollThread->join();
+        delete pollThread;
+        pollThread = nullptr;
+    }
+    workerPool.stop();
+}
+
+spacemma::ClientData* spacemma::WinTCPMultiClientServer::getClientData(unsigned short client) const
+{
+    const unsigned char slot = getClientSlot(client);
+    if (!client || slot >= maxClients || clientData[slot].id != client)
+    {
+        return nullptr;
+    }
+    return &clientData[slot];
+}
+
+#endif
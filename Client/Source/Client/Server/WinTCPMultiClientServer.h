@@ -1,26 +1,55 @@
 #pragma once
 
+#if PLATFORM_WINDOWS
+#include "ClientSlotAllocator.h"
 #include "TCPMultiClientServer.h"
+#include "Thread.h"
 #include "WinsockUtil.h"
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/** Milliseconds the polling thread waits for client sockets before checking whether it was interrupted. */
+#define WIN_POLL_TIMEOUT 500
 
 namespace spacemma
 {
     struct ClientData
     {
         SOCKET socket{ INVALID_SOCKET };
-        unsigned short port{ 0U };
-        char recvBuffer[TCP_SOCKET_BUFFER_SIZE]{};
-        bool isConnected{};
+        // stored last when a client is accepted, so that a client ID is never paired with the previous socket
+        std::atomic<unsigned short> id{ 0U };
+        StreamReassembler reassembler{};
+        std::atomic_bool isConnected{};
+        // set once startClient let the polling thread poll the socket
+        std::atomic_bool started{};
+        // set while a receive task of the client is queued or running, the socket is not polled for reading meanwhile
+        std::atomic_bool receiveScheduled{};
+        std::atomic_bool sendScheduled{};
+        // set while there is outbound data, the socket is polled for writing meanwhile
+        std::atomic_bool outputPending{};
+        std::mutex receiveMutex{};
+        std::mutex sendMutex{};
+        // guards the socket writes and the outbound data
+        std::mutex socketMutex{};
+        // frame data the socket did not take, sent by a send task once the socket becomes writable
+        std::vector<uint8_t> outbound{};
     };
 
     /**
-     * A multi-client TCP server implementation.
-     * TODO: remove race conditions
+     * An event-driven multi-client TCP server implementation based on WSAPoll.
+     * All client sockets are non-blocking and are polled by a single thread, which hands the client events over
+     * to a fixed-size WorkerPool, so that the amount of threads does not depend on the amount of clients.
+     * The events are reported through the handler set with setEventHandler. receiveFrom never blocks and
+     * returns a null pointer once there is no more data to be received. sendTo never blocks either,
+     * the data the socket does not take is kept per client and sent once the socket becomes writable.
      */
     class WinTCPMultiClientServer final : public TCPMultiClientServer
     {
     public:
-        WinTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients);
+        WinTCPMultiClientServer(BufferPool& bufferPool, unsigned char maxClients, unsigned char workerThreadCount = 1);
         ~WinTCPMultiClientServer();
         WinTCPMultiClientServer(WinTCPMultiClientServer&) = delete;
         WinTCPMultiClientServer(WinTCPMultiClientServer&&) = delete;
@@ -30,25 +59,59 @@ namespace spacemma
         bool isListening() override;
         unsigned short acceptClient() override;
         unsigned char getClientCount() const override;
-        std::vector<unsigned short> getClientPorts() const override;
-        bool isClientAlive(unsigned short clientPort) const override;
+        std::vector<unsigned short> getClientIds() const override;
+        bool isClientAlive(unsigned short client) const override;
+        bool startClient(unsigned short client) override;
         bool send(gsl::not_null<ByteBuffer*> buff) override;
-        bool sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short clientPort) override;
+        bool sendTo(gsl::not_null<ByteBuffer*> buff, unsigned short client) override;
         ByteBuffer* receive() override;
-        ByteBuffer* receiveFrom(unsigned short clientPort) override;
+        ByteBuffer* receiveFrom(unsigned short client) override;
         bool shutdown() override;
         bool close() override;
         bool isConnected() override;
-        bool shutdownClient(unsigned short port) const override;
-        bool closeClient(unsigned short port) const override;
-        bool isConnected(unsigned short port) const override;
+        bool shutdownClient(unsigned short client) const override;
+        bool closeClient(unsigned short client) const override;
+        bool isConnected(unsigned short client) const override;
+        bool hasPendingOutput(unsigned short client) const override;
+        void setEventHandler(ClientEventHandler handler, void* ptr) override;
+        bool scheduleSend(unsigned short client) override;
+        void setThreadSettings(uint64_t cpuMask, ThreadPriority priority) override;
     private:
+        static void threadPoll(gsl::not_null<Thread*> thread, void* server);
+        static void handleReceiveTask(void* server, uintptr_t slot);
+        static void handleSendTask(void* server, uintptr_t slot);
+        /**
+         * Sends as much of the outbound data of the client as the socket takes.
+         * Returns true if no outbound data is left, false otherwise.
+         */
+        bool sendOutbound(ClientData& data) const;
+        /**
+         * Hands the clients with pending data over to the workers.
+         */
+        void pollClients(std::vector<WSAPOLLFD>& fds, std::vector<unsigned char>& slots);
+        bool createWakeSocket();
+        bool wakePoller() const;
+        void drainWakeSocket() const;
+        bool startThreads();
+        void stopThreads();
         bool shutdownServer() const;
         bool closeServer();
-        inline ClientData* getClientData(unsigned short port) const;
+        inline ClientData* getClientData(unsigned short client) const;
         SOCKET serverSocket{ INVALID_SOCKET };
+        // a loopback datagram socket polled along with the clients, so that the polling thread can be woken up
+        SOCKET wakeSocket{ INVALID_SOCKET };
         sockaddr_in address{};
         unsigned char maxClients{ 0 };
+        unsigned char workerThreadCount{ 0 };
         gsl::span<ClientData> clientData{};
+        mutable ClientSlotAllocator clientSlots;
+        WorkerPool workerPool;
+        Thread* pollThread{ nullptr };
+        uint64_t threadCpuMask{ 0 };
+        ThreadPriority threadPriority{ ThreadPriority::Normal };
+        ClientEventHandler eventHandler{ nullptr };
+        void* eventHandlerPtr{ nullptr };
     };
 }
+
+#endif
@@ -1,3 +1,4 @@
+#if PLATFORM_WINDOWS
 #include "WinTCPServer.h"
 #include "SpaceLog.h"
 
@@ -17,10 +18,10 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
 {
     if (ipAddress.empty())
     {
-        SPACEMMA_ERROR("Provided IP address is empty!");
+        SPACEMMA_CATEGORY_ERROR(Net, "Provided IP address is empty!");
         return false;
     }
-    SPACEMMA_DEBUG("Attempting to bind a socket to {}:{}...", ipAddress.cbegin(), port);
+    SPACEMMA_CATEGORY_DEBUG(Net, "Attempting to bind a socket to {}:{}...", ipAddress.cbegin(), port);
     if (!WinsockUtil::wsaStartup(this))
     {
         return false;
@@ -30,7 +31,7 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
     serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (serverSocket == INVALID_SOCKET)
     {
-        SPACEMMA_ERROR("Failed to create socket ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to create socket ({})!", WSAGetLastError());
         WinsockUtil::wsaCleanup(this);
         return false;
     }
@@ -39,10 +40,10 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
     {
         if (ret == 0)
         {
-            SPACEMMA_ERROR("An invalid IP address was provided!");
+            SPACEMMA_CATEGORY_ERROR(Net, "An invalid IP address was provided!");
         } else
         {
-            SPACEMMA_ERROR("Failed to convert the IP address ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to convert the IP address ({})!", WSAGetLastError());
         }
         shutdownServer();
         closeServer();
@@ -51,7 +52,7 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
     }
     if (bind(serverSocket, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0)
     {
-        SPACEMMA_ERROR("Failed to bind socket ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to bind socket ({})!", WSAGetLastError());
         shutdownServer();
         closeServer();
         WinsockUtil::wsaCleanup(this);
@@ -59,7 +60,7 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
     }
     if (listen(serverSocket, 1) == SOCKET_ERROR)
     {
-        SPACEMMA_ERROR("Failed to start listening ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to start listening ({})!", WSAGetLastError());
         shutdownServer();
         closeServer();
         WinsockUtil::wsaCleanup(this);
@@ -69,11 +70,11 @@ bool spacemma::WinTCPServer::bindAndListen(gsl::cstring_span ipAddress, unsigned
     PCSTR str = InetNtopA(AF_INET, &address.sin_addr, buff, 64);
     if (str == nullptr)
     {
-        SPACEMMA_WARN("Unable to convert the address to string ({})!", WSAGetLastError());
-        SPACEMMA_DEBUG("Socket bound to and listening!");
+        SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound to and listening!");
     } else
     {
-        SPACEMMA_DEBUG("Socket bound to {}:{} and listening!", str, address.sin_port);
+        SPACEMMA_CATEGORY_DEBUG(Net, "Socket bound to {}:{} and listening!", str, address.sin_port);
     }
     return true;
 }
@@ -85,17 +86,18 @@ bool spacemma::WinTCPServer::isListening()
 
 unsigned short spacemma::WinTCPServer::acceptClient()
 {
+    reassembler.reset();
     clientSocket = accept(serverSocket, static_cast<sockaddr*>(nullptr), nullptr);
     if (clientSocket == INVALID_SOCKET)
     {
-        SPACEMMA_ERROR("Failed to accept a client connection ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to accept a client connection ({})!", WSAGetLastError());
         return 0;
     }
     const int TIMEOUT = TCP_SOCKET_TIMEOUT;
     //if (int ret = setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO,
     //                         reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
     //{
-    //    SPACEMMA_ERROR("Failed to set client receive timeout ({})!", WSAGetLastError());
+    //    SPACEMMA_CATEGORY_ERROR(Net, "Failed to set client receive timeout ({})!", WSAGetLastError());
     //    closesocket(clientSocket);
     //    clientSocket = INVALID_SOCKET;
     //    return 0;
@@ -103,7 +105,7 @@ unsigned short spacemma::WinTCPServer::acceptClient()
     if (int ret = setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO,
                              reinterpret_cast<const char*>(&TIMEOUT), sizeof(TIMEOUT)); ret == SOCKET_ERROR)
     {
-        SPACEMMA_ERROR("Failed to set client send timeout ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_ERROR(Net, "Failed to set client send timeout ({})!", WSAGetLastError());
         closesocket(clientSocket);
         clientSocket = INVALID_SOCKET;
         return 0;
@@ -112,18 +114,18 @@ unsigned short spacemma::WinTCPServer::acceptClient()
     int addrSize{ sizeof(addr) };
     if (getpeername(clientSocket, reinterpret_cast<sockaddr*>(&addr), &addrSize) == SOCKET_ERROR)
     {
-        SPACEMMA_WARN("Accepted connection, but getpeername failed ({})!", WSAGetLastError());
+        SPACEMMA_CATEGORY_WARN(Net, "Accepted connection, but getpeername failed ({})!", WSAGetLastError());
     } else
     {
         char buff[64]{ 0 };
         PCSTR str = InetNtopA(AF_INET, &address.sin_addr, buff, 64);
         if (str == nullptr)
         {
-            SPACEMMA_WARN("Unable to convert the address to string ({})!", WSAGetLastError());
-            SPACEMMA_DEBUG("Accepted connection!");
+            SPACEMMA_CATEGORY_WARN(Net, "Unable to convert the address to string ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection!");
         } else
         {
-            SPACEMMA_DEBUG("Accepted connection from {}:{}!", str, addr.sin_port);
+            SPACEMMA_CATEGORY_DEBUG(Net, "Accepted connection from {}:{}!", str, addr.sin_port);
         }
     }
     closeServer();
@@ -133,22 +135,21 @@ unsigned short spacemma::WinTCPServer::acceptClient()
 
 bool spacemma::WinTCPServer::send(gsl::not_null<ByteBuffer*> buff)
 {
-    if (::send(clientSocket, reinterpret_cast<char*>(buff->getPointer()), static_cast<int>(buff->getUsedSize()),
-               0) == SOCKET_ERROR)
+    if (WinsockUtil::sendFrame(clientSocket, buff) == SOCKET_ERROR)
     {
         const int error = WSAGetLastError();
         switch (error)
         {
             case WSAECONNRESET:
-                SPACEMMA_ERROR("Failed to send {} data! Connection reset by peer.", buff->getUsedSize());
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data! Connection reset by peer.", buff->getUsedSize());
                 connected = false;
                 break;
             case WSAETIMEDOUT:
-                SPACEMMA_ERROR("Failed to send {} data! Connection timed out.", buff->getUsedSize());
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data! Connection timed out.", buff->getUsedSize());
                 connected = false;
                 break;
             default:
-                SPACEMMA_ERROR("Failed to send {} data ({})!", buff->getUsedSize(), error);
+                SPACEMMA_CATEGORY_ERROR(Net, "Failed to send {} data ({})!", buff->getUsedSize(), error);
                 break;
         }
         return false;
@@ -158,33 +159,49 @@ bool spacemma::WinTCPServer::send(gsl::not_null<ByteBuffer*> buff)
 
 spacemma::ByteBuffer* spacemma::WinTCPServer::receive()
 {
-    int received = recv(clientSocket, recvBuffer, TCP_SOCKET_BUFFER_SIZE, 0);
-    if (received == 0)
+    while (true)
     {
-        return nullptr;
-    }
-    if (received == SOCKET_ERROR)
-    {
-        const int error = WSAGetLastError();
-        switch (error)
+        gsl::span<uint8_t> freeSpace = reassembler.getFreeSpace(*bufferPool);
+        if (freeSpace.empty())
         {
-            case WSAECONNRESET:
-                SPACEMMA_ERROR("Failed to receive data! Connection reset by peer.");
-                connected = false;
-                break;
-            case WSAETIMEDOUT:
-                SPACEMMA_ERROR("Failed to receive data! Connection timed out.");
-                connected = false;
-                break;
-            default:
-                SPACEMMA_ERROR("Failed to receive data ({})!", error);
-                break;
+            SPACEMMA_CATEGORY_ERROR(Net, "Failed to acquire a receive buffer!");
+            return nullptr;
+        }
+        int received = recv(clientSocket, reinterpret_cast<char*>(freeSpace.data()), static_cast<int>(freeSpace.size()), 0);
+        if (received == 0)
+        {
+            return nullptr;
+        }
+        if (received == SOCKET_ERROR)
+        {
+            const int error = WSAGetLastError();
+            switch (error)
+            {
+                case WSAECONNRESET:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data! Connection reset by peer.");
+                    connected = false;
+                    break;
+                case WSAETIMEDOUT:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data! Connection timed out.");
+                    connected = false;
+                    break;
+                default:
+                    SPACEMMA_CATEGORY_ERROR(Net, "Failed to receive data ({})!", error);
+                    break;
+            }
+            return nullptr;
+        }
+        if (!reassembler.commit(received))
+        {
+            SPACEMMA_CATEGORY_ERROR(Net, "Received malformed data stream!");
+            connected = false;
+            return nullptr;
+        }
+        if (ByteBuffer* buff = reassembler.takeFrames())
+        {
+            return buff;
         }
-        return nullptr;
     }
-    ByteBuffer* buff = bufferPool->getBuffer(received);
-    memcpy(buff->getPointer(), recvBuffer, received);
-    return buff;
 }
 
 bool spacemma::WinTCPServer::shutdown()
@@ -208,7 +225,7 @@ bool spacemma::WinTCPServer::shutdownServer() const
     {
         if (::shutdown(serverSocket, SD_BOTH) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to shut down server socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down server socket ({})!", WSAGetLastError());
             return false;
         }
     }
@@ -221,7 +238,7 @@ bool spacemma::WinTCPServer::shutdownClient() const
     {
         if (::shutdown(clientSocket, SD_BOTH) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to shut down client socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to shut down client socket ({})!", WSAGetLastError());
             return false;
         }
     }
@@ -234,7 +251,7 @@ bool spacemma::WinTCPServer::closeServer()
     {
         if (closesocket(serverSocket) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to close server socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to close server socket ({})!", WSAGetLastError());
             return false;
         }
         serverSocket = INVALID_SOCKET;
@@ -248,10 +265,12 @@ bool spacemma::WinTCPServer::closeClient()
     {
         if (closesocket(clientSocket) == SOCKET_ERROR)
         {
-            SPACEMMA_WARN("Failed to close client socket ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_WARN(Net, "Failed to close client socket ({})!", WSAGetLastError());
             return false;
         }
         clientSocket = INVALID_SOCKET;
     }
     return true;
 }
+
+#endif
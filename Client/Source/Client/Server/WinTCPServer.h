@@ -1,5 +1,6 @@
 #pragma once
 
+#if PLATFORM_WINDOWS
 #include "TCPServer.h"
 #include "WinsockUtil.h"
 
@@ -29,7 +30,9 @@ namespace spacemma
         bool closeClient();
         SOCKET serverSocket{ INVALID_SOCKET }, clientSocket{ INVALID_SOCKET };
         sockaddr_in address{};
-        char recvBuffer[TCP_SOCKET_BUFFER_SIZE]{ 0 };
+        StreamReassembler reassembler{};
         bool connected{ false };
     };
 }
+
+#endif
@@ -1,20 +1,34 @@
+#if PLATFORM_WINDOWS
 #include "WinThread.h"
 #include "SpaceLog.h"
 
+spacemma::WinThread::WinThread()
+{
+    interruptEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!interruptEvent)
+    {
+        SPACEMMA_CATEGORY_ERROR(Thread, "Failed to create the thread interrupt event ({})! Sleeps will not be interruptible.", GetLastError());
+    }
+}
+
 spacemma::WinThread::~WinThread()
 {
     if (threadHandle)
     {
         if (running && !join())
         {
-            SPACEMMA_WARN("Failed to join thread while destroying the object, terminating...");
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to join thread while destroying the object, terminating...");
             if (!terminate())
             {
-                SPACEMMA_ERROR("Failed to terminate thread while destroying the object!");
+                SPACEMMA_CATEGORY_ERROR(Thread, "Failed to terminate thread while destroying the object!");
             }
         }
         closeThreadHandle();
     }
+    if (interruptEvent)
+    {
+        CloseHandle(interruptEvent);
+    }
 }
 
 bool spacemma::WinThread::run(ThreadFunc func, void* _ptr)
@@ -22,21 +36,45 @@ bool spacemma::WinThread::run(ThreadFunc func, void* _ptr)
     std::lock_guard lock(mutex);
     if (running)
     {
-        SPACEMMA_WARN("Attempted to invoke run on a thread that is already running!");
+        SPACEMMA_CATEGORY_WARN(Thread, "Attempted to invoke run on a thread that is already running!");
         return false;
     }
     running = true;
     interrupted = false;
+    if (interruptEvent)
+    {
+        ResetEvent(interruptEvent);
+    }
     this->threadFunc = func;
     this->ptr = _ptr;
     if (threadHandle)
     {
         closeThreadHandle();
     }
-    threadHandle = CreateThread(nullptr, 0ULL, threadProc, this, 0UL, nullptr);
+    threadHandle = CreateThread(nullptr, 0ULL, threadProc, this, CREATE_SUSPENDED, nullptr);
     if (!threadHandle)
     {
-        SPACEMMA_ERROR("Failed to create a thread ({})!", GetLastError());
+        SPACEMMA_CATEGORY_ERROR(Thread, "Failed to create a thread ({})!", GetLastError());
+        running = false;
+        return false;
+    }
+    {
+        std::lock_guard settingsLock(settingsMutex);
+        applyName();
+        if (cpuMask)
+        {
+            applyAffinity();
+        }
+        if (priority != ThreadPriority::Normal)
+        {
+            applyPriority();
+        }
+    }
+    if (ResumeThread(threadHandle) == static_cast<DWORD>(-1))
+    {
+        SPACEMMA_CATEGORY_ERROR(Thread, "Failed to resume a thread ({})!", GetLastError());
+        TerminateThread(threadHandle, THREAD_RESULT_TERMINATED);
+        closeThreadHandle();
         running = false;
         return false;
     }
@@ -50,7 +88,7 @@ bool spacemma::WinThread::isRunning()
         DWORD exitCode;
         if (!GetExitCodeThread(threadHandle, &exitCode))
         {
-            SPACEMMA_WARN("Failed to check thread exit code ({})!", GetLastError());
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to check thread exit code ({})!", GetLastError());
             return true;
         }
         switch (exitCode)
@@ -58,12 +96,12 @@ bool spacemma::WinThread::isRunning()
         case STILL_ACTIVE:
             return true;
         case THREAD_RESULT_TERMINATED:
-            SPACEMMA_WARN("Detected thread termination exit code!");
+            SPACEMMA_CATEGORY_WARN(Thread, "Detected thread termination exit code!");
             break;
         case THREAD_RESULT_SUCCESS:
             break;
         default:
-            SPACEMMA_WARN("Unrecognized thread exit code {}!", exitCode);
+            SPACEMMA_CATEGORY_WARN(Thread, "Unrecognized thread exit code {}!", exitCode);
             break;
         }
         running = false;
@@ -74,6 +112,10 @@ bool spacemma::WinThread::isRunning()
 void spacemma::WinThread::interrupt()
 {
     interrupted = true;
+    if (interruptEvent && !SetEvent(interruptEvent))
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to signal the thread interrupt ({})!", GetLastError());
+    }
 }
 
 bool spacemma::WinThread::isInterrupted()
@@ -94,14 +136,14 @@ bool spacemma::WinThread::join()
     switch (waitResult)
     {
     case WAIT_TIMEOUT:
-        SPACEMMA_WARN("Thread join attempt timed out!");
+        SPACEMMA_CATEGORY_WARN(Thread, "Thread join attempt timed out!");
         return false;
     case WAIT_FAILED:
-        SPACEMMA_ERROR("Thread join attempt failed ({})!", GetLastError());
+        SPACEMMA_CATEGORY_ERROR(Thread, "Thread join attempt failed ({})!", GetLastError());
         running = false;
         return false;
     case WAIT_ABANDONED:
-        SPACEMMA_WARN("Thread join attempt resulted in WAIT_ABANDONED!");[[fallthrough]];
+        SPACEMMA_CATEGORY_WARN(Thread, "Thread join attempt resulted in WAIT_ABANDONED!");[[fallthrough]];
     default:
         [[fallthrough]];
     case WAIT_OBJECT_0:
@@ -120,7 +162,7 @@ bool spacemma::WinThread::terminate()
     }
     if (!TerminateThread(threadHandle, 1UL))
     {
-        SPACEMMA_WARN("Thread termination attempt failed ({})!", GetLastError());
+        SPACEMMA_CATEGORY_WARN(Thread, "Thread termination attempt failed ({})!", GetLastError());
         return false;
     }
     running = false;
@@ -128,6 +170,37 @@ bool spacemma::WinThread::terminate()
     return true;
 }
 
+bool spacemma::WinThread::sleep(uint32_t milliseconds)
+{
+    if (!interruptEvent)
+    {
+        Sleep(milliseconds);
+        return !interrupted;
+    }
+    return WaitForSingleObject(interruptEvent, milliseconds) == WAIT_TIMEOUT;
+}
+
+bool spacemma::WinThread::setName(const std::string& _name)
+{
+    std::lock_guard lock(settingsMutex);
+    name = _name;
+    return !running || applyName();
+}
+
+bool spacemma::WinThread::setAffinity(uint64_t _cpuMask)
+{
+    std::lock_guard lock(settingsMutex);
+    cpuMask = _cpuMask;
+    return !running || applyAffinity();
+}
+
+bool spacemma::WinThread::setPriority(ThreadPriority _priority)
+{
+    std::lock_guard lock(settingsMutex);
+    priority = _priority;
+    return !running || applyPriority();
+}
+
 DWORD spacemma::WinThread::getThreadId() const
 {
     return threadHandle ? GetThreadId(threadHandle) : 0UL;
@@ -139,7 +212,7 @@ void spacemma::WinThread::closeThreadHandle()
     {
         if (!CloseHandle(threadHandle))
         {
-            SPACEMMA_WARN("Failed to close the thread handle!");
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to close the thread handle!");
         }
         else
         {
@@ -148,6 +221,67 @@ void spacemma::WinThread::closeThreadHandle()
     }
 }
 
+bool spacemma::WinThread::applyName() const
+{
+    if (name.empty())
+    {
+        return true;
+    }
+    // the names are plain ASCII
+    const std::wstring wideName(name.begin(), name.end());
+    if (FAILED(SetThreadDescription(threadHandle, wideName.c_str())))
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the name of thread '{}'!", name);
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::WinThread::applyAffinity() const
+{
+    DWORD_PTR mask = static_cast<DWORD_PTR>(cpuMask);
+    if (!mask)
+    {
+        DWORD_PTR systemMask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask))
+        {
+            SPACEMMA_CATEGORY_WARN(Thread, "Failed to get the process affinity ({})!", GetLastError());
+            return false;
+        }
+    }
+    if (!SetThreadAffinityMask(threadHandle, mask))
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the affinity of thread '{}' to {:#x} ({})!", name, cpuMask, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+bool spacemma::WinThread::applyPriority() const
+{
+    int value = THREAD_PRIORITY_NORMAL;
+    switch (priority)
+    {
+    case ThreadPriority::Low:
+        value = THREAD_PRIORITY_BELOW_NORMAL;
+        break;
+    case ThreadPriority::High:
+        value = THREAD_PRIORITY_ABOVE_NORMAL;
+        break;
+    case ThreadPriority::Realtime:
+        value = THREAD_PRIORITY_TIME_CRITICAL;
+        break;
+    default:
+        break;
+    }
+    if (!SetThreadPriority(threadHandle, value))
+    {
+        SPACEMMA_CATEGORY_WARN(Thread, "Failed to set the priority of thread '{}' ({})!", name, GetLastError());
+        return false;
+    }
+    return true;
+}
+
 DWORD WINAPI spacemma::WinThread::threadProc(LPVOID param)
 {
     Thread* thread = reinterpret_cast<Thread*>(param);
@@ -158,7 +292,9 @@ DWORD WINAPI spacemma::WinThread::threadProc(LPVOID param)
     }
     else
     {
-        SPACEMMA_WARN("An empty thread has been started!");
+        SPACEMMA_CATEGORY_WARN(Thread, "An empty thread has been started!");
     }
     return THREAD_RESULT_SUCCESS;
 }
+
+#endif
@@ -1,4 +1,6 @@
 #pragma once
+
+#if PLATFORM_WINDOWS
 #include "Thread.h"
 #include "SpaceLog.h"
 
@@ -9,10 +11,14 @@
 
 namespace spacemma
 {
+    /**
+     * Thread built on the Win32 API. Interrupts are signalled through a manual-reset event, so that sleeping threads
+     * wake up at once. Threads are created suspended and resumed once their settings are applied.
+     */
     class WinThread final : public Thread
     {
     public:
-        WinThread() = default;
+        WinThread();
         ~WinThread();
         WinThread(WinThread&) = delete;
         WinThread(WinThread&&) = delete;
@@ -24,12 +30,25 @@ namespace spacemma
         bool isInterrupted() override;
         bool join() override;
         bool terminate() override;
+        bool sleep(uint32_t milliseconds) override;
+        bool setName(const std::string& name) override;
+        bool setAffinity(uint64_t cpuMask) override;
+        bool setPriority(ThreadPriority priority) override;
         DWORD getThreadId() const;
     private:
         void closeThreadHandle();
+        /**
+         * Applies the settings to the thread handle.
+         */
+        bool applyName() const;
+        bool applyAffinity() const;
+        bool applyPriority() const;
         static DWORD threadProc(LPVOID param);
         std::atomic_bool interrupted{false}, running{false};
         std::mutex mutex;
         HANDLE threadHandle{nullptr};
+        HANDLE interruptEvent{nullptr};
     };
 }
+
+#endif
@@ -1,3 +1,4 @@
+#if PLATFORM_WINDOWS
 #include "WinsockUtil.h"
 
 std::vector<void*> spacemma::WinsockUtil::wsaInvokers{};
@@ -7,10 +8,10 @@ bool spacemma::WinsockUtil::wsaStartup(void* owner)
     if (wsaInvokers.empty())
     {
         WSADATA wsaData;
-        SPACEMMA_DEBUG("Running WSAStartup...");
+        SPACEMMA_CATEGORY_DEBUG(Net, "Running WSAStartup...");
         if (int ret = WSAStartup(MAKEWORD(2, 2), &wsaData); ret != 0)
         {
-            SPACEMMA_ERROR("WSAStartup failed ({})!", ret);
+            SPACEMMA_CATEGORY_ERROR(Net, "WSAStartup failed ({})!", ret);
             return false;
         }
         wsaInvokers.push_back(owner);
@@ -31,12 +32,58 @@ bool spacemma::WinsockUtil::wsaCleanup(void* owner)
     }
     if (wsaInvokers.empty())
     {
-        SPACEMMA_DEBUG("Running WSACleanup...");
+        SPACEMMA_CATEGORY_DEBUG(Net, "Running WSACleanup...");
         if (int ret = WSACleanup(); ret != 0)
         {
-            SPACEMMA_ERROR("WSACleanup failed ({})!", WSAGetLastError());
+            SPACEMMA_CATEGORY_ERROR(Net, "WSACleanup failed ({})!", WSAGetLastError());
             return false;
         }
     }
     return true;
 }
+
+int spacemma::WinsockUtil::sendFrame(SOCKET socket, gsl::not_null<ByteBuffer*> buff)
+{
+    size_t sent = 0;
+    return sendFrame(socket, buff, sent);
+}
+
+int spacemma::WinsockUtil::sendFrame(SOCKET socket, gsl::not_null<ByteBuffer*> buff, size_t& sent)
+{
+    if (buff->getUsedSize() > TCP_MAX_FRAME_SIZE)
+    {
+        WSASetLastError(WSAEMSGSIZE);
+        return SOCKET_ERROR;
+    }
+    FrameLength frameLength = static_cast<FrameLength>(buff->getUsedSize());
+    WSABUF frameParts[2]{ { static_cast<ULONG>(TCP_FRAME_HEADER_SIZE), reinterpret_cast<char*>(&frameLength) },
+                          { static_cast<ULONG>(buff->getUsedSize()), reinterpret_cast<char*>(buff->getPointer()) } };
+    WSABUF* part = frameParts;
+    DWORD partCount = 2;
+    DWORD skipped = static_cast<DWORD>(sent);
+    while (partCount > 0)
+    {
+        // skip the part of the frame that was already sent
+        while (partCount > 0 && skipped >= part->len)
+        {
+            skipped -= part->len;
+            ++part;
+            --partCount;
+        }
+        if (partCount == 0)
+        {
+            break;
+        }
+        part->buf += skipped;
+        part->len -= skipped;
+        if (WSASend(socket, part, partCount, &skipped, 0, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            // the buffer of a non-blocking socket is full, the caller sends the rest once it becomes writable
+            return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : SOCKET_ERROR;
+        }
+        sent += skipped;
+    }
+    return 0;
+}
+
+#endif
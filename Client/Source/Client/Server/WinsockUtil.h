@@ -1,6 +1,8 @@
 #pragma once
 
+#if PLATFORM_WINDOWS
 #include "SpaceLog.h"
+#include "StreamReassembler.h"
 
 #include <WS2tcpip.h>
 #include <vector>
@@ -13,7 +15,20 @@ namespace spacemma
         WinsockUtil() = delete;
         static bool wsaStartup(void* owner);
         static bool wsaCleanup(void* owner);
+        /**
+         * Sends the buffer data through a blocking socket as a single length-prefixed frame.
+         * Returns SOCKET_ERROR on failure, the error code can be acquired with WSAGetLastError.
+         */
+        static int sendFrame(SOCKET socket, gsl::not_null<ByteBuffer*> buff);
+        /**
+         * Sends the length-prefixed frame of the buffer data through the socket, starting at the offset sent into the frame,
+         * and advances sent by the amount of bytes sent. Non-blocking sockets send only what fits into their send buffer.
+         * Returns SOCKET_ERROR on failure, the error code can be acquired with WSAGetLastError.
+         */
+        static int sendFrame(SOCKET socket, gsl::not_null<ByteBuffer*> buff, size_t& sent);
     private:
         static std::vector<void*> wsaInvokers;
     };
 }
+
+#endif
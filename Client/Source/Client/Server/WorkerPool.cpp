@@ -0,0 +1,140 @@
+#include "WorkerPool.h"
+#include "PlatformThread.h"
+#include "SpaceLog.h"
+
+#include <algorithm>
+#include <thread>
+
+spacemma::WorkerPool::WorkerPool(size_t capacity) : tasks(std::max<size_t>(capacity, 1))
+{
+}
+
+spacemma::WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+bool spacemma::WorkerPool::start(unsigned char threadCount, const std::string& namePrefix, uint64_t cpuMask,
+                                 ThreadPriority priority)
+{
+    if (!threads.empty())
+    {
+        SPACEMMA_CATEGORY_WARN(Pool, "Attempted to start a worker pool which is already running!");
+        return false;
+    }
+    if (!threadCount)
+    {
+        SPACEMMA_CATEGORY_ERROR(Pool, "Worker thread amount must be greater than zero!");
+        return false;
+    }
+    {
+        std::lock_guard lock(mutex);
+        stopping = false;
+    }
+    for (unsigned char i = 0; i < threadCount; ++i)
+    {
+        Thread* thread = new PlatformThread();
+        threads.push_back(thread);
+        thread->setName(namePrefix + std::to_string(i));
+        thread->setAffinity(cpuMask);
+        thread->setPriority(priority);
+        if (!thread->run(threadWorker, this))
+        {
+            SPACEMMA_CATEGORY_ERROR(Pool, "Failed to start worker thread #{}!", i);
+            stop();
+            return false;
+        }
+    }
+    SPACEMMA_CATEGORY_DEBUG(Pool, "Started {} worker threads!", threadCount);
+    return true;
+}
+
+void spacemma::WorkerPool::stop()
+{
+    if (threads.empty())
+    {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (Thread* thread : threads)
+    {
+        thread->interrupt();
+    }
+    for (Thread* thread : threads)
+    {
+        thread->join();
+        delete thread;
+    }
+    threads.clear();
+    std::lock_guard lock(mutex);
+    if (count)
+    {
+        SPACEMMA_CATEGORY_DEBUG(Pool, "Discarding {} queued worker tasks...", count);
+    }
+    head = 0;
+    count = 0;
+}
+
+bool spacemma::WorkerPool::submit(WorkerTaskFunc func, void* ptr, uintptr_t arg)
+{
+    {
+        std::lock_guard lock(mutex);
+        if (stopping || count == tasks.size())
+        {
+            return false;
+        }
+        tasks[(head + count) % tasks.size()] = { func, ptr, arg };
+        ++count;
+    }
+    condition.notify_one();
+    return true;
+}
+
+bool spacemma::WorkerPool::isRunning() const
+{
+    return !threads.empty();
+}
+
+unsigned char spacemma::WorkerPool::getThreadCount() const
+{
+    return static_cast<unsigned char>(threads.size());
+}
+
+size_t spacemma::WorkerPool::getQueuedCount()
+{
+    std::lock_guard lock(mutex);
+    return count;
+}
+
+unsigned char spacemma::WorkerPool::getDefaultThreadCount()
+{
+    // hardware_concurrency may return zero if the amount is not known
+    return static_cast<unsigned char>(std::clamp(std::thread::hardware_concurrency(), 1U, 255U));
+}
+
+void spacemma::WorkerPool::threadWorker(gsl::not_null<Thread*> thread, void* pool)
+{
+    WorkerPool* wp = reinterpret_cast<WorkerPool*>(pool);
+    SPACEMMA_CATEGORY_DEBUG(Pool, "Starting threadWorker...");
+    do
+    {
+        WorkerTask task;
+        {
+            std::unique_lock lock(wp->mutex);
+            wp->condition.wait(lock, [wp] { return wp->count || wp->stopping; });
+            if (wp->stopping)
+            {
+                break;
+            }
+            task = wp->tasks[wp->head];
+            wp->head = (wp->head + 1) % wp->tasks.size();
+            --wp->count;
+        }
+        task.func(task.ptr, task.arg);
+    } while (!thread->isInterrupted());
+    SPACEMMA_CATEGORY_DEBUG(Pool, "Stopping threadWorker...");
+}
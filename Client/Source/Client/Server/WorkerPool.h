@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Thread.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spacemma
+{
+    typedef void (*WorkerTaskFunc)(void* ptr, uintptr_t arg);
+
+    /**
+     * A task run by one of the workers of a WorkerPool.
+     */
+    struct WorkerTask
+    {
+        WorkerTaskFunc func{ nullptr };
+        void* ptr{ nullptr };
+        uintptr_t arg{ 0 };
+    };
+
+    /**
+     * A fixed amount of worker threads running the submitted tasks in submission order.
+     * The task queue is allocated once with the given capacity, submitting to a full queue fails instead of blocking.
+     * Tasks may be submitted from any thread, including the workers themselves.
+     */
+    class WorkerPool final
+    {
+    public:
+        WorkerPool(size_t capacity);
+        ~WorkerPool();
+        WorkerPool(WorkerPool&) = delete;
+        WorkerPool(WorkerPool&&) = delete;
+        WorkerPool& operator=(WorkerPool&) = delete;
+        WorkerPool& operator=(WorkerPool&&) = delete;
+        /**
+         * Starts the given amount of workers named namePrefix followed by their index, with the given CPU affinity
+         * mask and priority. Returns false if any of the workers failed to start, true otherwise.
+         */
+        bool start(unsigned char threadCount, const std::string& namePrefix, uint64_t cpuMask = 0,
+                   ThreadPriority priority = ThreadPriority::Normal);
+        /**
+         * Waits for the running tasks to finish and stops all workers. Tasks still queued are discarded.
+         */
+        void stop();
+        /**
+         * Queues the task to be run by the first free worker.
+         * Returns false if the pool is not running or the queue is full, true otherwise.
+         */
+        bool submit(WorkerTaskFunc func, void* ptr, uintptr_t arg = 0);
+        /**
+         * Returns true if the workers are running, false otherwise.
+         */
+        bool isRunning() const;
+        /**
+         * Returns the amount of running workers.
+         */
+        unsigned char getThreadCount() const;
+        /**
+         * Returns the amount of tasks waiting in the queue at the moment of the call.
+         */
+        size_t getQueuedCount();
+        /**
+         * Returns the amount of hardware threads, clamped to the range of a thread count.
+         */
+        static unsigned char getDefaultThreadCount();
+    private:
+        static void threadWorker(gsl::not_null<Thread*> thread, void* pool);
+        std::vector<Thread*> threads{};
+        std::vector<WorkerTask> tasks;
+        size_t head{ 0 };
+        size_t count{ 0 };
+        bool stopping{ false };
+        std::mutex mutex{};
+        std::condition_variable condition{};
+    };
+}
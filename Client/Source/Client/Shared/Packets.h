@@ -1,9 +1,23 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <iterator>
 #include "Client/Server/SpaceLog.h"
 
+/** Bits of a single quantized position axis, all three axes are packed into 64 bits. */
+#define NET_POSITION_BITS 21
+/** Quantized positions are clamped to [-NET_POSITION_EXTENT, NET_POSITION_EXTENT] on every axis. */
+#define NET_POSITION_EXTENT 1048576.0f
+/** Bits of a single quantized rotation axis (at most 16). */
+#define NET_ANGLE_BITS 16
+/** Bits of a single quantized velocity axis (at most 16). */
+#define NET_VELOCITY_BITS 16
+/** Quantized velocities are clamped to [-NET_VELOCITY_LIMIT, NET_VELOCITY_LIMIT] on every axis. */
+#define NET_VELOCITY_LIMIT 8192.0f
+
 namespace spacemma
 {
     struct NetVector2D final
@@ -44,6 +58,128 @@ namespace spacemma
         float roll;
     };
 
+    /**
+     * Maps the value clamped to [-limit, limit] to an unsigned integer of the given amount of bits.
+     * Zero and both limits are represented exactly.
+     */
+    inline uint32_t quantizeFloat(float value, float limit, unsigned bits)
+    {
+        const double maxMagnitude = static_cast<double>((1ULL << (bits - 1U)) - 1ULL);
+        // also maps NaN to zero
+        const double clamped = value >= -limit ? std::min<double>(value, limit) : (value < -limit ? -limit : 0.0);
+        return static_cast<uint32_t>(std::llround(clamped / limit * maxMagnitude + maxMagnitude));
+    }
+
+    /**
+     * Maps the quantized value back to [-limit, limit].
+     */
+    inline float dequantizeFloat(uint32_t value, float limit, unsigned bits)
+    {
+        const double maxMagnitude = static_cast<double>((1ULL << (bits - 1U)) - 1ULL);
+        return static_cast<float>((static_cast<double>(value) - maxMagnitude) / maxMagnitude * limit);
+    }
+
+    /**
+     * Maps the angle in degrees to an unsigned integer of the given amount of bits, the full circle wraps around.
+     */
+    inline uint16_t quantizeAngle(float angle, unsigned bits)
+    {
+        const double steps = static_cast<double>(1ULL << bits);
+        double normalized = std::fmod(static_cast<double>(angle), 360.0);
+        if (!(normalized >= 0.0))
+        {
+            normalized = normalized < 0.0 ? normalized + 360.0 : 0.0;
+        }
+        return static_cast<uint16_t>(static_cast<uint32_t>(std::llround(normalized / 360.0 * steps)) & ((1U << bits) - 1U));
+    }
+
+    /**
+     * Maps the quantized angle back to degrees in (-180, 180].
+     */
+    inline float dequantizeAngle(uint16_t value, unsigned bits)
+    {
+        const double angle = value * 360.0 / static_cast<double>(1ULL << bits);
+        return static_cast<float>(angle > 180.0 ? angle - 360.0 : angle);
+    }
+
+    /**
+     * A position quantized to NET_POSITION_BITS per axis within NET_POSITION_EXTENT.
+     */
+    struct NetQuantizedVector final
+    {
+        FVector asFVector() const
+        {
+            const uint64_t bits = static_cast<uint64_t>(packed[0]) | static_cast<uint64_t>(packed[1]) << 32U;
+            const uint64_t mask = (1ULL << NET_POSITION_BITS) - 1ULL;
+            return FVector(
+                dequantizeFloat(static_cast<uint32_t>(bits & mask), NET_POSITION_EXTENT, NET_POSITION_BITS),
+                dequantizeFloat(static_cast<uint32_t>(bits >> NET_POSITION_BITS & mask), NET_POSITION_EXTENT, NET_POSITION_BITS),
+                dequantizeFloat(static_cast<uint32_t>(bits >> 2U * NET_POSITION_BITS & mask), NET_POSITION_EXTENT, NET_POSITION_BITS));
+        }
+        NetQuantizedVector() = default;
+        NetQuantizedVector(FVector fvec)
+        {
+            const uint64_t bits =
+                static_cast<uint64_t>(quantizeFloat(fvec.X, NET_POSITION_EXTENT, NET_POSITION_BITS)) |
+                static_cast<uint64_t>(quantizeFloat(fvec.Y, NET_POSITION_EXTENT, NET_POSITION_BITS)) << NET_POSITION_BITS |
+                static_cast<uint64_t>(quantizeFloat(fvec.Z, NET_POSITION_EXTENT, NET_POSITION_BITS)) << 2U * NET_POSITION_BITS;
+            packed[0] = static_cast<uint32_t>(bits);
+            packed[1] = static_cast<uint32_t>(bits >> 32U);
+        }
+        // kept as two halves, so that the packets stay aligned to 4 bytes
+        uint32_t packed[2];
+    };
+
+    /**
+     * A rotation quantized to NET_ANGLE_BITS per axis.
+     */
+    struct NetQuantizedRotator final
+    {
+        FRotator asFRotator() const
+        {
+            return FRotator(dequantizeAngle(pitch, NET_ANGLE_BITS), dequantizeAngle(yaw, NET_ANGLE_BITS),
+                            dequantizeAngle(roll, NET_ANGLE_BITS));
+        }
+        NetQuantizedRotator() = default;
+        NetQuantizedRotator(FRotator frot) : pitch(quantizeAngle(frot.Pitch, NET_ANGLE_BITS)),
+                                             yaw(quantizeAngle(frot.Yaw, NET_ANGLE_BITS)),
+                                             roll(quantizeAngle(frot.Roll, NET_ANGLE_BITS)) {}
+        uint16_t pitch;
+        uint16_t yaw;
+        uint16_t roll;
+    };
+
+    /**
+     * A velocity quantized to NET_VELOCITY_BITS per axis within NET_VELOCITY_LIMIT.
+     */
+    struct NetQuantizedVelocity final
+    {
+        FVector asFVector() const
+        {
+            return FVector(dequantizeFloat(x, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS),
+                           dequantizeFloat(y, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS),
+                           dequantizeFloat(z, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS));
+        }
+        NetQuantizedVelocity() = default;
+        NetQuantizedVelocity(FVector fvec)
+            : x(static_cast<uint16_t>(quantizeFloat(fvec.X, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS))),
+              y(static_cast<uint16_t>(quantizeFloat(fvec.Y, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS))),
+              z(static_cast<uint16_t>(quantizeFloat(fvec.Z, NET_VELOCITY_LIMIT, NET_VELOCITY_BITS))) {}
+        uint16_t x;
+        uint16_t y;
+        uint16_t z;
+    };
+
+    /**
+     * Quantized movement state of a single player.
+     */
+    struct NetQuantizedMovement final
+    {
+        NetQuantizedVector location;
+        NetQuantizedRotator rotator;
+        NetQuantizedVelocity velocity;
+    };
+
     namespace packets
     {
 
@@ -76,12 +212,44 @@ namespace spacemma
             S2C_HInvalidData,
             C2S_HInitConnection,
             S2C_HUpdateScoreboard,
-            S2C_HEnemyReceivedDamage
+            S2C_HEnemyReceivedDamage,
+            S2C_HQuantizedPlayerMovement,
+            S2C_HWorldSnapshot,
+            C2S_HAckMovement,
+            C2S_HMovementInput,
+            S2C_HOwnMovement
+        };
+
+        /**
+         * Fields of a player's movement which can be present in a world snapshot entry.
+         */
+        enum MovementField : uint8_t
+        {
+            MF_Location = 1U << 0U,
+            MF_Pitch = 1U << 1U,
+            MF_Yaw = 1U << 2U,
+            MF_Roll = 1U << 3U,
+            MF_VelocityX = 1U << 4U,
+            MF_VelocityY = 1U << 5U,
+            MF_VelocityZ = 1U << 6U,
+            MF_AllFields = 0x7FU,
+            // the update is a full state which does not depend on any previous one
+            MF_Full = 1U << 7U
+        };
+
+        /**
+         * Parts of the player's state changed by a movement input.
+         */
+        enum MovementInputField : uint8_t
+        {
+            MI_Velocity = 1U << 0U,
+            MI_Rotation = 1U << 1U
         };
 
         /**
          * Sent to every player after creating a connection.
-         * Tells the player what his/her ID is.
+         * Tells the player what his/her ID is. IDs consist of the server's client slot and its generation,
+         * so an ID is never reused right away for a player who connects after a disconnection.
          */
         struct S2C_ProvidePlayerId
         {
@@ -142,6 +310,8 @@ namespace spacemma
 
         /**
          * shooting attempt (might verify the location/rotation, not neccessary)
+         * The server time is the world snapshot time in milliseconds at which the shooter rendered the other players,
+         * against which the shot is judged, or zero if the shooter did not receive any world snapshot yet.
          */
         struct C2S_Shoot
         {
@@ -150,6 +320,7 @@ namespace spacemma
             uint16_t playerId{};
             NetVector location;
             NetRotator rotator;
+            uint32_t serverTime{};
         };
 
         /**
@@ -189,6 +360,91 @@ namespace spacemma
             NetVector velocity;
         };
 
+        /**
+         * Informs about player location, rotation and speed with quantized values (24 instead of 40 bytes).
+         * The precision is set by the NET_POSITION_*, NET_ANGLE_* and NET_VELOCITY_* definitions.
+         */
+        struct S2C_QuantizedPlayerMovement final
+        {
+            uint8_t header{ S2C_HQuantizedPlayerMovement };
+            uint8_t padding{};
+            uint16_t playerId{};
+            NetQuantizedVector location;
+            NetQuantizedRotator rotator;
+            NetQuantizedVelocity velocity;
+        };
+
+        /**
+         * Informs about the movement of all players which changed since the last snapshot sent to the receiver.
+         * The header is followed by playerCount entries, each being a WorldSnapshotEntry followed by the values
+         * of the fields set in its mask. Snapshots with delta entries are numbered by a nonzero sequence,
+         * which the receiver acknowledges with C2S_AckMovement. Snapshots with only full entries may have
+         * a zero sequence, in which case they are shared by all receivers and not acknowledged.
+         * The server time is in milliseconds since the server started (wrapping around) and drives the client's playout clock.
+         */
+        struct S2C_WorldSnapshot final
+        {
+            uint8_t header{ S2C_HWorldSnapshot };
+            uint8_t padding{};
+            uint16_t sequence{};
+            uint32_t serverTime{};
+            uint16_t playerCount{};
+            uint16_t padding2{};
+        };
+
+        /**
+         * A single player's entry of S2C_WorldSnapshot. It is followed by the values of the fields set in the mask,
+         * in the order of MovementField (8 bytes of location and 2 bytes for each other field).
+         * An entry without any fields tells that the player left the receiver's area of interest, the receiver hides
+         * the player until its next entry, which is a full state.
+         */
+        struct WorldSnapshotEntry final
+        {
+            uint8_t fields{};
+            uint8_t padding{};
+            uint16_t playerId{};
+        };
+
+        /**
+         * Acknowledges all world snapshots up to the sequence.
+         * If resync is set, the client missed some snapshots and needs full states of all players.
+         */
+        struct C2S_AckMovement final
+        {
+            uint8_t header{ C2S_HAckMovement };
+            uint8_t resync{};
+            uint16_t sequence{};
+        };
+
+        /**
+         * Changes the velocity and/or rotation of the sending player, as set in the fields mask.
+         * Inputs are numbered by a sequence and stamped with the client's time in milliseconds (wrapping around),
+         * which are echoed in S2C_OwnMovement, so that the client can reconcile its prediction.
+         */
+        struct C2S_MovementInput final
+        {
+            uint8_t header{ C2S_HMovementInput };
+            uint8_t fields{};
+            uint16_t sequence{};
+            uint32_t clientTime{};
+            NetVector velocity;
+            NetRotator rotator;
+        };
+
+        /**
+         * Informs the player about its authoritative movement after processing the input with the sequence.
+         * The client time is the input's time advanced by the time the server simulated since the input was applied.
+         */
+        struct S2C_OwnMovement final
+        {
+            uint8_t header{ S2C_HOwnMovement };
+            uint8_t padding{};
+            uint16_t inputSequence{};
+            uint32_t clientTime{};
+            NetVector location;
+            NetVector velocity;
+        };
+
         /**
          * S2C: inform about a player who attached a rope
          * C2S: rope attach attempt (may fail)
@@ -317,7 +573,7 @@ namespace spacemma
         {
             if (packetStruct.nickname.length() > UINT8_MAX)
             {
-                SPACEMMA_ERROR("Unable to create S2C_CreatePlayer packet buffer: nickname too long ({} < {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Unable to create S2C_CreatePlayer packet buffer: nickname too long ({} < {})!",
                                UINT8_MAX, packetStruct.nickname.length());
                 return nullptr;
             }
@@ -332,7 +588,7 @@ namespace spacemma
         {
             if (packetStruct.mapName.length() > UINT8_MAX)
             {
-                SPACEMMA_ERROR("Unable to create S2C_InvalidMap packet buffer: map name too long ({} < {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Unable to create S2C_InvalidMap packet buffer: map name too long ({} < {})!",
                                UINT8_MAX, packetStruct.mapName.length());
                 return nullptr;
             }
@@ -347,13 +603,13 @@ namespace spacemma
         {
             if (packetStruct.mapName.length() > UINT8_MAX)
             {
-                SPACEMMA_ERROR("Unable to create C2S_InitConnection packet buffer: map name too long ({} < {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Unable to create C2S_InitConnection packet buffer: map name too long ({} < {})!",
                                UINT8_MAX, packetStruct.mapName.length());
                 return nullptr;
             }
             if (packetStruct.nickname.length() > UINT8_MAX)
             {
-                SPACEMMA_ERROR("Unable to create C2S_InitConnection packet buffer: nickname too long ({} < {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Unable to create C2S_InitConnection packet buffer: nickname too long ({} < {})!",
                                UINT8_MAX, packetStruct.nickname.length());
                 return nullptr;
             }
@@ -366,18 +622,131 @@ namespace spacemma
             return buffer;
         }
 
+        /**
+         * Returns the mask of fields which differ between both movement states.
+         */
+        inline uint8_t getChangedMovementFields(const NetQuantizedMovement& previous, const NetQuantizedMovement& current)
+        {
+            uint8_t fields = 0U;
+            if (previous.location.packed[0] != current.location.packed[0] || previous.location.packed[1] != current.location.packed[1])
+            {
+                fields |= MF_Location;
+            }
+            const uint16_t previousValues[]{ previous.rotator.pitch, previous.rotator.yaw, previous.rotator.roll,
+                                             previous.velocity.x, previous.velocity.y, previous.velocity.z };
+            const uint16_t currentValues[]{ current.rotator.pitch, current.rotator.yaw, current.rotator.roll,
+                                            current.velocity.x, current.velocity.y, current.velocity.z };
+            for (size_t i = 0U; i < std::size(previousValues); ++i)
+            {
+                if (previousValues[i] != currentValues[i])
+                {
+                    fields |= MF_Pitch << i;
+                }
+            }
+            return fields;
+        }
+
+        /**
+         * Returns the size of the values of the fields set in the mask.
+         */
+        inline size_t getMovementFieldsSize(uint8_t fields)
+        {
+            size_t size = (fields & MF_Location) ? sizeof(NetQuantizedVector) : 0U;
+            for (uint8_t field = MF_Pitch; field <= MF_VelocityZ; field <<= 1U)
+            {
+                size += (fields & field) ? sizeof(uint16_t) : 0U;
+            }
+            return size;
+        }
+
+        /**
+         * Writes the values of the fields set in the mask, returns the amount of written bytes.
+         * The destination must have at least getMovementFieldsSize(fields) bytes.
+         */
+        inline size_t writeMovementFields(uint8_t* dest, uint8_t fields, const NetQuantizedMovement& movement)
+        {
+            const uint16_t values[]{ movement.rotator.pitch, movement.rotator.yaw, movement.rotator.roll,
+                                     movement.velocity.x, movement.velocity.y, movement.velocity.z };
+            size_t pos = 0U;
+            if (fields & MF_Location)
+            {
+                memcpy(dest, &movement.location, sizeof(NetQuantizedVector));
+                pos += sizeof(NetQuantizedVector);
+            }
+            for (size_t i = 0U; i < std::size(values); ++i)
+            {
+                if (fields & (MF_Pitch << i))
+                {
+                    memcpy(dest + pos, &values[i], sizeof(uint16_t));
+                    pos += sizeof(uint16_t);
+                }
+            }
+            return pos;
+        }
+
+        /**
+         * Reads the values of the fields set in the mask into the movement, other fields are kept.
+         */
+        inline bool readMovementFields(gsl::span<uint8_t> buff, size_t& pointerPos, uint8_t fields, NetQuantizedMovement& movement)
+        {
+            const size_t size = getMovementFieldsSize(fields);
+            if ((buff.size() - pointerPos) < size)
+            {
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid movement fields {:x} size ({} > {}) | Size: {}, Pos: {}!",
+                               fields, size, buff.size() - pointerPos, buff.size(), pointerPos);
+                return false;
+            }
+            uint16_t* values[]{ &movement.rotator.pitch, &movement.rotator.yaw, &movement.rotator.roll,
+                                &movement.velocity.x, &movement.velocity.y, &movement.velocity.z };
+            const uint8_t* src = buff.data() + pointerPos;
+            if (fields & MF_Location)
+            {
+                memcpy(&movement.location, src, sizeof(NetQuantizedVector));
+                src += sizeof(NetQuantizedVector);
+            }
+            for (size_t i = 0U; i < std::size(values); ++i)
+            {
+                if (fields & (MF_Pitch << i))
+                {
+                    memcpy(values[i], src, sizeof(uint16_t));
+                    src += sizeof(uint16_t);
+                }
+            }
+            pointerPos += size;
+            return true;
+        }
+
+        /**
+         * Returns the largest possible size of a world snapshot with the given amount of players.
+         */
+        inline size_t getMaxWorldSnapshotSize(size_t playerCount)
+        {
+            return sizeof(S2C_WorldSnapshot) + playerCount * (sizeof(WorldSnapshotEntry) + getMovementFieldsSize(MF_AllFields));
+        }
+
+        /**
+         * Writes a world snapshot entry with the values of the fields set in the mask, returns the amount of written bytes.
+         * The destination must have at least sizeof(WorldSnapshotEntry) + getMovementFieldsSize(fields) bytes.
+         */
+        inline size_t writeWorldSnapshotEntry(uint8_t* dest, uint16_t playerId, uint8_t fields, const NetQuantizedMovement& movement)
+        {
+            const WorldSnapshotEntry entry{ fields, {}, playerId };
+            memcpy(dest, &entry, sizeof(WorldSnapshotEntry));
+            return sizeof(WorldSnapshotEntry) + writeMovementFields(dest + sizeof(WorldSnapshotEntry), fields, movement);
+        }
+
         inline bool reinterpretPacket(gsl::not_null<ByteBuffer*> packet, S2C_CreatePlayer& packetStruct)
         {
             if (packet->getUsedSize() < offsetof(S2C_CreatePlayer, nickname))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {})!",
                                *packet->getPointer(), offsetof(S2C_CreatePlayer, nickname), packet->getUsedSize());
                 return false;
             }
             memcpy(&packetStruct, packet->getPointer(), offsetof(S2C_CreatePlayer, nickname));
             if (packet->getUsedSize() != offsetof(S2C_CreatePlayer, nickname) + packetStruct.nicknameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {})! Expected nickname of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {})! Expected nickname of {} characters!",
                                *packet->getPointer(), offsetof(S2C_CreatePlayer, nickname) + packetStruct.nicknameLength,
                                packet->getUsedSize(), packetStruct.nicknameLength);
                 return false;
@@ -396,14 +765,14 @@ namespace spacemma
         {
             if (packet->getUsedSize() < offsetof(S2C_InvalidMap, mapName))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {})!",
                                *packet->getPointer(), offsetof(S2C_InvalidMap, mapName), packet->getUsedSize());
                 return false;
             }
             memcpy(&packetStruct, packet->getPointer(), offsetof(S2C_InvalidMap, mapName));
             if (packet->getUsedSize() != offsetof(S2C_InvalidMap, mapName) + packetStruct.mapNameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {})! Expected nickname of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {})! Expected nickname of {} characters!",
                                *packet->getPointer(), offsetof(S2C_InvalidMap, mapName) + packetStruct.mapNameLength,
                                packet->getUsedSize(), packetStruct.mapNameLength);
                 return false;
@@ -422,14 +791,14 @@ namespace spacemma
         {
             if (packet->getUsedSize() < offsetof(C2S_InitConnection, mapName))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {})!",
                                *packet->getPointer(), offsetof(C2S_InitConnection, mapName), packet->getUsedSize());
                 return false;
             }
             memcpy(&packetStruct, packet->getPointer(), offsetof(C2S_InitConnection, mapName));
             if (packet->getUsedSize() != offsetof(C2S_InitConnection, mapName) + packetStruct.mapNameLength + packetStruct.nicknameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {})! Expected map name of {} characters and nickname of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {})! Expected map name of {} characters and nickname of {} characters!",
                                *packet->getPointer(), offsetof(C2S_InitConnection, mapName) + packetStruct.mapNameLength + packetStruct.nicknameLength,
                                packet->getUsedSize(), packetStruct.mapNameLength, packetStruct.nicknameLength);
                 return false;
@@ -455,14 +824,14 @@ namespace spacemma
         {
             if ((buff.size() - pointerPos) < offsetof(S2C_CreatePlayer, nickname))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
                                buff[pointerPos], offsetof(S2C_CreatePlayer, nickname), buff.size() - pointerPos, buff.size(), pointerPos);
                 return false;
             }
             memcpy(&packetStruct, buff.data() + pointerPos, offsetof(S2C_CreatePlayer, nickname));
             if (buff.size() < offsetof(S2C_CreatePlayer, nickname) + packetStruct.nicknameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {}) | Size: {}, Pos: {}! Expected nickname of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {}) | Size: {}, Pos: {}! Expected nickname of {} characters!",
                                buff[pointerPos], offsetof(S2C_CreatePlayer, nickname) + packetStruct.nicknameLength,
                                buff.size() - pointerPos, buff.size(), pointerPos, packetStruct.nicknameLength);
                 return false;
@@ -482,14 +851,14 @@ namespace spacemma
         {
             if ((buff.size() - pointerPos) < offsetof(S2C_InvalidMap, mapName))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
                                buff[pointerPos], offsetof(S2C_InvalidMap, mapName), buff.size() - pointerPos, buff.size(), pointerPos);
                 return false;
             }
             memcpy(&packetStruct, buff.data() + pointerPos, offsetof(S2C_InvalidMap, mapName));
             if ((buff.size() - pointerPos) != offsetof(S2C_InvalidMap, mapName) + packetStruct.mapNameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {}) | Size: {}, Pos: {}! Expected map name of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {}) | Size: {}, Pos: {}! Expected map name of {} characters!",
                                buff[pointerPos], offsetof(S2C_InvalidMap, mapName) + packetStruct.mapNameLength,
                                buff.size() - pointerPos, buff.size(), pointerPos, packetStruct.mapNameLength);
                 return false;
@@ -509,14 +878,14 @@ namespace spacemma
         {
             if ((buff.size() - pointerPos) < offsetof(C2S_InitConnection, mapName))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} > {}) | Size: {}, Pos: {}!",
                                buff[pointerPos], offsetof(C2S_InitConnection, mapName), buff.size() - pointerPos, buff.size(), pointerPos);
                 return false;
             }
             memcpy(&packetStruct, buff.data() + pointerPos, offsetof(C2S_InitConnection, mapName));
             if ((buff.size() - pointerPos) != offsetof(C2S_InitConnection, mapName) + packetStruct.mapNameLength + packetStruct.nicknameLength)
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {}) | Size: {}, Pos: {}! Expected map name of {} characters and nickname of {} characters!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {}) | Size: {}, Pos: {}! Expected map name of {} characters and nickname of {} characters!",
                                buff[pointerPos], offsetof(C2S_InitConnection, mapName) + packetStruct.mapNameLength + packetStruct.nicknameLength,
                                buff.size() - pointerPos, buff.size(), pointerPos, packetStruct.mapNameLength, packetStruct.nicknameLength);
                 return false;
@@ -547,7 +916,7 @@ namespace spacemma
             static_assert(!std::is_same<S2C_InvalidMap, T>());
             if (packet->getUsedSize() != sizeof(T))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {})!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {})!",
                                *packet->getPointer(), sizeof(T), packet->getUsedSize());
                 return nullptr;
             }
@@ -562,7 +931,7 @@ namespace spacemma
             static_assert(!std::is_same<S2C_InvalidMap, T>());
             if ((buff.size() - pointerPos) < sizeof(T))
             {
-                SPACEMMA_ERROR("Invalid packet {} size ({} != {}) | Size: {}, Pos: {}!",
+                SPACEMMA_CATEGORY_ERROR(Net, "Invalid packet {} size ({} != {}) | Size: {}, Pos: {}!",
                                buff.data(), sizeof(T), buff.size() - pointerPos, buff.size(), pointerPos);
                 return nullptr;
             }
@@ -10,7 +10,7 @@ void USpaceMMAInstance::Initialize()
     {
         case LevelInitialization::Client:
         {
-            SPACEMMA_DEBUG("Initializing client ({}, {}, {})...", StringCast<ANSICHAR>(*ServerIpAddress).Get(), ServerPort, StringCast<ANSICHAR>(*Nickname).Get());
+            SPACEMMA_CATEGORY_DEBUG(Client, "Initializing client ({}, {}, {})...", StringCast<ANSICHAR>(*ServerIpAddress).Get(), ServerPort, StringCast<ANSICHAR>(*Nickname).Get());
             FActorSpawnParameters params{};
             params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
             AGameClient* client = GetWorld()->SpawnActor<AGameClient>(ClientBP, FVector{}, FRotator{}, FActorSpawnParameters{});
@@ -32,7 +32,7 @@ void USpaceMMAInstance::Initialize()
         break;
         case LevelInitialization::Server:
         {
-            SPACEMMA_DEBUG("Initializing server ({}, {}, {})...", StringCast<ANSICHAR>(*ServerIpAddress).Get(), ServerPort, MaxClients);
+            SPACEMMA_CATEGORY_DEBUG(Gameplay, "Initializing server ({}, {}, {})...", StringCast<ANSICHAR>(*ServerIpAddress).Get(), ServerPort, MaxClients);
             AGameServer* server = GetWorld()->SpawnActor<AGameServer>(ServerBP, FVector{}, FRotator{}, FActorSpawnParameters{});
             APlayerController* playerController = UGameplayStatics::GetPlayerController(GetWorld(), 0);
             APawn* defaultPawn = playerController->GetPawn();
@@ -48,7 +48,7 @@ void USpaceMMAInstance::Initialize()
         }
         break;
         default:
-            SPACEMMA_WARN("Unhandled level initialization mode.");
+            SPACEMMA_CATEGORY_WARN(Client, "Unhandled level initialization mode.");
             break;
     }
     Initialization = LevelInitialization::None;